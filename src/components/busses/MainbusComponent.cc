@@ -25,6 +25,9 @@
  *  SUCH DAMAGE.
  */
 
+#include <algorithm>
+#include <string.h>
+
 #include "components/MainbusComponent.h"
 #include "GXemul.h"
 
@@ -33,6 +36,7 @@ MainbusComponent::MainbusComponent()
 	: Component("mainbus", "mainbus")
 	, m_memoryMapFailed(false)
 	, m_memoryMapValid(false)
+	, m_lastHitIndex(0)
 	, m_currentAddressDataBus(NULL)
 {
 }
@@ -66,6 +70,7 @@ void MainbusComponent::FlushCachedStateForComponent()
 	m_memoryMap.clear();
 	m_memoryMapValid = false;
 	m_memoryMapFailed = false;
+	m_lastHitIndex = 0;
 
 	m_currentAddressDataBus = NULL;
 	
@@ -108,6 +113,7 @@ bool MainbusComponent::MakeSureMemoryMapExists(GXemul* gxemul)
 
 		MemoryMapEntry mmEntry;
 		mmEntry.addressDataBus = bus;
+		mmEntry.component = children[i];
 		mmEntry.addrMul = 1;
 		mmEntry.base = 0;
 
@@ -137,41 +143,70 @@ bool MainbusComponent::MakeSureMemoryMapExists(GXemul* gxemul)
 		if (mmEntry.size == 0)
 			continue;
 
-		// Check for overlaps against the already existing mappings.
-		//
-		// (Note: Current implementation results in O(n^2) time,
-		// but if the number of memory-mapped immediate childs are
-		// few, then this should not be a big problem.)
-		for (size_t j=0; j<m_memoryMap.size(); ++j) {
-			if (mmEntry.base+mmEntry.size <= m_memoryMap[j].base)
-				continue;
-
-			if (mmEntry.base >= m_memoryMap[j].base +
-			    m_memoryMap[j].size)
-				continue;
-		
-			// There is overlap!
-			if (gxemul != NULL)
-				gxemul->GetUI()->ShowDebugMessage(this,
-				    "Error: the base and/or size of " +
-				    children[i]->GenerateShortestPossiblePath() +
-				    " conflicts with another memory mapped "
-				    "component on this bus.\n");
-
-			m_memoryMap.clear();
-			m_memoryMapValid = false;
-			m_memoryMapFailed = true;
-			return false;
-		}
-
-		// Finally add the new mapping entry.
 		m_memoryMap.push_back(mmEntry);
 	}
 
+	// Sort the entries by base address. Overlaps can then be found by
+	// only comparing each entry with the next one.
+	std::sort(m_memoryMap.begin(), m_memoryMap.end());
+
+	for (size_t i=1; i<m_memoryMap.size(); ++i) {
+		if (m_memoryMap[i-1].base + m_memoryMap[i-1].size <=
+		    m_memoryMap[i].base)
+			continue;
+
+		// There is overlap!
+		if (gxemul != NULL)
+			gxemul->GetUI()->ShowDebugMessage(this,
+			    "Error: the base and/or size of " +
+			    m_memoryMap[i].component->
+				GenerateShortestPossiblePath() +
+			    " conflicts with another memory mapped "
+			    "component on this bus (" +
+			    m_memoryMap[i-1].component->
+				GenerateShortestPossiblePath() + ").\n");
+
+		m_memoryMap.clear();
+		m_memoryMapValid = false;
+		m_memoryMapFailed = true;
+		return false;
+	}
+
 	return true;
 }
 
 
+const MainbusComponent::MemoryMapEntry* MainbusComponent::FindMemoryMapEntry(
+	uint64_t address)
+{
+	if (m_memoryMap.empty())
+		return NULL;
+
+	// Most accesses are to the same component as the previous one.
+	const MemoryMapEntry* mmEntry = &m_memoryMap[m_lastHitIndex];
+	if (address >= mmEntry->base && address < mmEntry->base + mmEntry->size)
+		return mmEntry;
+
+	// Binary search for the last entry with base <= address:
+	size_t lo = 0, hi = m_memoryMap.size();
+	while (hi - lo > 1) {
+		size_t mid = (lo + hi) / 2;
+		if (m_memoryMap[mid].base <= address)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	mmEntry = &m_memoryMap[lo];
+	if (address >= mmEntry->base && address < mmEntry->base + mmEntry->size) {
+		m_lastHitIndex = lo;
+		return mmEntry;
+	}
+
+	return NULL;
+}
+
+
 AddressDataBus* MainbusComponent::AsAddressDataBus()
 {
 	return this;
@@ -187,27 +222,14 @@ void MainbusComponent::AddressSelect(uint64_t address)
 	if (!m_memoryMapValid)
 		return;
 
-	// Note: This is a linear O(n) scan of the list of memory-mapped
-	// components. For small n, this should be ok.
-	//
-	// In practice, my hope is that the bulk of all memory access will be
-	// using direct-mapped pages anyway, so this should not be that much
-	// of a problem.
-
-	for (size_t i=0; i<m_memoryMap.size(); ++i) {
-		MemoryMapEntry& mmEntry = m_memoryMap[i];
-
-		// If this memory map entry contains the address we wish to
-		// select, then...
-		if (address >= mmEntry.base &&
-		    address < mmEntry.base + mmEntry.size) {
-			// ... tell the corresponding component which address
-			// within it we wish to select.
-			m_currentAddressDataBus = mmEntry.addressDataBus;
-			m_currentAddressDataBus->AddressSelect(
-			    (address - mmEntry.base) / mmEntry.addrMul);
-			break;
-		}
+	// If a memory map entry contains the address we wish to select, then
+	// tell the corresponding component which address within it we wish
+	// to select.
+	const MemoryMapEntry* mmEntry = FindMemoryMapEntry(address);
+	if (mmEntry != NULL) {
+		m_currentAddressDataBus = mmEntry->addressDataBus;
+		m_currentAddressDataBus->AddressSelect(
+		    (address - mmEntry->base) / mmEntry->addrMul);
 	}
 }
 
@@ -308,6 +330,88 @@ bool MainbusComponent::WriteData(const uint64_t& data, Endianness endianness)
 }
 
 
+bool MainbusComponent::ReadBlock(uint64_t address, uint8_t* data, size_t len)
+{
+	if (!MakeSureMemoryMapExists())
+		return false;
+
+	while (len > 0) {
+		const MemoryMapEntry* mmEntry = FindMemoryMapEntry(address);
+		if (mmEntry == NULL)
+			return false;
+
+		size_t chunk = len;
+		if (address + chunk > mmEntry->base + mmEntry->size)
+			chunk = mmEntry->base + mmEntry->size - address;
+
+		// Components with an address multiplier are accessed one
+		// byte at a time.
+		bool ok = mmEntry->addrMul == 1?
+		    mmEntry->addressDataBus->ReadBlock(
+			address - mmEntry->base, data, chunk) :
+		    AddressDataBus::ReadBlock(address, data, chunk);
+		if (!ok)
+			return false;
+
+		address += chunk;
+		data += chunk;
+		len -= chunk;
+	}
+
+	return true;
+}
+
+
+bool MainbusComponent::WriteBlock(uint64_t address, const uint8_t* data,
+	size_t len)
+{
+	if (!MakeSureMemoryMapExists())
+		return false;
+
+	while (len > 0) {
+		const MemoryMapEntry* mmEntry = FindMemoryMapEntry(address);
+		if (mmEntry == NULL)
+			return false;
+
+		size_t chunk = len;
+		if (address + chunk > mmEntry->base + mmEntry->size)
+			chunk = mmEntry->base + mmEntry->size - address;
+
+		bool ok = mmEntry->addrMul == 1?
+		    mmEntry->addressDataBus->WriteBlock(
+			address - mmEntry->base, data, chunk) :
+		    AddressDataBus::WriteBlock(address, data, chunk);
+		if (!ok)
+			return false;
+
+		address += chunk;
+		data += chunk;
+		len -= chunk;
+	}
+
+	return true;
+}
+
+
+uint8_t* MainbusComponent::LookupHostPage(uint64_t address, size_t pageSize,
+	bool forWriting, const uint64_t*& generation)
+{
+	if (!MakeSureMemoryMapExists())
+		return NULL;
+
+	const MemoryMapEntry* mmEntry = FindMemoryMapEntry(address);
+
+	// Only pages which are entirely within one component, with a 1:1
+	// address mapping, may be accessed directly.
+	if (mmEntry == NULL || mmEntry->addrMul != 1 ||
+	    address + pageSize > mmEntry->base + mmEntry->size)
+		return NULL;
+
+	return mmEntry->addressDataBus->LookupHostPage(
+	    address - mmEntry->base, pageSize, forWriting, generation);
+}
+
+
 /*****************************************************************************/
 
 
@@ -444,6 +548,113 @@ static void Test_MainbusComponent_Multiple_NonOverlapping()
 	}
 }
 
+static void Test_MainbusComponent_Multiple_Unsorted()
+{
+	refcount_ptr<Component> mainbus =
+	    ComponentFactory::CreateComponent("mainbus");
+	refcount_ptr<Component> ram0 =
+	    ComponentFactory::CreateComponent("ram");
+	refcount_ptr<Component> ram1 =
+	    ComponentFactory::CreateComponent("ram");
+	refcount_ptr<Component> ram2 =
+	    ComponentFactory::CreateComponent("ram");
+
+	// Children are added in a different order than their addresses,
+	// and with a hole between ram1 and ram0:
+	mainbus->AddChild(ram0);
+	mainbus->AddChild(ram1);
+	mainbus->AddChild(ram2);
+	ram0->SetVariableValue("memoryMappedSize", "0x100");
+	ram0->SetVariableValue("memoryMappedBase", "0x300");
+	ram1->SetVariableValue("memoryMappedSize", "0x100");
+	ram1->SetVariableValue("memoryMappedBase", "0x100");
+	ram2->SetVariableValue("memoryMappedSize", "0x100");
+	ram2->SetVariableValue("memoryMappedBase", "0x000");
+
+	AddressDataBus* bus = mainbus->AsAddressDataBus();
+
+	uint8_t data = 1;
+	bus->AddressSelect(0x310);
+	UnitTest::Assert("write to ram0 should succeed", bus->WriteData(data));
+	data = 2;
+	bus->AddressSelect(0x110);
+	UnitTest::Assert("write to ram1 should succeed", bus->WriteData(data));
+	data = 3;
+	bus->AddressSelect(0x010);
+	UnitTest::Assert("write to ram2 should succeed", bus->WriteData(data));
+	bus->AddressSelect(0x210);
+	UnitTest::Assert("write to the hole should fail",
+	    bus->WriteData(data) == false);
+	bus->AddressSelect(0x400);
+	UnitTest::Assert("write after the last entry should fail",
+	    bus->WriteData(data) == false);
+
+	AddressDataBus* ram0bus = ram0->AsAddressDataBus();
+	ram0bus->AddressSelect(0x10);
+	ram0bus->ReadData(data);
+	UnitTest::Assert("ram0 mismatch", data, 1);
+
+	AddressDataBus* ram1bus = ram1->AsAddressDataBus();
+	ram1bus->AddressSelect(0x10);
+	ram1bus->ReadData(data);
+	UnitTest::Assert("ram1 mismatch", data, 2);
+
+	AddressDataBus* ram2bus = ram2->AsAddressDataBus();
+	ram2bus->AddressSelect(0x10);
+	ram2bus->ReadData(data);
+	UnitTest::Assert("ram2 mismatch", data, 3);
+}
+
+static void Test_MainbusComponent_Blocks()
+{
+	refcount_ptr<Component> mainbus =
+	    ComponentFactory::CreateComponent("mainbus");
+	refcount_ptr<Component> ram0 =
+	    ComponentFactory::CreateComponent("ram");
+	refcount_ptr<Component> ram1 =
+	    ComponentFactory::CreateComponent("ram");
+
+	mainbus->AddChild(ram0);
+	mainbus->AddChild(ram1);
+	ram0->SetVariableValue("memoryMappedSize", "0x100");
+	ram0->SetVariableValue("memoryMappedBase", "0x000");
+	ram1->SetVariableValue("memoryMappedSize", "0x100");
+	ram1->SetVariableValue("memoryMappedBase", "0x100");
+	ram1->SetVariableValue("memoryMappedAddrMul", "2");
+
+	AddressDataBus* bus = mainbus->AsAddressDataBus();
+
+	uint8_t buf[32];
+	for (size_t i=0; i<sizeof(buf); ++i)
+		buf[i] = i + 1;
+
+	UnitTest::Assert("block write spanning two components "
+	    "should succeed", bus->WriteBlock(0xf0, buf, sizeof(buf)));
+
+	uint8_t data;
+	AddressDataBus* ram0bus = ram0->AsAddressDataBus();
+	ram0bus->AddressSelect(0xf0);
+	ram0bus->ReadData(data);
+	UnitTest::Assert("ram0 mismatch", data, 1);
+
+	AddressDataBus* ram1bus = ram1->AsAddressDataBus();
+	ram1bus->AddressSelect(0x1);
+	ram1bus->ReadData(data);
+	UnitTest::Assert("ram1 should have been written with addrMul 2",
+	    data, 20);
+
+	uint8_t buf2[32];
+	UnitTest::Assert("block read should succeed",
+	    bus->ReadBlock(0xf0, buf2, sizeof(buf2)));
+	UnitTest::Assert("block read mismatch (ram0)",
+	    memcmp(buf, buf2, 16) == 0);
+	UnitTest::Assert("block read mismatch (ram1)",
+	    buf2[16] == 18 && buf2[17] == 18 && buf2[18] == 20);
+
+	UnitTest::Assert("block write outside of mapped space should fail",
+	    bus->WriteBlock(0x1f0, buf, sizeof(buf)) == false);
+}
+
 static void Test_MainbusComponent_Simple_With_AddrMul()
 {
 	refcount_ptr<Component> mainbus =
@@ -551,6 +762,8 @@ UNITTESTS(MainbusComponent)
 	UNITTEST(Test_MainbusComponent_Simple);
 	UNITTEST(Test_MainbusComponent_Remapping);
 	UNITTEST(Test_MainbusComponent_Multiple_NonOverlapping);
+	UNITTEST(Test_MainbusComponent_Multiple_Unsorted);
+	UNITTEST(Test_MainbusComponent_Blocks);
 	UNITTEST(Test_MainbusComponent_Simple_With_AddrMul);
 
 	// TODO: Write outside of mapped space
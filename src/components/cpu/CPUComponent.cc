@@ -52,6 +52,8 @@ CPUComponent::CPUComponent(const string& className, const string& cpuArchitectur
 	, m_nrOfTracedFunctionCalls(0)
 	, m_addressDataBus(NULL)
 {
+	InvalidateHostPages();
+
 	AddVariable("architecture", &m_cpuArchitecture);
 	AddVariable("pc", &m_pc);
 	AddVariable("lastDumpAddr", &m_lastDumpAddr);
@@ -434,6 +436,7 @@ AddressDataBus * CPUComponent::AsAddressDataBus()
 void CPUComponent::FlushCachedStateForComponent()
 {
 	m_addressDataBus = NULL;
+	InvalidateHostPages();
 
 	Component::FlushCachedStateForComponent();
 }
@@ -502,6 +505,68 @@ bool CPUComponent::LookupAddressDataBus(GXemul* gxemul)
 }
 
 
+// Generation counter for host page entries which are not in use.
+static const uint64_t unusedHostPageGeneration = 0;
+
+
+void CPUComponent::InvalidateHostPages()
+{
+	for (size_t i=0; i<N_HOST_PAGES; ++i) {
+		// Not page aligned, so it never matches a lookup.
+		m_hostPages[i].vaddr = (uint64_t) -1;
+		m_hostPages[i].hostLoad = NULL;
+		m_hostPages[i].hostStore = NULL;
+		m_hostPages[i].generation = &unusedHostPageGeneration;
+		m_hostPages[i].generationValue = 0;
+	}
+}
+
+
+uint8_t* CPUComponent::LookupHostPointerSlow(uint64_t vaddr, bool forWriting)
+{
+	const uint64_t offset = vaddr & (HOST_PAGE_SIZE - 1);
+	uint64_t paddr;
+	bool writable;
+
+	if (!LookupAddressDataBus() ||
+	    !VirtualToPhysical(vaddr - offset, paddr, writable))
+		return NULL;
+
+	if (forWriting && !writable)
+		return NULL;
+
+	paddr &= ~(uint64_t)(HOST_PAGE_SIZE - 1);
+
+	// Loads only ask for a read-only page. (Asking for a writable page
+	// would e.g. allocate RAM which has never been written to.)
+	const uint64_t* generation = &unusedHostPageGeneration;
+	uint8_t* host = m_addressDataBus->LookupHostPage(paddr,
+	    HOST_PAGE_SIZE, forWriting, generation);
+	if (host == NULL)
+		return NULL;
+
+	HostPageEntry& entry = m_hostPages[(vaddr >> HOST_PAGE_SHIFT)
+	    & (N_HOST_PAGES - 1)];
+	if (entry.vaddr != vaddr - offset ||
+	    entry.generation != generation ||
+	    *entry.generation != entry.generationValue) {
+		entry.vaddr = vaddr - offset;
+		entry.hostStore = NULL;
+	}
+
+	entry.generation = generation;
+	entry.generationValue = *generation;
+
+	// A page which was looked up for writing may also be read from, but
+	// a read-only page may not be written to.
+	entry.hostLoad = host;
+	if (forWriting)
+		entry.hostStore = host;
+
+	return host + offset;
+}
+
+
 void CPUComponent::ShowRegisters(GXemul* gxemul, const vector<string>& arguments) const
 {
 	gxemul->GetUI()->ShowDebugMessage("The registers method has not yet "
@@ -639,6 +704,58 @@ bool CPUComponent::WriteData(const uint64_t& data, Endianness endianness)
 }
 
 
+bool CPUComponent::ReadBlock(uint64_t address, uint8_t* data, size_t len)
+{
+	if (!LookupAddressDataBus())
+		return false;
+
+	// Translate one page at a time:
+	while (len > 0) {
+		size_t chunk = HOST_PAGE_SIZE - (address & (HOST_PAGE_SIZE-1));
+		if (chunk > len)
+			chunk = len;
+
+		uint64_t paddr;
+		bool writable;
+		if (!VirtualToPhysical(address, paddr, writable) ||
+		    !m_addressDataBus->ReadBlock(paddr, data, chunk))
+			return false;
+
+		address += chunk;
+		data += chunk;
+		len -= chunk;
+	}
+
+	return true;
+}
+
+
+bool CPUComponent::WriteBlock(uint64_t address, const uint8_t* data,
+	size_t len)
+{
+	if (!LookupAddressDataBus())
+		return false;
+
+	while (len > 0) {
+		size_t chunk = HOST_PAGE_SIZE - (address & (HOST_PAGE_SIZE-1));
+		if (chunk > len)
+			chunk = len;
+
+		uint64_t paddr;
+		bool writable;
+		if (!VirtualToPhysical(address, paddr, writable) ||
+		    !m_addressDataBus->WriteBlock(paddr, data, chunk))
+			return false;
+
+		address += chunk;
+		data += chunk;
+		len -= chunk;
+	}
+
+	return true;
+}
+
+
 /*****************************************************************************/
 
 
@@ -35,6 +35,7 @@
 
 CPUDyntransComponent::CPUDyntransComponent(const string& className, const string& cpuArchitecture)
 	: CPUComponent(className, cpuArchitecture)
+	, m_idling(false)
 {
 	m_abortIC.f = instr_abort;
 }
@@ -64,6 +65,47 @@ void CPUDyntransComponent::DyntransInit()
 }
 
 
+void CPUDyntransComponent::GetMethodNames(vector<string>& names) const
+{
+	// Add our method names...
+	names.push_back("translationcache");
+
+	// ... and make sure to call the base class implementation:
+	CPUComponent::GetMethodNames(names);
+}
+
+
+void CPUDyntransComponent::ExecuteMethod(GXemul* gxemul,
+	const string& methodName, const vector<string>& arguments)
+{
+	if (methodName == "translationcache") {
+		const DyntransTranslationCache::Statistics& stats =
+		    m_translationCache.GetStatistics();
+		uint64_t lookups = stats.hits + stats.misses;
+
+		stringstream ss;
+		ss << "translation cache lookups: " << lookups << "\n";
+		ss << "  hits:          " << stats.hits << "\n";
+		ss << "  misses:        " << stats.misses << "\n";
+		ss << "  probes:        " << stats.probes;
+		if (lookups > 0) {
+			ss.setf(std::ios::fixed);
+			ss.precision(2);
+			ss << " (" << (double) stats.probes / lookups
+			    << " per lookup)";
+		}
+		ss << "\n";
+		ss << "  longest probe: " << stats.longestProbe << "\n";
+
+		gxemul->GetUI()->ShowDebugMessage(ss.str());
+		return;
+	}
+
+	// ... and make sure to call the base class implementation:
+	CPUComponent::ExecuteMethod(gxemul, methodName, arguments);
+}
+
+
 /*
  * Dynamic translation core
  * ------------------------
@@ -121,6 +163,7 @@ int CPUDyntransComponent::Execute(GXemul* gxemul, int nrOfCycles)
 
 	m_nrOfCyclesToExecute = nrOfCycles;
 	m_executedCycles = 0;
+	m_idling = false;
 
 	// Starting inside a delay slot? Then execute it carefully:
 	if (m_inDelaySlot) {
@@ -132,14 +175,15 @@ int CPUDyntransComponent::Execute(GXemul* gxemul, int nrOfCycles)
 
 		// Fault in delay slot: return immediately.
 		if (m_nextIC->f == instr_abort) {
-			m_nextIC->f = GetDyntransToBeTranslated();
+			if (m_nextIC != &m_abortIC)
+				m_nextIC->f = GetDyntransToBeTranslated();
 			return 0;
 		}
 	}
 
 	// If possible, do some optimized loops of multiple inlined IC calls...
 	const int ICsPerLoop = 60;
-	const int maxICcycles = 2;	// TODO: Longer when instr combos are reimplemented
+	const int maxICcycles = DYNTRANS_MAX_IC_CYCLES;
 	if (nrOfCycles > ICsPerLoop * maxICcycles) {
 		int hazard = nrOfCycles - ICsPerLoop * maxICcycles;
 
@@ -170,6 +214,17 @@ int CPUDyntransComponent::Execute(GXemul* gxemul, int nrOfCycles)
 			break;
 	}
 
+	// Spinning in an idle loop? Then the rest of the run consists of laps
+	// of the same two instructions, which don't change any state. All
+	// whole laps are counted as executed, and if there is an odd cycle
+	// left, the second instruction of the loop is executed below.
+	if (m_idling) {
+		m_idling = false;
+		m_executedCycles += (nrOfCycles - m_executedCycles) & ~1;
+		m_nextIC = NULL;
+		DyntransPCtoPointers();
+	}
+
 	// If there's one instruction left (and we're not aborted), then
 	// let's execute it:
 	if (m_executedCycles<nrOfCycles && m_nextIC->f != instr_abort) {
@@ -182,7 +237,7 @@ int CPUDyntransComponent::Execute(GXemul* gxemul, int nrOfCycles)
 
 	// If execution aborted, then reset the aborting instruction slot
 	// to the to-be-translated function:
-	if (m_nextIC->f == instr_abort)
+	if (m_nextIC->f == instr_abort && m_nextIC != &m_abortIC)
 		m_nextIC->f = GetDyntransToBeTranslated();
 
 	return m_executedCycles;
@@ -401,11 +456,17 @@ void CPUDyntransComponent::DyntransToBeTranslatedDone(struct DyntransIC* ic)
 			ic->f = instr_abort;
 	}
 
-	// Finally, execute the translated instruction.
 	bool ds = m_inDelaySlot;
 	bool dsExceptionOrAbort = m_exceptionOrAbortInDelaySlot;
 	bool singleInstructionLeft = m_executedCycles == m_nrOfCyclesToExecute - 1;
 
+	// Instructions translated for a single instruction are reset to
+	// to-be-translated afterwards, so they are not combined.
+	if (!abort && !singleInstructionLeft)
+		DyntransCombineInstructions(ic);
+
+	// Finally, execute the translated instruction.
+
 	m_nextIC = ic + 1;
 	ic->f(this, ic);
 
@@ -430,6 +491,35 @@ void CPUDyntransComponent::DyntransToBeTranslatedDone(struct DyntransIC* ic)
 }
 
 
+void CPUDyntransComponent::DyntransCombineInstructions(struct DyntransIC* ic)
+{
+	// Runs of nops: Let each preceding nop in the run skip all the way
+	// to this one.
+	if (ic->f == instr_nop) {
+		for (int n=2; n<=DYNTRANS_MAX_IC_CYCLES; ++n) {
+			struct DyntransIC* first = ic - (n-1);
+			if (first < m_firstIConPage ||
+			    (first->f != instr_nop && first->f != instr_multi_nop))
+				break;
+
+			first->f = instr_multi_nop;
+			first->arg[0].u32 = n;
+		}
+	}
+}
+
+
+void CPUDyntransComponent::DyntransIdle()
+{
+	DyntransResyncPC();
+
+	m_idling = true;
+
+	// Abort, to get out of the main loop:
+	m_nextIC = &m_abortIC;
+}
+
+
 /*****************************************************************************/
 
 
@@ -441,6 +531,25 @@ DYNTRANS_INSTR(CPUDyntransComponent,nop)
 }
 
 
+/*
+ * A run of nops.
+ *
+ * arg[0] = the number of nops in the run, including this one
+ */
+DYNTRANS_INSTR(CPUDyntransComponent,multi_nop)
+{
+	int n = ic->arg[0].u32;
+
+	// In a delay slot, or too few cycles left? Then this is a single nop.
+	if (cpubase->m_inDelaySlot ||
+	    cpubase->m_executedCycles + n > cpubase->m_nrOfCyclesToExecute)
+		return;
+
+	cpubase->m_nextIC = ic + n;
+	cpubase->m_executedCycles += n - 1;
+}
+
+
 /*
  * A break-out-of-dyntrans function. Setting ic->f to this function will
  * cause dyntrans execution to be aborted. The cycle counter will _not_
@@ -789,9 +898,101 @@ static void Test_CPUDyntransComponent_Dyntrans_PreReq()
 	UnitTest::Assert("nr of dyntrans args too few", N_DYNTRANS_IC_ARGS >= 3);
 }
 
+static void Test_CPUDyntransComponent_TranslationCache_HighAddresses()
+{
+	CPUDyntransComponent::DyntransTranslationCache cache;
+	cache.Reinit(16 * (sizeof(struct DyntransIC) * 4 + 64), 4, 12);
+
+	// Pages which would alias in a table indexed by the low bits of the
+	// page number must still be kept apart:
+	uint64_t addrs[4] = { 0x1000, 0x40001000, 0x900000001fc01000ULL,
+	    0xffffffff80001000ULL };
+	struct DyntransIC* pages[4];
+
+	bool clear;
+	for (int i=0; i<4; ++i) {
+		pages[i] = cache.GetICPage(addrs[i], false, clear);
+		UnitTest::Assert("first lookup should be a miss", clear);
+	}
+
+	for (int i=0; i<4; ++i) {
+		UnitTest::Assert("second lookup should give the same page",
+		    cache.GetICPage(addrs[i] + 0x123, false, clear) == pages[i]);
+		UnitTest::Assert("second lookup should be a hit", !clear);
+	}
+
+	const CPUDyntransComponent::DyntransTranslationCache::Statistics&
+	    stats = cache.GetStatistics();
+	UnitTest::Assert("hits", stats.hits, 4);
+	UnitTest::Assert("misses", stats.misses, 4);
+	UnitTest::Assert("probes", stats.probes >= 8);
+}
+
+static void Test_CPUDyntransComponent_TranslationCache_LRU()
+{
+	const size_t nrOfPages = 16;
+	CPUDyntransComponent::DyntransTranslationCache cache;
+	cache.Reinit(nrOfPages * (sizeof(struct DyntransIC) * 4 + 64), 4, 12);
+
+	// Compare with a simple least-recently-used list, for a pseudo-random
+	// sequence of pages, so that pages are evicted from the hash table
+	// in all kinds of orders.
+	list<uint64_t> lru;
+	uint32_t x = 1;
+	for (int i=0; i<20000; ++i) {
+		x = x * 1103515245 + 12345;
+		uint64_t addr = ((uint64_t) ((x >> 16) % 40) << 32) |
+		    ((x >> 8) & 0x3000);
+
+		bool inModel = false;
+		for (list<uint64_t>::iterator it = lru.begin(); it != lru.end(); ++it)
+			if (*it == addr) {
+				lru.erase(it);
+				inModel = true;
+				break;
+			}
+
+		lru.push_front(addr);
+		if (lru.size() > nrOfPages)
+			lru.pop_back();
+
+		bool clear;
+		cache.GetICPage(addr, false, clear);
+		UnitTest::Assert("cache and model disagree", clear, !inModel);
+	}
+
+	const CPUDyntransComponent::DyntransTranslationCache::Statistics&
+	    stats = cache.GetStatistics();
+	UnitTest::Assert("hits + misses", stats.hits + stats.misses, 20000);
+	UnitTest::Assert("probe sequences should be short",
+	    stats.longestProbe <= nrOfPages);
+}
+
+static void Test_CPUDyntransComponent_Methods()
+{
+	refcount_ptr<Component> cpu =
+	    ComponentFactory::CreateComponent("mips_cpu");
+
+	vector<string> names;
+	cpu->GetMethodNames(names);
+
+	bool found = false;
+	for (size_t i=0; i<names.size(); ++i)
+		if (names[i] == "translationcache")
+			found = true;
+
+	UnitTest::Assert("translationcache method missing", found);
+	UnitTest::Assert("translationcache method should NOT be re-executable"
+	    " without args",
+	    cpu->MethodMayBeReexecutedWithoutArgs("translationcache") == false);
+}
+
 UNITTESTS(CPUDyntransComponent)
 {
 	UNITTEST(Test_CPUDyntransComponent_Dyntrans_PreReq);
+	UNITTEST(Test_CPUDyntransComponent_TranslationCache_HighAddresses);
+	UNITTEST(Test_CPUDyntransComponent_TranslationCache_LRU);
+	UNITTEST(Test_CPUDyntransComponent_Methods);
 }
 
 #endif
@@ -1648,7 +1648,6 @@ template<bool store, typename T, bool doubleword, bool regofs, bool scaled, bool
 {
 	DYNTRANS_INSTR_HEAD(M88K_CPUComponent)
 
-	// TODO: fast lookups
 	// TODO: usr access
 
 	// TODO: place in M88K's "ongoing memory transaction" registers!
@@ -1663,6 +1662,37 @@ template<bool store, typename T, bool doubleword, bool regofs, bool scaled, bool
 		return;
 	}
 
+	// Fast path: direct access to host memory. (Double-word accesses
+	// which cross a page boundary take the slow path.)
+	T* hostPtr = NULL;
+	if (!doubleword || (addr & (HOST_PAGE_SIZE-1)) <= HOST_PAGE_SIZE - 8)
+		hostPtr = (T*) cpu->LookupHostPointer(addr, store);
+
+	if (hostPtr != NULL) {
+		uint32_t* reg = (uint32_t*) ic->arg[0].p;
+
+		if (store) {
+			*hostPtr = cpu->GuestToHost((T)reg[0]);
+			if (doubleword)
+				((uint32_t*)hostPtr)[1] = cpu->GuestToHost(reg[1]);
+		} else {
+			T data = cpu->GuestToHost(*hostPtr);
+
+			if (signedLoad) {
+				if (sizeof(T) == sizeof(uint16_t))
+					data = (int16_t)data;
+				if (sizeof(T) == sizeof(uint8_t))
+					data = (int8_t)data;
+			}
+
+			reg[0] = data;
+			if (doubleword)
+				reg[1] = cpu->GuestToHost(((uint32_t*)hostPtr)[1]);
+		}
+
+		return;
+	}
+
 	cpu->AddressSelect(addr);
 
 	if (store) {
@@ -1707,6 +1737,47 @@ template<bool store, typename T, bool doubleword, bool regofs, bool scaled, bool
 }
 
 
+/*
+ *  idle:  An idle loop, e.g. in the scheduler:
+ *
+ *	s:	ld	rX,rY,ofs
+ *		bcnd	eq0,rX,s
+ *
+ *  Same arguments as ld. (rX is not rY, so the loaded word stays the same
+ *  during the rest of the run, since nothing else can write to memory.)
+ */
+DYNTRANS_INSTR(M88K_CPUComponent,idle)
+{
+	DYNTRANS_INSTR_HEAD(M88K_CPUComponent)
+
+	uint32_t addr = REG32(ic->arg[1]) + ic->arg[2].u32;
+
+	uint32_t* hostPtr = NULL;
+	if (!cpu->m_inDelaySlot && (addr & (sizeof(uint32_t)-1)) == 0)
+		hostPtr = (uint32_t*) cpu->LookupHostPointer(addr, false);
+
+	// Not direct access to host memory, or in a delay slot? Then this
+	// is just an ld.
+	if (hostPtr == NULL) {
+		instr_loadstore<false, uint32_t, false, false, false, false>(cpu, ic);
+		return;
+	}
+
+	uint32_t data = cpu->GuestToHost(*hostPtr);
+	REG32(ic->arg[0]) = data;
+
+	if (data != 0) {
+		// The bcnd is not taken.
+		cpu->m_nextIC = ic + 2;
+		cpu->m_executedCycles ++;
+		return;
+	}
+
+	cpu->m_nextIC = ic + 1;
+	cpu->DyntransIdle();
+}
+
+
 /*****************************************************************************/
 
 
@@ -2463,6 +2534,24 @@ void M88K_CPUComponent::Translate(uint32_t iw, struct DyntransIC* ic)
 }
 
 
+void M88K_CPUComponent::DyntransCombineInstructions(struct DyntransIC* ic)
+{
+	CPUDyntransComponent::DyntransCombineInstructions(ic);
+
+	// Idle loop:
+	//
+	//	s:	ld	rX,rY,ofs
+	//		bcnd	eq0,rX,s
+	if (ic > m_firstIConPage &&
+	    ic[0].f == instr_bcnd<false,2,false> &&
+	    ic[0].arg[2].u32 == (uint32_t)((ic - 1 - m_firstIConPage) << M88K_INSTR_ALIGNMENT_SHIFT) &&
+	    ic[-1].f == instr_loadstore<false, uint32_t, false, false, false, false> &&
+	    ic[-1].arg[0].p == ic[0].arg[0].p &&
+	    ic[-1].arg[1].p != ic[-1].arg[0].p)
+		ic[-1].f = instr_idle;
+}
+
+
 DYNTRANS_INSTR(M88K_CPUComponent,ToBeTranslated)
 {
 	DYNTRANS_INSTR_HEAD(M88K_CPUComponent)
@@ -2865,6 +2954,62 @@ static void Test_M88K_CPUComponent_Execute_EarlyAbortDuringRuntime_Running()
 	UnitTest::Assert("delay target should not have been updated", cpu->GetVariable("delaySlotTarget")->ToInteger(), 0x1040);
 }
 
+static void Test_M88K_CPUComponent_Execute_IdleLoop()
+{
+	GXemul gxemul;
+	gxemul.GetCommandInterpreter().RunCommand("add testm88k");
+
+	refcount_ptr<Component> cpu = gxemul.GetRootComponent()->LookupPath("root.machine0.mainbus0.cpu0");
+	UnitTest::Assert("huh? no cpu?", !cpu.IsNULL());
+
+	AddressDataBus* bus = cpu->AsAddressDataBus();
+	UnitTest::Assert("cpu should be addressable", bus != NULL);
+
+	uint32_t data32 = 0x15a02000;	// ld r13,r0,0x2000
+	bus->AddressSelect(0x1000ULL);
+	bus->WriteData(data32, BigEndian);
+
+	data32 = 0xe84dffff;	// bcnd eq0,r13,0x1000
+	bus->AddressSelect(0x1004ULL);
+	bus->WriteData(data32, BigEndian);
+
+	data32 = 0x63df0010;	// addu r30,r31,0x10
+	bus->AddressSelect(0x1008ULL);
+	bus->WriteData(data32, BigEndian);
+
+	data32 = 0;
+	bus->AddressSelect(0x2000ULL);
+	bus->WriteData(data32, BigEndian);
+
+	cpu->SetVariableValue("pc", "0x1000");
+	cpu->SetVariableValue("r13", "42");
+
+	// An odd number of steps ends at the bcnd, an even number at the ld.
+	gxemul.SetRunState(GXemul::Running);
+	gxemul.Execute(1001);
+
+	UnitTest::Assert("steps", cpu->GetVariable("step")->ToInteger(), 1001);
+	UnitTest::Assert("pc", cpu->GetVariable("pc")->ToInteger(), 0x1004);
+	UnitTest::Assert("r13", cpu->GetVariable("r13")->ToInteger(), 0);
+
+	gxemul.Execute(1001);
+
+	UnitTest::Assert("steps after second run", cpu->GetVariable("step")->ToInteger(), 2002);
+	UnitTest::Assert("pc after second run", cpu->GetVariable("pc")->ToInteger(), 0x1000);
+
+	// Leave the idle loop: bcnd is not taken once the word is non-zero.
+	data32 = 5;
+	bus->AddressSelect(0x2000ULL);
+	bus->WriteData(data32, BigEndian);
+
+	gxemul.Execute(3);
+
+	UnitTest::Assert("steps after third run", cpu->GetVariable("step")->ToInteger(), 2005);
+	UnitTest::Assert("pc after third run", cpu->GetVariable("pc")->ToInteger(), 0x100c);
+	UnitTest::Assert("r13 after third run", cpu->GetVariable("r13")->ToInteger(), 5);
+	UnitTest::Assert("r30 after third run", cpu->GetVariable("r30")->ToInteger(), 0xff0 + 0x10);
+}
+
 UNITTESTS(M88K_CPUComponent)
 {
 	UNITTEST(Test_M88K_CPUComponent_IsStable);
@@ -2884,6 +3029,7 @@ UNITTESTS(M88K_CPUComponent)
 	UNITTEST(Test_M88K_CPUComponent_Execute_DelayBranchWithFault);
 	UNITTEST(Test_M88K_CPUComponent_Execute_EarlyAbortDuringRuntime_Singlestep);
 	UNITTEST(Test_M88K_CPUComponent_Execute_EarlyAbortDuringRuntime_Running);
+	UNITTEST(Test_M88K_CPUComponent_Execute_IdleLoop);
 //	UNITTEST(Test_M88K_CPUComponent_Execute_LateAbortDuringRuntime);
 }
 
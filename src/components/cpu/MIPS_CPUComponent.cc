@@ -1150,8 +1150,6 @@ template<bool store, typename addressType, typename T, bool signedLoad> void MIP
 {
 	DYNTRANS_INSTR_HEAD(MIPS_CPUComponent)
 
-	// TODO: fast lookups
-
 	uint64_t addr;
 
 	if (sizeof(addressType) == sizeof(uint64_t))
@@ -1167,6 +1165,28 @@ template<bool store, typename addressType, typename T, bool signedLoad> void MIP
 		return;
 	}
 
+	// Fast path: direct access to host memory.
+	T* hostPtr = (T*) cpu->LookupHostPointer(addr, store);
+	if (hostPtr != NULL) {
+		if (store) {
+			*hostPtr = cpu->GuestToHost((T)REG64(ic->arg[0]));
+		} else {
+			T data = cpu->GuestToHost(*hostPtr);
+			if (signedLoad) {
+				if (sizeof(T) == sizeof(uint32_t))
+					REG64(ic->arg[0]) = (int32_t)data;
+				if (sizeof(T) == sizeof(uint16_t))
+					REG64(ic->arg[0]) = (int16_t)data;
+				if (sizeof(T) == sizeof(uint8_t))
+					REG64(ic->arg[0]) = (int8_t)data;
+			} else {
+				REG64(ic->arg[0]) = data;
+			}
+		}
+
+		return;
+	}
+
 	cpu->AddressSelect(addr);
 
 	if (store) {
@@ -1194,6 +1214,60 @@ template<bool store, typename addressType, typename T, bool signedLoad> void MIP
 }
 
 
+/*
+ *  Multiple lw or sw in a row, using the same base register:
+ *
+ *	lw	r?,???(rX)
+ *	lw	r?,???(rX)
+ *	...
+ *
+ *  Each instruction call keeps its own arguments, as for a single lw or sw.
+ *  Only the last instruction of the combination may load into rX.
+ */
+template<bool store, typename addressType, int n> void MIPS_CPUComponent::instr_multi_loadstore(CPUDyntransComponent* cpubase, DyntransIC* ic)
+{
+	DYNTRANS_INSTR_HEAD(MIPS_CPUComponent)
+
+	// In a delay slot, or too few cycles left? Then execute just this one.
+	if (cpu->m_inDelaySlot ||
+	    cpu->m_executedCycles + n > cpu->m_nrOfCyclesToExecute) {
+		instr_loadstore<store, addressType, uint32_t, !store>(cpu, ic);
+		return;
+	}
+
+	for (int i=0; i<n; ++i) {
+		uint64_t addr;
+
+		if (sizeof(addressType) == sizeof(uint64_t))
+			addr = REG64(ic[i].arg[1]) + (int32_t)ic[i].arg[2].u32;
+		else
+			addr = (int32_t) (REG64(ic[i].arg[1]) + (int32_t)ic[i].arg[2].u32);
+
+		uint32_t* hostPtr = NULL;
+		if ((addr & (sizeof(uint32_t)-1)) == 0)
+			hostPtr = (uint32_t*) cpu->LookupHostPointer(addr, store);
+
+		// Not direct access to host memory: Let the usual implementation
+		// handle the rest of this instruction (the preceding ones have
+		// already been executed).
+		if (hostPtr == NULL) {
+			cpu->m_nextIC = ic + i + 1;
+			cpu->m_executedCycles += i;
+			instr_loadstore<store, addressType, uint32_t, !store>(cpu, ic + i);
+			return;
+		}
+
+		if (store)
+			*hostPtr = cpu->GuestToHost((uint32_t)REG64(ic[i].arg[0]));
+		else
+			REG64(ic[i].arg[0]) = (int32_t)cpu->GuestToHost(*hostPtr);
+	}
+
+	cpu->m_nextIC = ic + n;
+	cpu->m_executedCycles += n - 1;
+}
+
+
 /*****************************************************************************/
 
 
@@ -1739,6 +1813,66 @@ void MIPS_CPUComponent::Translate(uint32_t iword, struct DyntransIC* ic)
 }
 
 
+void MIPS_CPUComponent::DyntransCombineInstructions(struct DyntransIC* ic)
+{
+	CPUDyntransComponent::DyntransCombineInstructions(ic);
+
+	// Multiple lw or sw in a row, using the same base register. Each
+	// preceding lw or sw is combined with all following ones, up to this
+	// one. (Combinations of up to 4 instructions are implemented.)
+	static const DyntransIC_t multi[2][2][3] = {
+		{
+			{ instr_multi_loadstore<false, int32_t, 2>,
+			  instr_multi_loadstore<false, int32_t, 3>,
+			  instr_multi_loadstore<false, int32_t, 4> },
+			{ instr_multi_loadstore<false, uint64_t, 2>,
+			  instr_multi_loadstore<false, uint64_t, 3>,
+			  instr_multi_loadstore<false, uint64_t, 4> }
+		}, {
+			{ instr_multi_loadstore<true, int32_t, 2>,
+			  instr_multi_loadstore<true, int32_t, 3>,
+			  instr_multi_loadstore<true, int32_t, 4> },
+			{ instr_multi_loadstore<true, uint64_t, 2>,
+			  instr_multi_loadstore<true, uint64_t, 3>,
+			  instr_multi_loadstore<true, uint64_t, 4> }
+		}
+	};
+
+	int store, addr64;
+	if (ic->f == instr_loadstore<false, int32_t,  uint32_t, true>) {
+		store = 0; addr64 = 0;
+	} else if (ic->f == instr_loadstore<false, uint64_t, uint32_t, true>) {
+		store = 0; addr64 = 1;
+	} else if (ic->f == instr_loadstore<true,  int32_t,  uint32_t, false>) {
+		store = 1; addr64 = 0;
+	} else if (ic->f == instr_loadstore<true,  uint64_t, uint32_t, false>) {
+		store = 1; addr64 = 1;
+	} else {
+		return;
+	}
+
+	const DyntransIC_t* combined = multi[store][addr64];
+
+	for (int n=2; n<=4; ++n) {
+		struct DyntransIC* first = ic - (n-1);
+		if (first < m_firstIConPage)
+			break;
+
+		if (first->f != ic->f && first->f != combined[0] &&
+		    first->f != combined[1] && first->f != combined[2])
+			break;
+
+		// Same base register, and (for loads) no load into the base
+		// register before the last instruction:
+		if (first->arg[1].p != ic->arg[1].p ||
+		    (!store && first->arg[0].p == ic->arg[1].p))
+			break;
+
+		first->f = combined[n-2];
+	}
+}
+
+
 DYNTRANS_INSTR(MIPS_CPUComponent,ToBeTranslated)
 {
 	DYNTRANS_INSTR_HEAD(MIPS_CPUComponent)
@@ -2013,6 +2147,215 @@ static void Test_MIPS_CPUComponent_Execute_DelayBranchWithFault()
 	UnitTest::Assert("should still be in delay slot", cpu->GetVariable("inDelaySlot")->ToString(), "true");
 }
 
+static void Test_MIPS_CPUComponent_Execute_CombinedInstructions()
+{
+	GXemul gxemul;
+	gxemul.GetCommandInterpreter().RunCommand("add testmips");
+
+	refcount_ptr<Component> cpu = gxemul.GetRootComponent()->LookupPath("root.machine0.mainbus0.cpu0");
+	UnitTest::Assert("huh? no cpu?", !cpu.IsNULL());
+
+	AddressDataBus* bus = cpu->AsAddressDataBus();
+	UnitTest::Assert("cpu should be addressable", bus != NULL);
+
+	// A loop of 14 instructions, with runs of sw, lw, and nops:
+	uint32_t loop[14] = {
+		0x258c0001,	// addiu t4,t4,1
+		0xac8c0000,	// sw t4,0(a0)
+		0xac8c0004,	// sw t4,4(a0)
+		0xac8c0008,	// sw t4,8(a0)
+		0x8c8d0000,	// lw t5,0(a0)
+		0x8c8e0004,	// lw t6,4(a0)
+		0x8c8f0008,	// lw t7,8(a0)
+		0x00000000,	// nop
+		0x00000000,	// nop
+		0x00000000,	// nop
+		0x00000000,	// nop
+		0x00000000,	// nop
+		0x1000fff3,	// b 0xffffffff80004000
+		0x00000000	// nop
+	};
+
+	for (size_t i=0; i<sizeof(loop)/sizeof(loop[0]); ++i) {
+		bus->AddressSelect(0xffffffff80004000ULL + i * sizeof(uint32_t));
+		bus->WriteData(loop[i], BigEndian);
+	}
+
+	cpu->SetVariableValue("pc", "0xffffffff80004000");
+	cpu->SetVariableValue("a0", "0xffffffff80010000");
+
+	// 100 laps, and then the first 5 instructions of the next lap:
+	gxemul.SetRunState(GXemul::Running);
+	gxemul.Execute(14 * 100 + 5);
+
+	UnitTest::Assert("steps", cpu->GetVariable("step")->ToInteger(), 14 * 100 + 5);
+	UnitTest::Assert("pc", cpu->GetVariable("pc")->ToInteger(), 0xffffffff80004014ULL);
+	UnitTest::Assert("t4", cpu->GetVariable("t4")->ToInteger(), 101);
+	UnitTest::Assert("t5", cpu->GetVariable("t5")->ToInteger(), 101);
+	UnitTest::Assert("t6", cpu->GetVariable("t6")->ToInteger(), 100);
+	UnitTest::Assert("t7", cpu->GetVariable("t7")->ToInteger(), 100);
+
+	// Only 3 more instructions, which start in the middle of the lw run,
+	// and end in the middle of the nop run:
+	gxemul.Execute(3);
+
+	UnitTest::Assert("steps after second run", cpu->GetVariable("step")->ToInteger(), 14 * 100 + 8);
+	UnitTest::Assert("pc after second run", cpu->GetVariable("pc")->ToInteger(), 0xffffffff80004020ULL);
+	UnitTest::Assert("t6 after second run", cpu->GetVariable("t6")->ToInteger(), 101);
+	UnitTest::Assert("t7 after second run", cpu->GetVariable("t7")->ToInteger(), 101);
+}
+
+static void Test_MIPS_CPUComponent_Execute_CombinedInstructions_EndOfRAM()
+{
+	GXemul gxemul;
+	gxemul.GetCommandInterpreter().RunCommand("add testmips");
+
+	refcount_ptr<Component> cpu = gxemul.GetRootComponent()->LookupPath("root.machine0.mainbus0.cpu0");
+	UnitTest::Assert("huh? no cpu?", !cpu.IsNULL());
+
+	AddressDataBus* bus = cpu->AsAddressDataBus();
+	UnitTest::Assert("cpu should be addressable", bus != NULL);
+
+	// A loop with a run of sw, where the second one is just after the
+	// end of RAM (0x2000000), i.e. it has to take the usual path:
+	uint32_t loop[7] = {
+		0xac8c0000,	// sw t4,0(a0)
+		0xac8c0004,	// sw t4,4(a0)
+		0xac8cfffc,	// sw t4,-4(a0)
+		0xac8cfff8,	// sw t4,-8(a0)
+		0x258c0001,	// addiu t4,t4,1
+		0x1000fffa,	// b 0xffffffff80004000
+		0x00000000	// nop
+	};
+
+	for (size_t i=0; i<sizeof(loop)/sizeof(loop[0]); ++i) {
+		bus->AddressSelect(0xffffffff80004000ULL + i * sizeof(uint32_t));
+		bus->WriteData(loop[i], BigEndian);
+	}
+
+	cpu->SetVariableValue("pc", "0xffffffff80004000");
+	cpu->SetVariableValue("a0", "0xffffffff81fffffc");
+	cpu->SetVariableValue("t4", "0x12345678");
+
+	// 3 laps; the combination is used from the second lap on:
+	gxemul.SetRunState(GXemul::Running);
+	gxemul.Execute(7 * 3);
+
+	UnitTest::Assert("steps", cpu->GetVariable("step")->ToInteger(), 7 * 3);
+	UnitTest::Assert("pc", cpu->GetVariable("pc")->ToInteger(), 0xffffffff80004000ULL);
+	UnitTest::Assert("t4", cpu->GetVariable("t4")->ToInteger(), 0x1234567b);
+
+	for (int i=0; i<3; ++i) {
+		uint32_t data32 = 0;
+		bus->AddressSelect(0xffffffff81fffff4ULL + i * sizeof(uint32_t));
+		bus->ReadData(data32, BigEndian);
+		UnitTest::Assert("stored value", data32, 0x1234567a);
+	}
+}
+
+static void Test_MIPS_CPUComponent_Execute_LoadDoesNotAllocateRAM()
+{
+	GXemul gxemul;
+	gxemul.GetCommandInterpreter().RunCommand("add testmips");
+
+	refcount_ptr<Component> cpu = gxemul.GetRootComponent()->LookupPath("root.machine0.mainbus0.cpu0");
+	refcount_ptr<Component> ram = gxemul.GetRootComponent()->LookupPath("root.machine0.mainbus0.ram0");
+	UnitTest::Assert("huh? no cpu or ram?", !cpu.IsNULL() && !ram.IsNULL());
+
+	AddressDataBus* bus = cpu->AsAddressDataBus();
+	AddressDataBus* ramBus = ram->AsAddressDataBus();
+	const uint64_t* generation;
+
+	uint32_t program[3] = {
+		0x8c8d0000,	// lw t5,0(a0)
+		0xacac0000,	// sw t4,0(a1)
+		0x8cae0000	// lw t6,0(a1)
+	};
+
+	for (size_t i=0; i<sizeof(program)/sizeof(program[0]); ++i) {
+		bus->AddressSelect(0xffffffff80004000ULL + i * sizeof(uint32_t));
+		bus->WriteData(program[i], BigEndian);
+	}
+
+	// a0 and a1 point to RAM which has not been written to yet, in two
+	// other host memory blocks than the program.
+	cpu->SetVariableValue("pc", "0xffffffff80004000");
+	cpu->SetVariableValue("a0", "0xffffffff80812340");
+	cpu->SetVariableValue("a1", "0xffffffff80c12340");
+	cpu->SetVariableValue("t4", "0x1234");
+	cpu->SetVariableValue("t5", "99");
+
+	gxemul.SetRunState(GXemul::Running);
+	gxemul.Execute(1);
+
+	UnitTest::Assert("unwritten RAM should read as zero", cpu->GetVariable("t5")->ToInteger(), 0);
+	UnitTest::Assert("the load should not have allocated RAM",
+	    ramBus->LookupHostPage(0x812000, 0x1000, false, generation) == NULL);
+
+	gxemul.Execute(2);
+
+	UnitTest::Assert("t6", cpu->GetVariable("t6")->ToInteger(), 0x1234);
+	UnitTest::Assert("the store should have allocated RAM",
+	    ramBus->LookupHostPage(0xc12000, 0x1000, false, generation) != NULL);
+}
+
+static void Test_MIPS_CPUComponent_Execute_HostPagesSharedWithSnapshot()
+{
+	GXemul gxemul;
+	gxemul.GetCommandInterpreter().RunCommand("add testmips");
+
+	refcount_ptr<Component> cpu = gxemul.GetRootComponent()->LookupPath("root.machine0.mainbus0.cpu0");
+	UnitTest::Assert("huh? no cpu?", !cpu.IsNULL());
+
+	AddressDataBus* bus = cpu->AsAddressDataBus();
+
+	uint32_t program[4] = {
+		0xac8c0000,	// sw t4,0(a0)
+		0x8c8d0000,	// lw t5,0(a0)
+		0x8c8e0000,	// lw t6,0(a0)
+		0xac8f0000	// sw t7,0(a0)
+	};
+
+	for (size_t i=0; i<sizeof(program)/sizeof(program[0]); ++i) {
+		bus->AddressSelect(0xffffffff80004000ULL + i * sizeof(uint32_t));
+		bus->WriteData(program[i], BigEndian);
+	}
+
+	cpu->SetVariableValue("pc", "0xffffffff80004000");
+	cpu->SetVariableValue("a0", "0xffffffff80012340");
+	cpu->SetVariableValue("t4", "0x1111");
+	cpu->SetVariableValue("t7", "0x3333");
+
+	gxemul.SetRunState(GXemul::Running);
+	gxemul.Execute(2);
+
+	UnitTest::Assert("t5", cpu->GetVariable("t5")->ToInteger(), 0x1111);
+
+	// The snapshot shares RAM with the running machine, so the CPU's
+	// cached host pages into that RAM may only be read from.
+	refcount_ptr<Component> snapshot = gxemul.GetRootComponent()->Clone();
+	refcount_ptr<Component> snapshotCpu = snapshot->LookupPath("root.machine0.mainbus0.cpu0");
+	AddressDataBus* snapshotBus = snapshotCpu->AsAddressDataBus();
+
+	// Writing to the page via the bus copies the shared RAM:
+	uint32_t data32 = 0x2222;
+	bus->AddressSelect(0xffffffff80012340ULL);
+	bus->WriteData(data32, BigEndian);
+
+	gxemul.Execute(2);
+
+	UnitTest::Assert("t6 should not be read from the snapshot's RAM",
+	    cpu->GetVariable("t6")->ToInteger(), 0x2222);
+
+	bus->AddressSelect(0xffffffff80012340ULL);
+	bus->ReadData(data32, BigEndian);
+	UnitTest::Assert("the store should be visible", data32, 0x3333);
+
+	snapshotBus->AddressSelect(0xffffffff80012340ULL);
+	snapshotBus->ReadData(data32, BigEndian);
+	UnitTest::Assert("the snapshot should be unaffected", data32, 0x1111);
+}
+
 UNITTESTS(MIPS_CPUComponent)
 {
 	UNITTEST(Test_MIPS_CPUComponent_IsStable);
@@ -2029,6 +2372,10 @@ UNITTESTS(MIPS_CPUComponent)
 	UNITTEST(Test_MIPS_CPUComponent_Execute_DelayBranchWithValidInstruction_SingleStepping);
 	UNITTEST(Test_MIPS_CPUComponent_Execute_DelayBranchWithValidInstruction_RunTwoTimes);
 	UNITTEST(Test_MIPS_CPUComponent_Execute_DelayBranchWithFault);
+	UNITTEST(Test_MIPS_CPUComponent_Execute_CombinedInstructions);
+	UNITTEST(Test_MIPS_CPUComponent_Execute_CombinedInstructions_EndOfRAM);
+	UNITTEST(Test_MIPS_CPUComponent_Execute_LoadDoesNotAllocateRAM);
+	UNITTEST(Test_MIPS_CPUComponent_Execute_HostPagesSharedWithSnapshot);
 }
 
 #endif
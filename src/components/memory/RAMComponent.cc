@@ -29,6 +29,8 @@
 #include <assert.h>
 #include <sys/mman.h>
 
+#include "BinaryReader.h"
+#include "BinaryWriter.h"
 #include "components/RAMComponent.h"
 #include "GXemul.h"
 
@@ -42,6 +44,7 @@ RAMComponent::RAMComponent(const string& visibleClassName)
 	, m_lastDumpAddr(0)
 	, m_addressSelect(0)
 	, m_selectedHostMemoryBlock(NULL)
+	, m_selectedBlockWritable(false)
 	, m_selectedOffsetWithinBlock(0)
 {
 	AddVariable("writeProtect", &m_writeProtected);
@@ -58,12 +61,45 @@ RAMComponent::~RAMComponent()
 
 void RAMComponent::ReleaseAllBlocks()
 {
-	for (size_t i=0; i<m_memoryBlocks.size(); ++i) {
-		if (m_memoryBlocks[i] != NULL) {
-			munmap(m_memoryBlocks[i], m_blockSize);
-			m_memoryBlocks[i] = NULL;
-		}
+	for (size_t i=0; i<m_memoryBlocks.size(); ++i)
+		InvalidateHostPages(i);
+
+	// Blocks which are shared with clones are unmapped when the last
+	// reference to them goes away.
+	m_memoryBlocks.clear();
+
+	m_selectedHostMemoryBlock = NULL;
+	m_selectedBlockWritable = false;
+}
+
+
+RAMComponent::RAMBlock::RAMBlock(size_t size)
+	: m_data(NULL)
+	, m_size(size)
+{
+	void * p = mmap(NULL, m_size, PROT_WRITE | PROT_READ,
+	    MAP_ANON | MAP_PRIVATE, -1, 0);
+
+	if (p == MAP_FAILED || p == NULL) {
+		std::cerr << "RAMComponent::RAMBlock: Could not allocate "
+		    << m_size << " bytes. Aborting.\n";
+		throw std::exception();
 	}
+
+	m_data = p;
+}
+
+
+RAMComponent::RAMBlock::RAMBlock(void* data, size_t size)
+	: m_data(data)
+	, m_size(size)
+{
+}
+
+
+RAMComponent::RAMBlock::~RAMBlock()
+{
+	munmap(m_data, m_size);
 }
 
 
@@ -209,34 +245,435 @@ void RAMComponent::AddressSelect(uint64_t address)
 
 	uint64_t blockNr = address >> m_blockSizeShift;
 
-	if (blockNr+1 > m_memoryBlocks.size())
+	if (blockNr+1 > m_memoryBlocks.size() ||
+	    m_memoryBlocks[blockNr].IsNULL()) {
 		m_selectedHostMemoryBlock = NULL;
-	else
-		m_selectedHostMemoryBlock = m_memoryBlocks[blockNr];
+		m_selectedBlockWritable = false;
+	} else {
+		m_selectedHostMemoryBlock = m_memoryBlocks[blockNr]->GetData();
+		m_selectedBlockWritable =
+		    m_memoryBlocks[blockNr]->GetRefCount() == 1;
+	}
 
 	m_selectedOffsetWithinBlock = address & (m_blockSize-1);
 }
 
 
-void* RAMComponent::AllocateBlock()
+void RAMComponent::InvalidateHostPages(uint64_t blockNr)
 {
-	void * p = mmap(NULL, m_blockSize, PROT_WRITE | PROT_READ,
-	    MAP_ANON | MAP_PRIVATE, -1, 0);
-
-	if (p == MAP_FAILED || p == NULL) {
-		std::cerr << "RAMComponent::AllocateBlock: Could not allocate "
-		    << m_blockSize << " bytes. Aborting.\n";
-		throw std::exception();
-	}
+	// Blocks which have no counter yet have never been handed out.
+	if (blockNr < m_blockGenerations.size())
+		m_blockGenerations[blockNr] ++;
+}
 
-	uint64_t blockNr = m_addressSelect >> m_blockSizeShift;
 
+void* RAMComponent::GetWritableBlock(uint64_t blockNr)
+{
 	if (blockNr+1 > m_memoryBlocks.size())
 		m_memoryBlocks.resize(blockNr + 1);
 
-	m_memoryBlocks[blockNr] = p;
+	refcount_ptr<RAMBlock>& block = m_memoryBlocks[blockNr];
+
+	if (block.IsNULL()) {
+		block = new RAMBlock(m_blockSize);
+	} else if (block->GetRefCount() > 1) {
+		// The block is shared with a clone (e.g. a snapshot), so it
+		// has to be copied before it may be written to.
+		refcount_ptr<RAMBlock> copy = new RAMBlock(m_blockSize);
+		memcpy(copy->GetData(), block->GetData(), m_blockSize);
+		block = copy;
+
+		// Pages handed out for reading still point to the old block.
+		InvalidateHostPages(blockNr);
+	} else {
+		return block->GetData();
+	}
+
+	// The selected block may have been allocated or replaced above.
+	AddressSelect(m_addressSelect);
+
+	return block->GetData();
+}
+
+
+bool RAMComponent::ReadBlock(uint64_t address, uint8_t* data, size_t len)
+{
+	while (len > 0) {
+		uint64_t blockNr = address >> m_blockSizeShift;
+		size_t offset = address & (m_blockSize-1);
+		size_t chunk = m_blockSize - offset;
+		if (chunk > len)
+			chunk = len;
+
+		void* block = NULL;
+		if (blockNr < m_memoryBlocks.size() &&
+		    !m_memoryBlocks[blockNr].IsNULL())
+			block = m_memoryBlocks[blockNr]->GetData();
+
+		if (block == NULL)
+			memset(data, 0, chunk);
+		else
+			memcpy(data, (uint8_t*)block + offset, chunk);
+
+		address += chunk;
+		data += chunk;
+		len -= chunk;
+	}
+
+	return true;
+}
+
+
+bool RAMComponent::WriteBlock(uint64_t address, const uint8_t* data,
+	size_t len)
+{
+	if (m_writeProtected)
+		return false;
+
+	while (len > 0) {
+		uint64_t blockNr = address >> m_blockSizeShift;
+		size_t offset = address & (m_blockSize-1);
+		size_t chunk = m_blockSize - offset;
+		if (chunk > len)
+			chunk = len;
+
+		void* block = GetWritableBlock(blockNr);
+		memcpy((uint8_t*)block + offset, data, chunk);
+
+		address += chunk;
+		data += chunk;
+		len -= chunk;
+	}
+
+	return true;
+}
+
+
+uint8_t* RAMComponent::LookupHostPage(uint64_t address, size_t pageSize,
+	bool forWriting, const uint64_t*& generation)
+{
+	uint64_t blockNr = address >> m_blockSizeShift;
+	size_t offset = address & (m_blockSize-1);
+	void* block;
+
+	// Pages must not straddle host memory blocks.
+	if (offset + pageSize > m_blockSize)
+		return NULL;
+
+	if (forWriting) {
+		if (m_writeProtected)
+			return NULL;
+
+		// Allocates the block, or copies it if it is shared with
+		// a clone.
+		block = GetWritableBlock(blockNr);
+	} else {
+		// Reading from a block which has not been allocated yet
+		// should return zeroes. Blocks which are shared with clones
+		// may be read directly, though; InvalidateHostPages() is
+		// called when they are copied.
+		if (blockNr >= m_memoryBlocks.size() ||
+		    m_memoryBlocks[blockNr].IsNULL())
+			return NULL;
+
+		block = m_memoryBlocks[blockNr]->GetData();
+	}
+
+	while (m_blockGenerations.size() <= blockNr)
+		m_blockGenerations.push_back(0);
+
+	generation = &m_blockGenerations[blockNr];
 
-	return p;
+	return (uint8_t*)block + offset;
+}
+
+
+// Rows of this many bytes which are all zero are left out when serializing.
+#define SERIALIZATION_ROW_SIZE	1024
+
+static const char base64Chars[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static void SerializeHex(string& out, uint64_t value, int nDigits)
+{
+	static const char hexChars[] = "0123456789abcdef";
+
+	for (int i=nDigits-1; i>=0; --i)
+		out += hexChars[(value >> (i*4)) & 15];
+}
+
+static bool DeserializeHex(const char* str, int nDigits, uint64_t& value)
+{
+	value = 0;
+
+	for (int i=0; i<nDigits; ++i) {
+		char ch = str[i];
+		int digit;
+		if (ch >= '0' && ch <= '9')
+			digit = ch - '0';
+		else if (ch >= 'a' && ch <= 'f')
+			digit = ch - 'a' + 10;
+		else if (ch >= 'A' && ch <= 'F')
+			digit = ch - 'A' + 10;
+		else
+			return false;
+
+		value = (value << 4) | digit;
+	}
+
+	return true;
+}
+
+static int Base64Value(char ch)
+{
+	if (ch >= 'A' && ch <= 'Z')
+		return ch - 'A';
+	if (ch >= 'a' && ch <= 'z')
+		return ch - 'a' + 26;
+	if (ch >= '0' && ch <= '9')
+		return ch - '0' + 52;
+	if (ch == '+')
+		return 62;
+	if (ch == '/')
+		return 63;
+	if (ch == '=')
+		return 0;
+
+	return -1;
+}
+
+
+static bool IsZero(const uint8_t* data, size_t len)
+{
+	// Rows are always 64-bit aligned within the host memory blocks.
+	const uint64_t* p = (const uint64_t*) data;
+
+	for (size_t i=0; i<len / sizeof(uint64_t); ++i)
+		if (p[i] != 0)
+			return false;
+
+	return true;
+}
+
+
+void RAMComponent::RAMDataHandler::Serialize(ostream& ss) const
+{
+	const size_t blockSize = m_ram.m_blockSize;
+	string record;
+
+	for (size_t blockNr=0; blockNr<m_ram.m_memoryBlocks.size(); ++blockNr) {
+		if (m_ram.m_memoryBlocks[blockNr].IsNULL())
+			continue;
+
+		const uint8_t* block =
+		    (const uint8_t*) m_ram.m_memoryBlocks[blockNr]->GetData();
+		size_t offset = 0;
+
+		while (offset < blockSize) {
+			// Skip rows which are all zeroes...
+			while (offset < blockSize && IsZero(block + offset,
+			    SERIALIZATION_ROW_SIZE))
+				offset += SERIALIZATION_ROW_SIZE;
+
+			if (offset >= blockSize)
+				break;
+
+			// ... and output the following non-zero rows as
+			// one record.
+			size_t len = 0;
+			while (offset + len < blockSize && !IsZero(block +
+			    offset + len, SERIALIZATION_ROW_SIZE))
+				len += SERIALIZATION_ROW_SIZE;
+
+			const uint8_t* data = block + offset;
+
+			record.clear();
+			record.reserve(27 + (len + 2) / 3 * 4);
+			SerializeHex(record, ((uint64_t)blockNr <<
+			    m_ram.m_blockSizeShift) + offset, 16);
+			record += ':';
+			SerializeHex(record, len, 8);
+			record += '=';
+
+			for (size_t i=0; i<len; i+=3) {
+				uint32_t v = data[i] << 16;
+				if (i+1 < len)
+					v |= data[i+1] << 8;
+				if (i+2 < len)
+					v |= data[i+2];
+
+				record += base64Chars[(v >> 18) & 63];
+				record += base64Chars[(v >> 12) & 63];
+				record += i+1 < len? base64Chars[(v >> 6) & 63] : '=';
+				record += i+2 < len? base64Chars[v & 63] : '=';
+			}
+
+			record += '.';
+			ss.write(record.c_str(), record.length());
+
+			offset += len;
+		}
+	}
+
+	// End of data.
+	ss << ".";
+}
+
+
+bool RAMComponent::RAMDataHandler::Deserialize(const string& value)
+{
+	m_ram.ReleaseAllBlocks();
+
+	uint64_t ramSize =
+	    m_ram.GetVariable("memoryMappedSize")->ToInteger();
+
+	const char *cstr = value.c_str();
+	size_t len = value.length();
+	size_t p = 0;
+	vector<uint8_t> data;
+
+	while (p < len) {
+		if (cstr[p] == '.') {
+			p++;
+			continue;
+		}
+
+		uint64_t addr, datalen;
+		if (p + 26 > len || !DeserializeHex(cstr + p, 16, addr) ||
+		    cstr[p+16] != ':' || !DeserializeHex(cstr + p + 17, 8,
+		    datalen))
+			return false;
+
+		bool base64 = cstr[p+25] == '=';
+		if (!base64 && cstr[p+25] != ':')
+			return false;
+
+		// The data must lie within the configured RAM size.
+		if (datalen > ramSize || addr > ramSize - datalen)
+			return false;
+
+		p += 26;
+
+		size_t encodedLen = base64? (datalen + 2) / 3 * 4 : datalen * 2;
+		if (p + encodedLen >= len || cstr[p + encodedLen] != '.')
+			return false;
+
+		data.resize(datalen);
+
+		if (base64) {
+			for (size_t i=0; i<datalen; i+=3, p+=4) {
+				int v0 = Base64Value(cstr[p]);
+				int v1 = Base64Value(cstr[p+1]);
+				int v2 = Base64Value(cstr[p+2]);
+				int v3 = Base64Value(cstr[p+3]);
+				if (v0 < 0 || v1 < 0 || v2 < 0 || v3 < 0)
+					return false;
+
+				uint32_t v = (v0 << 18) | (v1 << 12) | (v2 << 6) | v3;
+				data[i] = v >> 16;
+				if (i+1 < datalen)
+					data[i+1] = v >> 8;
+				if (i+2 < datalen)
+					data[i+2] = v;
+			}
+		} else {
+			for (size_t i=0; i<datalen; i++, p+=2) {
+				uint64_t b;
+				if (!DeserializeHex(cstr + p, 2, b))
+					return false;
+
+				data[i] = b;
+			}
+		}
+
+		// Write the data directly to the memory blocks. (Not via
+		// WriteBlock, since the RAM may be write protected.)
+		size_t done = 0;
+		while (done < datalen) {
+			uint64_t a = addr + done;
+			size_t offset = a & (m_ram.m_blockSize-1);
+			size_t chunk = m_ram.m_blockSize - offset;
+			if (chunk > datalen - done)
+				chunk = datalen - done;
+
+			uint8_t* block = (uint8_t*) m_ram.GetWritableBlock(
+			    a >> m_ram.m_blockSizeShift);
+			memcpy(block + offset, &data[done], chunk);
+
+			done += chunk;
+		}
+	}
+
+	return true;
+}
+
+
+void RAMComponent::RAMDataHandler::SerializeBinary(BinaryWriter& writer) const
+{
+	size_t nBlocks = 0;
+	for (size_t i=0; i<m_ram.m_memoryBlocks.size(); ++i)
+		if (!m_ram.m_memoryBlocks[i].IsNULL())
+			++ nBlocks;
+
+	writer.WriteUInt64(m_ram.m_blockSize);
+	writer.WriteUInt64(nBlocks);
+
+	for (size_t i=0; i<m_ram.m_memoryBlocks.size(); ++i) {
+		if (m_ram.m_memoryBlocks[i].IsNULL())
+			continue;
+
+		writer.WriteUInt64(i);
+		writer.WriteUInt64(writer.AddSection(
+		    m_ram.m_memoryBlocks[i]->GetData(), m_ram.m_blockSize));
+	}
+}
+
+
+bool RAMComponent::RAMDataHandler::DeserializeBinary(BinaryReader& reader)
+{
+	m_ram.ReleaseAllBlocks();
+
+	uint64_t blockSize, nBlocks;
+	if (!reader.ReadUInt64(blockSize) || !reader.ReadUInt64(nBlocks) ||
+	    blockSize != m_ram.m_blockSize)
+		return false;
+
+	uint64_t ramSize =
+	    m_ram.GetVariable("memoryMappedSize")->ToInteger();
+	uint64_t nBlocksInRAM = (ramSize >> m_ram.m_blockSizeShift) +
+	    ((ramSize & (m_ram.m_blockSize - 1)) != 0? 1 : 0);
+
+	for (uint64_t i=0; i<nBlocks; ++i) {
+		uint64_t blockNr, section;
+		if (!reader.ReadUInt64(blockNr) || !reader.ReadUInt64(section))
+			return false;
+
+		// Each block must lie within the configured RAM size, be
+		// stored only once, and be a whole block in the file.
+		uint64_t sectionLength;
+		if (blockNr >= nBlocksInRAM ||
+		    (blockNr < m_ram.m_memoryBlocks.size() &&
+		    !m_ram.m_memoryBlocks[blockNr].IsNULL()) ||
+		    !reader.GetSectionLength(section, sectionLength) ||
+		    sectionLength != m_ram.m_blockSize)
+			return false;
+
+		// Contents are read from the file when the block is touched.
+		void* data = reader.MapSection(section, m_ram.m_blockSize);
+		if (data == NULL)
+			return false;
+
+		if (blockNr+1 > m_ram.m_memoryBlocks.size())
+			m_ram.m_memoryBlocks.resize(blockNr + 1);
+
+		m_ram.m_memoryBlocks[blockNr] =
+		    new RAMBlock(data, m_ram.m_blockSize);
+		m_ram.InvalidateHostPages(blockNr);
+	}
+
+	m_ram.AddressSelect(m_ram.m_addressSelect);
+
+	return true;
 }
 
 
@@ -314,8 +751,8 @@ bool RAMComponent::WriteData(const uint8_t& data, Endianness endianness)
 	if (m_writeProtected)
 		return false;
 
-	if (m_selectedHostMemoryBlock == NULL)
-		m_selectedHostMemoryBlock = AllocateBlock();
+	if (!m_selectedBlockWritable)
+		GetWritableBlock(m_addressSelect >> m_blockSizeShift);
 
 	(((uint8_t*)m_selectedHostMemoryBlock)
 	    [m_selectedOffsetWithinBlock]) = data;
@@ -331,8 +768,8 @@ bool RAMComponent::WriteData(const uint16_t& data, Endianness endianness)
 	if (m_writeProtected)
 		return false;
 
-	if (m_selectedHostMemoryBlock == NULL)
-		m_selectedHostMemoryBlock = AllocateBlock();
+	if (!m_selectedBlockWritable)
+		GetWritableBlock(m_addressSelect >> m_blockSizeShift);
 
 	uint16_t d;
 	if (endianness == BigEndian)
@@ -354,8 +791,8 @@ bool RAMComponent::WriteData(const uint32_t& data, Endianness endianness)
 	if (m_writeProtected)
 		return false;
 
-	if (m_selectedHostMemoryBlock == NULL)
-		m_selectedHostMemoryBlock = AllocateBlock();
+	if (!m_selectedBlockWritable)
+		GetWritableBlock(m_addressSelect >> m_blockSizeShift);
 
 	uint32_t d;
 	if (endianness == BigEndian)
@@ -377,8 +814,8 @@ bool RAMComponent::WriteData(const uint64_t& data, Endianness endianness)
 	if (m_writeProtected)
 		return false;
 
-	if (m_selectedHostMemoryBlock == NULL)
-		m_selectedHostMemoryBlock = AllocateBlock();
+	if (!m_selectedBlockWritable)
+		GetWritableBlock(m_addressSelect >> m_blockSizeShift);
 
 	uint64_t d;
 	if (endianness == BigEndian)
@@ -398,6 +835,9 @@ bool RAMComponent::WriteData(const uint64_t& data, Endianness endianness)
 
 #ifdef WITHUNITTESTS
 
+#include <stdlib.h>
+#include <unistd.h>
+
 #include "ComponentFactory.h"
 
 static void Test_RAMComponent_IsStable()
@@ -585,6 +1025,7 @@ static void Test_RAMComponent_ClearOnReset()
 static void Test_RAMComponent_Clone()
 {
 	refcount_ptr<Component> ram = ComponentFactory::CreateComponent("ram");
+	ram->SetVariableValue("memoryMappedSize", "0x100000");
 	AddressDataBus* bus = ram->AsAddressDataBus();
 
 	uint32_t data32 = 0x89abcdef;
@@ -611,9 +1052,47 @@ static void Test_RAMComponent_Clone()
 	UnitTest::Assert("16-bit read", data16_a, 0x3412);
 }
 
+static void Test_RAMComponent_Clone_CopyOnWrite()
+{
+	refcount_ptr<Component> ram = ComponentFactory::CreateComponent("ram");
+	AddressDataBus* bus = ram->AsAddressDataBus();
+	const uint64_t* generation;
+
+	uint32_t data32 = 0x11223344;
+	bus->AddressSelect(0x100);
+	bus->WriteData(data32, BigEndian);
+
+	refcount_ptr<Component> clone = ram->Clone();
+	AddressDataBus* cloneBus = clone->AsAddressDataBus();
+
+	// Writing to the original (with the address selected before the
+	// clone was made) must not be visible in the clone...
+	data32 = 0x55667788;
+	bus->WriteData(data32, BigEndian);
+
+	cloneBus->AddressSelect(0x100);
+	cloneBus->ReadData(data32, BigEndian);
+	UnitTest::Assert("clone should not see the write", data32, 0x11223344);
+
+	// ... and vice versa, also when writing via host pages.
+	uint8_t* page = cloneBus->LookupHostPage(0x100, 0x100, true, generation);
+	UnitTest::Assert("host page lookup failed?", page != NULL);
+	page[0] = 0x99;
+
+	bus->AddressSelect(0x100);
+	bus->ReadData(data32, BigEndian);
+	UnitTest::Assert("original should not see the write",
+	    data32, 0x55667788);
+
+	cloneBus->AddressSelect(0x100);
+	cloneBus->ReadData(data32, BigEndian);
+	UnitTest::Assert("clone should see its own write", data32, 0x99223344);
+}
+
 static void Test_RAMComponent_ManualSerialization()
 {
 	refcount_ptr<Component> ram = ComponentFactory::CreateComponent("ram");
+	ram->SetVariableValue("memoryMappedSize", "0x100000");
 	AddressDataBus* bus = ram->AsAddressDataBus();
 
 	uint32_t data32 = 0x89abcde5;
@@ -645,6 +1124,291 @@ static void Test_RAMComponent_ManualSerialization()
 	UnitTest::Assert("16-bit read", data16_a, 0x3512);
 }
 
+static void Test_RAMComponent_SerializationFormat()
+{
+	refcount_ptr<Component> ram = ComponentFactory::CreateComponent("ram");
+	ram->SetVariableValue("memoryMappedSize", "0x100000");
+	AddressDataBus* bus = ram->AsAddressDataBus();
+
+	uint8_t data8 = 0x42;
+	bus->AddressSelect(0x12345);
+	bus->WriteData(data8);
+
+	// Only the non-zero row should be serialized.
+	stringstream ss;
+	ram->GetVariable("data")->SerializeValue(ss);
+	string result = ss.str();
+	UnitTest::Assert("record header", result.substr(0, 26),
+	    "0000000000012000:00000400=");
+	UnitTest::Assert("record length", result.length(), 26 + 1368 + 2);
+
+	refcount_ptr<Component> ram2 = ComponentFactory::CreateComponent("ram");
+	ram2->SetVariableValue("memoryMappedSize", "0x100000");
+	UnitTest::Assert("deserialization failed?",
+	    ram2->GetVariable("data")->SetValue(result));
+
+	bus = ram2->AsAddressDataBus();
+	data8 = 0;
+	bus->AddressSelect(0x12345);
+	bus->ReadData(data8);
+	UnitTest::Assert("value after deserialization", data8, 0x42);
+
+	// The older hex format should still be readable.
+	UnitTest::Assert("hex deserialization failed?",
+	    ram2->GetVariable("data")->SetValue(
+	    "0000000000000100:00000003:a1b2c3.."));
+
+	bus->AddressSelect(0x12345);
+	bus->ReadData(data8);
+	UnitTest::Assert("old contents should be gone", data8, 0);
+
+	uint32_t data32 = 0;
+	bus->AddressSelect(0x100);
+	bus->ReadData(data32, BigEndian);
+	UnitTest::Assert("hex format value", data32, 0xa1b2c300);
+
+	UnitTest::Assert("garbage should not be accepted",
+	    !ram2->GetVariable("data")->SetValue("0000000000000100:zz"));
+}
+
+static void Test_RAMComponent_BinarySerialization()
+{
+	refcount_ptr<Component> ram = ComponentFactory::CreateComponent("ram");
+	ram->SetVariableValue("memoryMappedSize", "0x800000");
+	AddressDataBus* bus = ram->AsAddressDataBus();
+
+	uint32_t data32 = 0x12345678;
+	bus->AddressSelect(0x400004);
+	bus->WriteData(data32, BigEndian);
+
+	char filename[] = "/tmp/gxemul_ramtest_XXXXXX";
+	int fd = mkstemp(filename);
+	UnitTest::Assert("could not create temporary file", fd >= 0);
+	close(fd);
+
+	BinaryWriter writer;
+	ram->SerializeBinary(writer);
+	UnitTest::Assert("writing failed", writer.Finish(filename));
+
+	refcount_ptr<Component> ram2;
+	{
+		BinaryReader reader;
+		stringstream messages;
+		UnitTest::Assert("opening failed",
+		    reader.Open(filename, messages));
+		ram2 = Component::DeserializeBinary(messages, reader);
+		UnitTest::Assert("deserialization failed", !ram2.IsNULL());
+	}
+
+	// The file may be removed, since the RAM contents are mapped.
+	unlink(filename);
+
+	bus = ram2->AsAddressDataBus();
+	data32 = 0;
+	bus->AddressSelect(0x400004);
+	bus->ReadData(data32, BigEndian);
+	UnitTest::Assert("value after loading", data32, 0x12345678);
+
+	data32 = 0x9abcdef0;
+	bus->WriteData(data32, BigEndian);
+	data32 = 0;
+	bus->AddressSelect(0x400004);
+	bus->ReadData(data32, BigEndian);
+	UnitTest::Assert("writes to mapped RAM", data32, 0x9abcdef0);
+
+	bus->AddressSelect(4);
+	bus->ReadData(data32, BigEndian);
+	UnitTest::Assert("unallocated block should still be zero", data32, 0);
+}
+
+static void Test_RAMComponent_DeserializeOutsideRAM()
+{
+	refcount_ptr<Component> ram = ComponentFactory::CreateComponent("ram");
+	ram->SetVariableValue("memoryMappedSize", "0x100000");
+	StateVariable* data = ram->GetVariable("data");
+
+	UnitTest::Assert("data within the RAM should be accepted",
+	    data->SetValue("00000000000ffffe:00000002:a1b2.."));
+	UnitTest::Assert("data after the end should not be accepted",
+	    !data->SetValue("0000000000100000:00000001:a1.."));
+	UnitTest::Assert("data crossing the end should not be accepted",
+	    !data->SetValue("00000000000fffff:00000002:a1b2.."));
+	UnitTest::Assert("address wrap-around should not be accepted",
+	    !data->SetValue("ffffffffffffffff:00000002:a1b2.."));
+
+	// A block beyond the end of a smaller RAM.
+	refcount_ptr<Component> bigRAM =
+	    ComponentFactory::CreateComponent("ram");
+	bigRAM->SetVariableValue("memoryMappedSize", "0x800000");
+	AddressDataBus* bus = bigRAM->AsAddressDataBus();
+	uint8_t data8 = 0x42;
+	bus->AddressSelect(0x400000);
+	bus->WriteData(data8);
+
+	char filename[] = "/tmp/gxemul_ramtest_XXXXXX";
+	int fd = mkstemp(filename);
+	UnitTest::Assert("could not create temporary file", fd >= 0);
+	close(fd);
+
+	BinaryWriter writer;
+	bigRAM->GetVariable("data")->SerializeBinary(writer);
+	UnitTest::Assert("writing failed", writer.Finish(filename));
+
+	BinaryReader reader;
+	stringstream messages;
+	UnitTest::Assert("opening failed", reader.Open(filename, messages));
+	unlink(filename);
+
+	string name;
+	uint8_t type;
+	UnitTest::Assert("reading the variable name failed",
+	    reader.ReadString(name) && reader.ReadUInt8(type));
+	UnitTest::Assert("block after the end should not be accepted",
+	    !data->DeserializeBinaryValue(reader, (StateVariable::Type) type));
+}
+
+static void Test_RAMComponent_SkipBinaryData()
+{
+	refcount_ptr<Component> ram = ComponentFactory::CreateComponent("ram");
+	ram->SetVariableValue("memoryMappedSize", "0x800000");
+	AddressDataBus* bus = ram->AsAddressDataBus();
+	uint8_t data8 = 0x42;
+	bus->AddressSelect(0x400000);
+	bus->WriteData(data8);
+
+	char filename[] = "/tmp/gxemul_ramtest_XXXXXX";
+	int fd = mkstemp(filename);
+	UnitTest::Assert("could not create temporary file", fd >= 0);
+	close(fd);
+
+	BinaryWriter writer;
+	ram->GetVariable("data")->SerializeBinary(writer);
+	writer.WriteUInt8(0x99);
+	UnitTest::Assert("writing failed", writer.Finish(filename));
+
+	BinaryReader reader;
+	stringstream messages;
+	UnitTest::Assert("opening failed", reader.Open(filename, messages));
+	unlink(filename);
+
+	// A reader which does not know the variable skips it.
+	string name;
+	uint8_t type;
+	UnitTest::Assert("reading the variable name failed",
+	    reader.ReadString(name) && reader.ReadUInt8(type));
+	UnitTest::Assert("skipping failed", StateVariable::SkipBinaryValue(
+	    reader, (StateVariable::Type) type));
+	UnitTest::Assert("value after the skipped variable",
+	    reader.ReadUInt8(data8) && data8 == 0x99);
+}
+
+static void Test_RAMComponent_Blocks()
+{
+	refcount_ptr<Component> ram = ComponentFactory::CreateComponent("ram");
+	AddressDataBus* bus = ram->AsAddressDataBus();
+
+	// Across the boundary between two host memory blocks:
+	uint8_t buf[64];
+	for (size_t i=0; i<sizeof(buf); ++i)
+		buf[i] = i + 1;
+
+	UnitTest::Assert("block write should succeed",
+	    bus->WriteBlock(0x3fffe0, buf, sizeof(buf)));
+
+	uint8_t data8 = 0;
+	bus->AddressSelect(0x3fffe0);
+	bus->ReadData(data8);
+	UnitTest::Assert("first byte", data8, 1);
+	bus->AddressSelect(0x400000);
+	bus->ReadData(data8);
+	UnitTest::Assert("first byte in second block", data8, 33);
+
+	uint8_t buf2[80];
+	memset(buf2, 0xff, sizeof(buf2));
+	UnitTest::Assert("block read should succeed",
+	    bus->ReadBlock(0x3fffd0, buf2, sizeof(buf2)));
+	UnitTest::Assert("unwritten memory should read as zero",
+	    buf2[0x0f], 0);
+	UnitTest::Assert("block read mismatch",
+	    memcmp(buf2 + 0x10, buf, sizeof(buf)) == 0);
+
+	ram->SetVariableValue("writeProtect", "true");
+	UnitTest::Assert("writeprotected block write should fail",
+	    bus->WriteBlock(0x100, buf, sizeof(buf)) == false);
+}
+
+static void Test_RAMComponent_LookupHostPage()
+{
+	refcount_ptr<Component> ram = ComponentFactory::CreateComponent("ram");
+	AddressDataBus* bus = ram->AsAddressDataBus();
+	const uint64_t* generation;
+
+	UnitTest::Assert("unwritten memory should not be readable directly",
+	    bus->LookupHostPage(0x2000, 0x1000, false, generation) == NULL);
+
+	uint8_t* page = bus->LookupHostPage(0x2000, 0x1000, true, generation);
+	UnitTest::Assert("page should be writable", page != NULL);
+	UnitTest::Assert("page should now also be readable",
+	    bus->LookupHostPage(0x2000, 0x1000, false, generation) == page);
+
+	page[0x10] = 0x12;
+	page[0x11] = 0x34;
+
+	uint16_t data16 = 0;
+	bus->AddressSelect(0x2010);
+	bus->ReadData(data16, BigEndian);
+	UnitTest::Assert("direct write should be visible", data16, 0x1234);
+
+	ram->SetVariableValue("writeProtect", "true");
+	UnitTest::Assert("write protected memory should not be writable",
+	    bus->LookupHostPage(0x2000, 0x1000, true, generation) == NULL);
+
+	UnitTest::Assert("pages must not straddle host memory blocks",
+	    bus->LookupHostPage(0x3ff800, 0x1000, false, generation) == NULL);
+}
+
+static void Test_RAMComponent_LookupHostPage_SharedWithClone()
+{
+	refcount_ptr<Component> ram = ComponentFactory::CreateComponent("ram");
+	AddressDataBus* bus = ram->AsAddressDataBus();
+	const uint64_t* generation = NULL;
+	const uint64_t* cloneGeneration = NULL;
+
+	uint8_t* page = bus->LookupHostPage(0x2000, 0x1000, true, generation);
+	UnitTest::Assert("page should be writable", page != NULL);
+	uint64_t generationValue = *generation;
+	page[0] = 0x12;
+
+	refcount_ptr<Component> clone = ram->Clone();
+	AddressDataBus* cloneBus = clone->AsAddressDataBus();
+
+	UnitTest::Assert("the shared page may not be written through anymore",
+	    *generation != generationValue);
+
+	// Reading shared memory should not copy it:
+	page = bus->LookupHostPage(0x2000, 0x1000, false, generation);
+	generationValue = *generation;
+	UnitTest::Assert("the original and the clone should share the page",
+	    page != NULL && page == cloneBus->LookupHostPage(0x2000, 0x1000,
+	    false, cloneGeneration));
+
+	// ... but writing to it should:
+	uint8_t data8 = 0x34;
+	bus->AddressSelect(0x2000);
+	bus->WriteData(data8, BigEndian);
+
+	UnitTest::Assert("the read-only page is stale after the copy",
+	    *generation != generationValue);
+	UnitTest::Assert("the clone's page should be unaffected",
+	    page[0], 0x12);
+	UnitTest::Assert("the original should have a new page",
+	    bus->LookupHostPage(0x2000, 0x1000, false, generation) != page);
+
+	cloneBus->AddressSelect(0x2000);
+	cloneBus->ReadData(data8, BigEndian);
+	UnitTest::Assert("clone should not see the write", data8, 0x12);
+}
+
 static void Test_RAMComponent_Methods_Reexecutableness()
 {
 	refcount_ptr<Component> ram = ComponentFactory::CreateComponent("ram");
@@ -666,7 +1430,15 @@ UNITTESTS(RAMComponent)
 	UNITTEST(Test_RAMComponent_WriteProtect);
 	UNITTEST(Test_RAMComponent_ClearOnReset);
 	UNITTEST(Test_RAMComponent_Clone);
+	UNITTEST(Test_RAMComponent_Clone_CopyOnWrite);
 	UNITTEST(Test_RAMComponent_ManualSerialization);
+	UNITTEST(Test_RAMComponent_SerializationFormat);
+	UNITTEST(Test_RAMComponent_BinarySerialization);
+	UNITTEST(Test_RAMComponent_DeserializeOutsideRAM);
+	UNITTEST(Test_RAMComponent_SkipBinaryData);
+	UNITTEST(Test_RAMComponent_Blocks);
+	UNITTEST(Test_RAMComponent_LookupHostPage);
+	UNITTEST(Test_RAMComponent_LookupHostPage_SharedWithClone);
 	UNITTEST(Test_RAMComponent_Methods_Reexecutableness);
 }
 
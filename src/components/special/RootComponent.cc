@@ -34,10 +34,12 @@ RootComponent::RootComponent(GXemul* owner)
 	: Component("root", "root")
 	, m_gxemul(owner)
 	, m_accuracy("cycle")
+	, m_snapshotInterval(100000)
 {
 	SetVariableValue("name", "\"root\"");
 
 	AddVariable("accuracy", &m_accuracy);
+	AddVariable("snapshotInterval", &m_snapshotInterval);
 }
 
 
@@ -48,10 +50,25 @@ bool RootComponent::PreRunCheckForComponent(GXemul* gxemul)
 		return false;
 	}
 
+	if (m_snapshotInterval == 0) {
+		gxemul->GetUI()->ShowDebugMessage(this, "snapshotInterval must be at least 1.\n");
+		return false;
+	}
+
 	return true;
 }
 
 
+void RootComponent::FlushCachedStateForComponent()
+{
+	// The owner caches handles to variables of executable components.
+	if (m_gxemul != NULL)
+		m_gxemul->InvalidateExecutableComponents();
+
+	Component::FlushCachedStateForComponent();
+}
+
+
 void RootComponent::SetOwner(GXemul* owner)
 {
 	m_gxemul = owner;
@@ -70,6 +87,18 @@ bool RootComponent::CheckVariableWrite(StateVariable& var, const string& oldValu
 
 			return false;
 		}
+
+		if (m_gxemul != NULL)
+			m_gxemul->InvalidateExecutableComponents();
+	}
+
+	if (name == "snapshotInterval") {
+		if (var.ToInteger() == 0) {
+			if (ui != NULL)
+				ui->ShowDebugMessage(this, "snapshotInterval must be at least 1.\n");
+
+			return false;
+		}
 	}
 
 	return Component::CheckVariableWrite(var, oldValue);
@@ -101,6 +130,8 @@ static void Test_RootComponent_InitialVariables()
 	UnitTest::Assert("name should be root", name->ToString(), "root");
 	UnitTest::Assert("step should be 0", step->ToInteger(), 0);
 	UnitTest::Assert("accuracy should be cycle", accuracy->ToString(), "cycle");
+	UnitTest::Assert("there should be a snapshotInterval",
+	    component->GetVariable("snapshotInterval") != NULL);
 }
 
 static void Test_RootComponent_AccuracyValues()
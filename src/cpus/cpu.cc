@@ -258,7 +258,10 @@ void cpu_functioncall_trace(struct cpu *cpu, uint64_t f)
 
 #ifdef PRINT_MEMORY_CHECKSUM
 	/*  Temporary hack for finding bugs:  */
-	fatal("call chksum=%016" PRIx64 "\n", memory_checksum(cpu->mem));
+	if (!cpu->mem->hash_tree_tracking)
+		memory_checksum_tracking(cpu, cpu->mem, 1);
+	fatal("call chksum=%016" PRIx64 "\n", memory_checksum(cpu,
+	    cpu->mem));
 #endif
 }
 
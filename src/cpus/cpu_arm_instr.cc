@@ -1104,7 +1104,7 @@ X(bdt_load)
 				addr -= sizeof(uint32_t);
 		}
 
-		page = cpu->cd.arm.host_load[addr >> 12];
+		page = VPH32_HOST_LOAD(cpu->cd.arm.l1_32, addr >> 12);
 		if (page != NULL) {
 			uint32_t *p32 = (uint32_t *) page;
 			value = p32[(addr & 0xfff) >> 2];
@@ -1301,7 +1301,7 @@ X(bdt_store)
 				addr -= sizeof(uint32_t);
 		}
 
-		page = cpu->cd.arm.host_store[addr >> 12];
+		page = VPH32_HOST_STORE(cpu->cd.arm.l1_32, addr >> 12);
 		if (page != NULL) {
 			uint32_t *p32 = (uint32_t *) page;
 			/*  Change byte order of value if
@@ -1398,7 +1398,7 @@ X(netbsd_memset)
 
 		/*  printf("addr = 0x%08x\n", addr);  */
 
-		page = cpu->cd.arm.host_store[addr >> 12];
+		page = VPH32_HOST_STORE(cpu->cd.arm.l1_32, addr >> 12);
 		/*  No page translation? Continue non-combined.  */
 		if (page == NULL)
 			return;
@@ -1449,8 +1449,8 @@ X(netbsd_memcpy)
 			return;
 		}
 
-		page_0 = cpu->cd.arm.host_store[addr_r0 >> 12];
-		page_1 = cpu->cd.arm.host_store[addr_r1 >> 12];
+		page_0 = VPH32_HOST_STORE(cpu->cd.arm.l1_32, addr_r0 >> 12);
+		page_1 = VPH32_HOST_STORE(cpu->cd.arm.l1_32, addr_r1 >> 12);
 
 		/*  No page translations? Continue non-combined.  */
 		if (page_0 == NULL || page_1 == NULL) {
@@ -1526,7 +1526,8 @@ X(netbsd_cacheclean2)
  */
 X(netbsd_scanc)
 {
-	unsigned char *page = cpu->cd.arm.host_load[cpu->cd.arm.r[1] >> 12];
+	unsigned char *page =
+	    VPH32_HOST_LOAD(cpu->cd.arm.l1_32, cpu->cd.arm.r[1] >> 12);
 	uint32_t t;
 
 	if (page == NULL) {
@@ -1536,7 +1537,7 @@ X(netbsd_scanc)
 
 	t = page[cpu->cd.arm.r[1] & 0xfff];
 	t += cpu->cd.arm.r[2];
-	page = cpu->cd.arm.host_load[t >> 12];
+	page = VPH32_HOST_LOAD(cpu->cd.arm.l1_32, t >> 12);
 
 	if (page == NULL) {
 		instr(load_w0_byte_u1_p1_imm)(cpu, ic);
@@ -1573,7 +1574,7 @@ X(netbsd_idle)
 	uint32_t *p;
 	uint32_t rX;
 
-	p = (uint32_t *) cpu->cd.arm.host_load[rY >> 12];
+	p = (uint32_t *) VPH32_HOST_LOAD(cpu->cd.arm.l1_32, rY >> 12);
 	if (p == NULL) {
 		instr(load_w0_word_u1_p1_imm)(cpu, ic);
 		return;
@@ -1630,7 +1631,7 @@ X(strlen)
 
 	do {
 		rX ++;
-		p = cpu->cd.arm.host_load[rX >> 12];
+		p = VPH32_HOST_LOAD(cpu->cd.arm.l1_32, rX >> 12);
 		if (p == NULL) {
 			cpu->n_translated_instrs += (n_loops * 3);
 			instr(load_w1_byte_u1_p1_imm)(cpu, ic);
@@ -1682,7 +1683,7 @@ X(xchg)
 X(netbsd_copyin)
 {
 	uint32_t r0 = cpu->cd.arm.r[0], ofs = (r0 & 0xffc), index = r0 >> 12;
-	unsigned char *p = cpu->cd.arm.host_load[index];
+	unsigned char *p = VPH32_HOST_LOAD(cpu->cd.arm.l1_32, index);
 	uint32_t *p32 = (uint32_t *) p, *q32;
 	int ok = cpu->cd.arm.is_userpage[index >> 5] & (1 << (index & 31));
 
@@ -1717,7 +1718,7 @@ X(netbsd_copyin)
 X(netbsd_copyout)
 {
 	uint32_t r1 = cpu->cd.arm.r[1], ofs = (r1 & 0xffc), index = r1 >> 12;
-	unsigned char *p = cpu->cd.arm.host_store[index];
+	unsigned char *p = VPH32_HOST_STORE(cpu->cd.arm.l1_32, index);
 	uint32_t *p32 = (uint32_t *) p, *q32;
 	int ok = cpu->cd.arm.is_userpage[index >> 5] & (1 << (index & 31));
 
@@ -2553,7 +2554,7 @@ X(to_be_translated)
 	addr &= ~((1 << ARM_INSTR_ALIGNMENT_SHIFT) - 1);
 
 	/*  Read the instruction word from memory:  */
-	page = cpu->cd.arm.host_load[addr >> 12];
+	page = VPH32_HOST_LOAD(cpu->cd.arm.l1_32, addr >> 12);
 
 	if (page != NULL) {
 		/*  fatal("TRANSLATION HIT! 0x%08x\n", addr);  */
@@ -227,13 +227,12 @@ void A__NAME(struct cpu *cpu, struct arm_instr_call *ic)
 	    + offset
 #endif
 	    ;
-	unsigned char *page = cpu->cd.arm.
+	unsigned char *page =
 #ifdef A__L
-	    host_load
+	    VPH32_HOST_LOAD(cpu->cd.arm.l1_32, addr >> 12);
 #else
-	    host_store
+	    VPH32_HOST_STORE(cpu->cd.arm.l1_32, addr >> 12);
 #endif
-	    [addr >> 12];
 
 
 #if !defined(A__P) && defined(A__W)
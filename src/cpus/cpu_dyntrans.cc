@@ -600,7 +600,7 @@ void DYNTRANS_PC_TO_POINTERS_GENERIC(struct cpu *cpu)
 	struct DYNTRANS_TC_PHYSPAGE *ppp;
 
 #ifdef MODE32
-	int index = DYNTRANS_ADDR_TO_PAGENR(cached_pc);
+	uint32_t index = DYNTRANS_ADDR_TO_PAGENR(cached_pc);
 #else
 	const uint32_t mask1 = (1 << DYNTRANS_L1N) - 1;
 	const uint32_t mask2 = (1 << DYNTRANS_L2N) - 1;
@@ -623,8 +623,8 @@ void DYNTRANS_PC_TO_POINTERS_GENERIC(struct cpu *cpu)
 	/*  Virtual to physical address translation:  */
 	ok = 0;
 #ifdef MODE32
-	if (cpu->cd.DYNTRANS_ARCH.host_load[index] != NULL) {
-		physaddr = cpu->cd.DYNTRANS_ARCH.phys_addr[index];
+	if (VPH32_HOST_LOAD(cpu->cd.DYNTRANS_ARCH.l1_32, index) != NULL) {
+		physaddr = VPH32_PHYS_ADDR(cpu->cd.DYNTRANS_ARCH.l1_32, index);
 		ok = 1;
 	}
 #else
@@ -666,8 +666,10 @@ void DYNTRANS_PC_TO_POINTERS_GENERIC(struct cpu *cpu)
 
 #ifdef MODE32
 			index = DYNTRANS_ADDR_TO_PAGENR(cached_pc);
-			if (cpu->cd.DYNTRANS_ARCH.host_load[index] != NULL) {
-				paddr = cpu->cd.DYNTRANS_ARCH.phys_addr[index];
+			if (VPH32_HOST_LOAD(cpu->cd.DYNTRANS_ARCH.l1_32, index)
+			    != NULL) {
+				paddr = VPH32_PHYS_ADDR(
+				    cpu->cd.DYNTRANS_ARCH.l1_32, index);
 				ok = 1;
 			}
 #else
@@ -706,7 +708,7 @@ void DYNTRANS_PC_TO_POINTERS_GENERIC(struct cpu *cpu)
 	physaddr &= ~(DYNTRANS_PAGESIZE - 1);
 
 #ifdef MODE32
-	if (cpu->cd.DYNTRANS_ARCH.host_load[index] == NULL) {
+	if (VPH32_HOST_LOAD(cpu->cd.DYNTRANS_ARCH.l1_32, index) == NULL) {
 #else
 	if (l3->host_load[x3] == NULL) {
 #endif
@@ -777,8 +779,8 @@ void DYNTRANS_PC_TO_POINTERS_GENERIC(struct cpu *cpu)
 	/*  Here, ppp points to a valid physical page struct.  */
 
 #ifdef MODE32
-	if (cpu->cd.DYNTRANS_ARCH.host_load[index] != NULL)
-		cpu->cd.DYNTRANS_ARCH.phys_page[index] = ppp;
+	if (VPH32_HOST_LOAD(cpu->cd.DYNTRANS_ARCH.l1_32, index) != NULL)
+		VPH32_PHYS_PAGE(cpu->cd.DYNTRANS_ARCH.l1_32, index) = ppp;
 #else
 	if (l3->host_load[x3] != NULL)
 		l3->phys_page[x3] = ppp;
@@ -829,9 +831,9 @@ void DYNTRANS_PC_TO_POINTERS_FUNC(struct cpu *cpu)
 	struct DYNTRANS_TC_PHYSPAGE *ppp;
 
 #ifdef MODE32
-	int index;
+	uint32_t index;
 	index = DYNTRANS_ADDR_TO_PAGENR(cached_pc);
-	ppp = cpu->cd.DYNTRANS_ARCH.phys_page[index];
+	ppp = VPH32_PHYS_PAGE(cpu->cd.DYNTRANS_ARCH.l1_32, index);
 	if (ppp != NULL)
 		goto have_it;
 #else
@@ -897,10 +899,14 @@ static void instr32(end_of_page2)(struct cpu *,struct DYNTRANS_IC *);
  *  XXX_init_tables():
  *
  *  Initializes the default translation page (for newly allocated pages), and
- *  for 64-bit emulation it also initializes 64-bit dummy tables and pointers.
+ *  the dummy tables and pointers used for 32-bit and 64-bit virtual address
+ *  translation.
  */
 void DYNTRANS_INIT_TABLES(struct cpu *cpu)
 {
+#if defined(MODE32) || defined(DYNTRANS_DUALMODE_32)
+	struct DYNTRANS_L2_32_TABLE *dummy_l2_32;
+#endif
 #ifndef MODE32
 	struct DYNTRANS_L2_64_TABLE *dummy_l2;
 	struct DYNTRANS_L3_64_TABLE *dummy_l3;
@@ -939,6 +945,30 @@ void DYNTRANS_INIT_TABLES(struct cpu *cpu)
 	cpu->cd.DYNTRANS_ARCH.physpage_template = ppp;
 
 
+	/*
+	 *  Prepare 32-bit virtual address translation tables:
+	 *
+	 *  Note: The cpu_new function of some architectures write to memory
+	 *  before the tables are initialized. Any l2 tables allocated at
+	 *  that time (while the dummy table pointer was still NULL) are kept.
+	 */
+#if defined(MODE32) || defined(DYNTRANS_DUALMODE_32)
+	dummy_l2_32 = (struct DYNTRANS_L2_32_TABLE *) zeroed_alloc(
+	    sizeof(struct DYNTRANS_L2_32_TABLE));
+
+	cpu->cd.DYNTRANS_ARCH.l2_32_dummy = dummy_l2_32;
+
+	for (i = 0; i < (1 << DYNTRANS_L1N_32); i ++) {
+		if (cpu->cd.DYNTRANS_ARCH.l1_32[i] == NULL)
+			cpu->cd.DYNTRANS_ARCH.l1_32[i] = dummy_l2_32;
+#ifdef DYNTRANS_M88K
+		if (cpu->cd.DYNTRANS_ARCH.l1_32_usr[i] == NULL)
+			cpu->cd.DYNTRANS_ARCH.l1_32_usr[i] = dummy_l2_32;
+#endif
+	}
+#endif
+
+
 	/*  Prepare 64-bit virtual address translation tables:  */
 #ifndef MODE32
 	if (cpu->is_32bit)
@@ -981,24 +1011,45 @@ static void DYNTRANS_INVALIDATE_TLB_ENTRY(struct cpu *cpu,
 {
 #ifdef MODE32
 	uint32_t index = DYNTRANS_ADDR_TO_PAGENR(vaddr_page);
+	uint32_t x2 = VPH32_L2_INDEX(index);
+	struct DYNTRANS_L2_32_TABLE *l2;
 
 #ifdef DYNTRANS_ARM
 	cpu->cd.DYNTRANS_ARCH.is_userpage[index >> 5] &= ~(1 << (index & 31));
 #endif
 
+	l2 = VPH32_L2_TABLE(cpu->cd.DYNTRANS_ARCH.l1_32, index);
+	if (l2 == cpu->cd.DYNTRANS_ARCH.l2_32_dummy)
+		return;
+
 	if (flags & JUST_MARK_AS_NON_WRITABLE) {
 		/*  printf("JUST MARKING NON-W: vaddr 0x%08x\n",
 		    (int)vaddr_page);  */
-		cpu->cd.DYNTRANS_ARCH.host_store[index] = NULL;
+		l2->host_store[x2] = NULL;
 	} else {
-		int tlbi = cpu->cd.DYNTRANS_ARCH.vaddr_to_tlbindex[index];
-		cpu->cd.DYNTRANS_ARCH.host_load[index] = NULL;
-		cpu->cd.DYNTRANS_ARCH.host_store[index] = NULL;
-		cpu->cd.DYNTRANS_ARCH.phys_addr[index] = 0;
-		cpu->cd.DYNTRANS_ARCH.phys_page[index] = NULL;
-		if (tlbi > 0)
+		int tlbi = l2->vaddr_to_tlbindex[x2];
+		l2->host_load[x2] = NULL;
+		l2->host_store[x2] = NULL;
+		l2->phys_addr[x2] = 0;
+		l2->phys_page[x2] = NULL;
+		if (tlbi > 0) {
 			cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[tlbi-1].valid = 0;
-		cpu->cd.DYNTRANS_ARCH.vaddr_to_tlbindex[index] = 0;
+			l2->refcount --;
+		}
+		l2->vaddr_to_tlbindex[x2] = 0;
+
+		if (l2->refcount < 0) {
+			fatal("xxx_invalidate_tlb_entry(): Refcount bug L2_32.\n");
+			exit(1);
+		}
+
+		/*  Return unused tables to the freelist:  */
+		if (l2->refcount == 0) {
+			l2->next = cpu->cd.DYNTRANS_ARCH.next_free_l2_32;
+			cpu->cd.DYNTRANS_ARCH.next_free_l2_32 = l2;
+			VPH32_L2_TABLE(cpu->cd.DYNTRANS_ARCH.l1_32, index) =
+			    cpu->cd.DYNTRANS_ARCH.l2_32_dummy;
+		}
 	}
 #else
 	const uint32_t mask1 = (1 << DYNTRANS_L1N) - 1;
@@ -1397,7 +1448,8 @@ void DYNTRANS_INVALIDATE_TC_CODE(struct cpu *cpu, uint64_t addr, int flags)
 #ifdef MODE32
 				uint32_t index =
 				    DYNTRANS_ADDR_TO_PAGENR(vaddr_page);
-				cpu->cd.DYNTRANS_ARCH.phys_page[index] = NULL;
+				VPH32_PHYS_PAGE(cpu->cd.DYNTRANS_ARCH.l1_32,
+				    index) = NULL;
 #else
 				const uint32_t mask1 = (1 << DYNTRANS_L1N) - 1;
 				const uint32_t mask2 = (1 << DYNTRANS_L2N) - 1;
@@ -1435,7 +1487,8 @@ void DYNTRANS_UPDATE_TRANSLATION_TABLE(struct cpu *cpu, uint64_t vaddr_page,
 	int found, r, useraccess = 0;
 
 #ifdef MODE32
-	uint32_t index;
+	uint32_t index, x2;
+	struct DYNTRANS_L2_32_TABLE *l2;
 	vaddr_page &= 0xffffffffULL;
 
 	if (paddr_page > 0xffffffffULL) {
@@ -1488,8 +1541,13 @@ void DYNTRANS_UPDATE_TRANSLATION_TABLE(struct cpu *cpu, uint64_t vaddr_page,
 	 *          for the entry with the lowest time stamp, just choosing
 	 *          one at random will work as well.
 	 */
-	found = (int)cpu->cd.DYNTRANS_ARCH.vaddr_to_tlbindex[
-	    DYNTRANS_ADDR_TO_PAGENR(vaddr_page)] - 1;
+	index = DYNTRANS_ADDR_TO_PAGENR(vaddr_page);
+	x2 = VPH32_L2_INDEX(index);
+	l2 = VPH32_L2_TABLE(cpu->cd.DYNTRANS_ARCH.l1_32, index);
+	if (l2 == cpu->cd.DYNTRANS_ARCH.l2_32_dummy)
+		found = -1;
+	else
+		found = (int)l2->vaddr_to_tlbindex[x2] - 1;
 #else
 	x1 = (vaddr_page >> (64-DYNTRANS_L1N)) & mask1;
 	x2 = (vaddr_page >> (64-DYNTRANS_L1N-DYNTRANS_L2N)) & mask2;
@@ -1529,13 +1587,31 @@ void DYNTRANS_UPDATE_TRANSLATION_TABLE(struct cpu *cpu, uint64_t vaddr_page,
 
 		/*  Add the new translation to the table:  */
 #ifdef MODE32
-		index = DYNTRANS_ADDR_TO_PAGENR(vaddr_page);
-		cpu->cd.DYNTRANS_ARCH.host_load[index] = host_page;
-		cpu->cd.DYNTRANS_ARCH.host_store[index] =
-		    writeflag? host_page : NULL;
-		cpu->cd.DYNTRANS_ARCH.phys_addr[index] = paddr_page;
-		cpu->cd.DYNTRANS_ARCH.phys_page[index] = NULL;
-		cpu->cd.DYNTRANS_ARCH.vaddr_to_tlbindex[index] = r + 1;
+		l2 = VPH32_L2_TABLE(cpu->cd.DYNTRANS_ARCH.l1_32, index);
+		if (l2 == cpu->cd.DYNTRANS_ARCH.l2_32_dummy) {
+			if (cpu->cd.DYNTRANS_ARCH.next_free_l2_32 != NULL) {
+				l2 = cpu->cd.DYNTRANS_ARCH.next_free_l2_32;
+				cpu->cd.DYNTRANS_ARCH.next_free_l2_32 =
+				    l2->next;
+			} else {
+				l2 = (struct DYNTRANS_L2_32_TABLE *)
+				    zeroed_alloc(sizeof(
+				    struct DYNTRANS_L2_32_TABLE));
+			}
+			if (l2->refcount != 0) {
+				fatal("Huh? l2_32 Refcount problem.\n");
+				exit(1);
+			}
+			VPH32_L2_TABLE(cpu->cd.DYNTRANS_ARCH.l1_32, index) =
+			    l2;
+		}
+
+		l2->host_load[x2] = host_page;
+		l2->host_store[x2] = writeflag? host_page : NULL;
+		l2->phys_addr[x2] = paddr_page;
+		l2->phys_page[x2] = NULL;
+		l2->vaddr_to_tlbindex[x2] = r + 1;
+		l2->refcount ++;
 #ifdef DYNTRANS_ARM
 		if (useraccess)
 			cpu->cd.DYNTRANS_ARCH.is_userpage[index >> 5]
@@ -1634,26 +1710,23 @@ void DYNTRANS_UPDATE_TRANSLATION_TABLE(struct cpu *cpu, uint64_t vaddr_page,
 		if (writeflag & MEM_DOWNGRADE)
 			cpu->cd.DYNTRANS_ARCH.vph_tlb_entry[r].writeflag = 0;
 #ifdef MODE32
-		index = DYNTRANS_ADDR_TO_PAGENR(vaddr_page);
-		cpu->cd.DYNTRANS_ARCH.phys_page[index] = NULL;
+		l2->phys_page[x2] = NULL;
 #ifdef DYNTRANS_ARM
 		cpu->cd.DYNTRANS_ARCH.is_userpage[index>>5] &= ~(1<<(index&31));
 		if (useraccess)
 			cpu->cd.DYNTRANS_ARCH.is_userpage[index >> 5]
 			    |= 1 << (index & 31);
 #endif
-		if (cpu->cd.DYNTRANS_ARCH.phys_addr[index] == paddr_page) {
+		if (l2->phys_addr[x2] == paddr_page) {
 			if (writeflag & MEM_WRITE)
-				cpu->cd.DYNTRANS_ARCH.host_store[index] =
-				    host_page;
+				l2->host_store[x2] = host_page;
 			if (writeflag & MEM_DOWNGRADE)
-				cpu->cd.DYNTRANS_ARCH.host_store[index] = NULL;
+				l2->host_store[x2] = NULL;
 		} else {
 			/*  Change the entire physical/host mapping:  */
-			cpu->cd.DYNTRANS_ARCH.host_load[index] = host_page;
-			cpu->cd.DYNTRANS_ARCH.host_store[index] =
-			    writeflag? host_page : NULL;
-			cpu->cd.DYNTRANS_ARCH.phys_addr[index] = paddr_page;
+			l2->host_load[x2] = host_page;
+			l2->host_store[x2] = writeflag? host_page : NULL;
+			l2->phys_addr[x2] = paddr_page;
 		}
 #else	/*  !MODE32  */
 		x1 = (vaddr_page >> (64-DYNTRANS_L1N)) & mask1;
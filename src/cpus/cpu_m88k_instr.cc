@@ -1696,7 +1696,7 @@ X(idle)
 {
 	uint32_t rY = reg(ic[0].arg[1]) + ic[0].arg[2];
 	uint32_t index = rY >> 12;
-	unsigned char *p = cpu->cd.m88k.host_load[index];
+	unsigned char *p = VPH32_HOST_LOAD(cpu->cd.m88k.l1_32, index);
 	uint32_t *p32 = (uint32_t *) p;
 	uint32_t v;
 
@@ -1738,7 +1738,7 @@ X(idle_with_tb1)
 {
 	uint32_t rY = reg(ic[1].arg[1]) + ic[1].arg[2];
 	uint32_t index = rY >> 12;
-	unsigned char *p = cpu->cd.m88k.host_load[index];
+	unsigned char *p = VPH32_HOST_LOAD(cpu->cd.m88k.l1_32, index);
 	uint32_t *p32 = (uint32_t *) p;
 	uint32_t v;
 
@@ -1769,6 +1769,101 @@ X(idle_with_tb1)
 }
 
 
+/*
+ *  st_loop:
+ *
+ *  The core of a word fill loop, as used in memset/bzero:
+ *
+ *  s:	st	rV,rA,0
+ *	subu	rN,rN,4
+ *	bcnd.n	gt0,rN,s	(or ne0)
+ *	addu	rA,rA,4
+ *
+ *  The iterations which store within the current page are performed as one
+ *  host memset (or word fill). Anything else is left to the normal st.
+ *
+ *  (The copy loops of OpenBSD's copyin() and copyout() are not combined.
+ *  They access user space with ld.usr/st.usr, and .usr pages are never
+ *  added to the host page tables, see the TODO in
+ *  m88k_update_translation_table(), so they would always fall back.)
+ */
+X(st_loop)
+{
+	uint32_t addr = reg(ic[0].arg[1]), rn = reg(ic[1].arg[0]);
+	uint32_t data = reg(ic[0].arg[0]), n, total, i, *p;
+	unsigned char *page = VPH32_HOST_STORE(cpu->cd.m88k.l1_32, addr >> 12);
+
+	/*  Fallback:  */
+	if (cpu->delay_slot || page == NULL || (addr & 3) != 0) {
+		if (cpu->byte_order == EMUL_LITTLE_ENDIAN)
+			instr(st_4_le)(cpu, ic);
+		else
+			instr(st_4_be)(cpu, ic);
+		return;
+	}
+
+	/*  Number of iterations left, or 0 for "until the end of the page":  */
+	if (ic[2].f == instr(bcnd_n_gt0))
+		total = (int32_t)rn > 0? (rn + 3) / 4 : 1;
+	else
+		total = (rn & 3) == 0? rn / 4 : 0;
+
+	n = (0x1000 - (addr & 0xfff)) / sizeof(uint32_t);
+	if (total != 0 && n > total)
+		n = total;
+
+	if (cpu->byte_order == EMUL_LITTLE_ENDIAN)
+		data = LE32_TO_HOST(data);
+	else
+		data = BE32_TO_HOST(data);
+
+	if (data == 0 || data == 0xffffffff)
+		memset(page + (addr & 0xfff), data & 0xff, n * sizeof(uint32_t));
+	else {
+		p = (uint32_t *) (page + (addr & 0xfff));
+		for (i=0; i<n; i++)
+			p[i] = data;
+	}
+
+	reg(ic[0].arg[1]) = addr + n * sizeof(uint32_t);
+	reg(ic[1].arg[0]) = rn - n * sizeof(uint32_t);
+
+	cpu->n_translated_instrs += 4 * n - 1;
+	cpu->cd.m88k.next_ic = n == total? &ic[4] : &ic[0];
+}
+
+
+/*
+ *  Combine: a word fill loop, ending with addu in the delay slot of a
+ *  bcnd.n. See st_loop above.
+ */
+void COMBINE(st_loop)(struct cpu *cpu, struct m88k_instr_call *ic,
+	int low_addr)
+{
+	int n_back = (low_addr >> M88K_INSTR_ALIGNMENT_SHIFT)
+	    & (M88K_IC_ENTRIES_PER_PAGE-1);
+	size_t ra = ic[0].arg[0], rn = ic[-2].arg[0];
+
+	if (n_back < 3)
+		return;
+
+	if ((ic[-3].f == instr(st_4_be) || ic[-3].f == instr(st_4_le)) &&
+	    ic[-3].arg[1] == ra && ic[-3].arg[2] == 0 &&
+	    ic[-2].f == instr(subu_imm) && ic[-2].arg[1] == rn &&
+	    ic[-2].arg[2] == 4 &&
+	    (ic[-1].f == instr(bcnd_n_gt0) || ic[-1].f == instr(bcnd_n_ne0)) &&
+	    ic[-1].arg[0] == rn &&
+	    ic[-1].arg[2] == (size_t) (low_addr - 3 * sizeof(uint32_t)) &&
+	    ic[0].f == instr(addu_imm) && ic[0].arg[1] == ra &&
+	    ic[0].arg[2] == 4 &&
+	    ra != rn && ic[-3].arg[0] != ra && ic[-3].arg[0] != rn &&
+	    rn != (size_t) &cpu->cd.m88k.r[M88K_ZERO_REG] &&
+	    ra != (size_t) &cpu->cd.m88k.r[M88K_ZERO_REG]) {
+		ic[-3].f = instr(st_loop);
+	}
+}
+
+
 /*****************************************************************************/
 
 
@@ -1933,7 +2028,7 @@ X(to_be_translated)
 	addr &= ~((1 << M88K_INSTR_ALIGNMENT_SHIFT) - 1);
 
 	/*  Read the instruction word from memory:  */
-	page = cpu->cd.m88k.host_load[(uint32_t)addr >> 12];
+	page = VPH32_HOST_LOAD(cpu->cd.m88k.l1_32, (uint32_t)addr >> 12);
 
 	if (page != NULL) {
 		/*  fatal("TRANSLATION HIT!\n");  */
@@ -2106,6 +2201,9 @@ X(to_be_translated)
 
 		if (d == M88K_ZERO_REG)
 			ic->f = instr(nop);
+
+		if (ic->f == instr(addu_imm))
+			cpu->cd.m88k.combination_check = COMBINE(st_loop);
 		break;
 
 	case 0x20:
@@ -244,15 +244,15 @@ void LS_N(struct cpu *cpu, struct m88k_instr_call *ic)
 
 #ifdef LS_USR
 #ifdef LS_LOAD
-	uint8_t *p = cpu->cd.m88k.host_load_usr[addr >> 12];
+	uint8_t *p = VPH32_HOST_LOAD(cpu->cd.m88k.l1_32_usr, addr >> 12);
 #else
-	uint8_t *p = cpu->cd.m88k.host_store_usr[addr >> 12];
+	uint8_t *p = VPH32_HOST_STORE(cpu->cd.m88k.l1_32_usr, addr >> 12);
 #endif
 #else
 #ifdef LS_LOAD
-	uint8_t *p = cpu->cd.m88k.host_load[addr >> 12];
+	uint8_t *p = VPH32_HOST_LOAD(cpu->cd.m88k.l1_32, addr >> 12);
 #else
-	uint8_t *p = cpu->cd.m88k.host_store[addr >> 12];
+	uint8_t *p = VPH32_HOST_STORE(cpu->cd.m88k.l1_32, addr >> 12);
 #endif
 #endif
 
@@ -36,6 +36,7 @@
 #include "cop0.h"
 #include "cpu.h"
 #include "cpu_mips.h"
+#include "cpu_mips_coproc.h"
 #include "emul.h"
 #include "float_emul.h"
 #include "machine.h"
@@ -1012,20 +1013,18 @@ static const char *ccname[16] = {
 #define	FPU_OP_C	8
 #define	FPU_OP_ABS	9
 #define	FPU_OP_NEG	10
+#define	FPU_OP_TRUNC	11
 /*  TODO: CEIL.L, CEIL.W, FLOOR.L, FLOOR.W, RECIP, ROUND.L, ROUND.W, RSQRT  */
 
 
 /*
- *  fpu_store_float_value():
+ *  fpu_store_raw_value():
  *
- *  Stores a float value (actually a double) in fmt format.
+ *  Stores a value, already in binary fmt format, in register fd.
  */
-static void fpu_store_float_value(struct mips_coproc *cp, int fd,
-	double nf, int fmt, int nan)
+static void fpu_store_raw_value(struct mips_coproc *cp, int fd,
+	uint64_t r, int fmt)
 {
-	int ieee_fmt = mips_fmt_to_ieee_fmt[fmt];
-	uint64_t r = ieee_store_float_value(nf, ieee_fmt, nan);
-
 	/*
 	 *  TODO: This is for 32-bit mode. It has to be updated later
 	 *        for 64-bit coprocessor functionality!
@@ -1047,6 +1046,108 @@ static void fpu_store_float_value(struct mips_coproc *cp, int fd,
 }
 
 
+/*
+ *  fpu_store_float_value():
+ *
+ *  Stores a float value (actually a double) in fmt format.
+ */
+static void fpu_store_float_value(struct mips_coproc *cp, int fd,
+	double nf, int fmt, int nan)
+{
+	int ieee_fmt = mips_fmt_to_ieee_fmt[fmt];
+
+	fpu_store_raw_value(cp, fd, ieee_store_float_value(nf, ieee_fmt, nan),
+	    fmt);
+}
+
+
+/*
+ *  fpu_read_raw_value():
+ *
+ *  Returns the binary contents of register r (or register pair r, r+1) in
+ *  fmt format.
+ */
+static uint64_t fpu_read_raw_value(struct mips_coproc *cp, int r, int fmt)
+{
+	uint64_t v = cp->reg[r];
+
+	/*  TODO: register-pair mode and plain register mode? "FR" bit?  */
+	if (fmt == COP1_FMT_D || fmt == COP1_FMT_L)
+		v = (v & 0xffffffffULL) + (cp->reg[(r + 1) & 31] << 32);
+
+	return v;
+}
+
+
+/*
+ *  fpu_op_exact():
+ *
+ *  Like fpu_op(), but using the bit-exact software arithmetic from
+ *  float_emul.cc. The cause bits in the FCSR are updated. If any of the
+ *  exceptions that occurred is enabled in the FCSR (or the operation is
+ *  unimplemented), fd is left unchanged and a floating-point exception is
+ *  caused, and -1 is returned. Otherwise, the result is stored, and the
+ *  sticky flag bits accumulate the exceptions that occurred.
+ */
+static int fpu_op_exact(struct cpu *cpu, struct mips_coproc *cp, int op,
+	int fmt, int ft, int fs, int fd, int cond, int output_fmt)
+{
+	int ieee_fmt = mips_fmt_to_ieee_fmt[fmt];
+	int rm = (cp->fcr[MIPS_FPU_FCSR] & MIPS_FCSR_RM_MASK) |
+	    IEEE_LEGACY_NANS;
+	int flags = 0, cond_true = 0, unimplemented = 0, res;
+	uint64_t a = 0, b = 0, r = 0;
+
+	if (fs >= 0)
+		a = fpu_read_raw_value(cp, fs, fmt);
+	if (ft >= 0)
+		b = fpu_read_raw_value(cp, ft, fmt);
+
+	switch (op) {
+	case FPU_OP_ADD:	r = ieee_add(a, b, ieee_fmt, rm, &flags); break;
+	case FPU_OP_SUB:	r = ieee_sub(a, b, ieee_fmt, rm, &flags); break;
+	case FPU_OP_MUL:	r = ieee_mul(a, b, ieee_fmt, rm, &flags); break;
+	case FPU_OP_DIV:	r = ieee_div(a, b, ieee_fmt, rm, &flags); break;
+	case FPU_OP_SQRT:	r = ieee_sqrt(a, ieee_fmt, rm, &flags); break;
+	case FPU_OP_TRUNC:
+		rm = IEEE_ROUND_ZERO | IEEE_LEGACY_NANS;
+		/*  Fall-through.  */
+	case FPU_OP_CVT:
+		r = ieee_convert(a, ieee_fmt, mips_fmt_to_ieee_fmt[output_fmt],
+		    rm, &flags);
+		break;
+	case FPU_OP_C:
+		/*  cond bit 3 = signaling, bits 2..0 = less, equal, unordered  */
+		res = ieee_compare(a, b, ieee_fmt, cond & 8, rm, &flags);
+		cond_true = (res == IEEE_CMP_UNORDERED && (cond & 1)) ||
+		    (res == IEEE_CMP_EQUAL && (cond & 2)) ||
+		    (res == IEEE_CMP_LESS && (cond & 4));
+		break;
+	default:
+		fatal("fpu_op_exact(): unimplemented op %i\n", op);
+		unimplemented = 1;
+	}
+
+	cp->fcr[MIPS_FPU_FCSR] &= ~MIPS_FCSR_CAUSE_MASK;
+	cp->fcr[MIPS_FPU_FCSR] |= flags << MIPS_FCSR_CAUSE_SHIFT;
+	if (unimplemented)
+		cp->fcr[MIPS_FPU_FCSR] |= MIPS_FCSR_CAUSE_UNIMPLEMENTED;
+
+	if ((flags & (cp->fcr[MIPS_FPU_FCSR] >> MIPS_FCSR_ENABLES_SHIFT)) ||
+	    unimplemented) {
+		mips_cpu_exception(cpu, EXCEPTION_FPE, 0, 0, 0, 0, 0, 0);
+		return -1;
+	}
+
+	if (op != FPU_OP_C)
+		fpu_store_raw_value(cp, fd, r, output_fmt);
+
+	cp->fcr[MIPS_FPU_FCSR] |= flags << MIPS_FCSR_FLAGS_SHIFT;
+
+	return cond_true;
+}
+
+
 /*
  *  fpu_op():
  *
@@ -1054,7 +1155,7 @@ static void fpu_store_float_value(struct mips_coproc *cp, int fd,
  *  those numbers are interpreted into local variables.
  *
  *  Only FPU_OP_C (compare) returns anything of interest, 1 for true, 0 for
- *  false.
+ *  false. In exact mode, -1 is returned if the operation trapped.
  */
 static int fpu_op(struct cpu *cpu, struct mips_coproc *cp, int op, int fmt,
 	int ft, int fs, int fd, int cond, int output_fmt)
@@ -1065,24 +1166,23 @@ static int fpu_op(struct cpu *cpu, struct mips_coproc *cp, int op, int fmt,
 	uint64_t fs_v = 0;
 	double nf;
 
+	if (cpu->machine->exact_fpu && op != FPU_OP_MOV && op != FPU_OP_ABS
+	    && op != FPU_OP_NEG)
+		return fpu_op_exact(cpu, cp, op, fmt, ft, fs, fd, cond,
+		    output_fmt);
+
 	if (fs >= 0) {
-		fs_v = cp->reg[fs];
-		/*  TODO: register-pair mode and plain
-		    register mode? "FR" bit?  */
-		if (fmt == COP1_FMT_D || fmt == COP1_FMT_L)
-			fs_v = (fs_v & 0xffffffffULL) +
-			    (cp->reg[(fs + 1) & 31] << 32);
+		fs_v = fpu_read_raw_value(cp, fs, fmt);
 		ieee_interpret_float_value(fs_v, &float_value[0], ieee_fmt);
 	}
-	if (ft >= 0) {
-		uint64_t v = cp->reg[ft];
-		/*  TODO: register-pair mode and
-		    plain register mode? "FR" bit?  */
-		if (fmt == COP1_FMT_D || fmt == COP1_FMT_L)
-			v = (v & 0xffffffffULL) +
-			    (cp->reg[(ft + 1) & 31] << 32);
-		ieee_interpret_float_value(v, &float_value[1], ieee_fmt);
-	}
+	if (ft >= 0)
+		ieee_interpret_float_value(fpu_read_raw_value(cp, ft, fmt),
+		    &float_value[1], ieee_fmt);
+
+	/*  Round results the way the guest has asked for:  */
+	if (op != FPU_OP_C)
+		ieee_set_rounding_mode(cp->fcr[MIPS_FPU_FCSR] &
+		    MIPS_FCSR_RM_MASK);
 
 	switch (op) {
 	case FPU_OP_ADD:
@@ -1145,6 +1245,7 @@ static int fpu_op(struct cpu *cpu, struct mips_coproc *cp, int op, int fmt,
 		    float_value[0].nan);
 		break;
 	case FPU_OP_CVT:
+	case FPU_OP_TRUNC:
 		nf = float_value[0].f;
 		/*  debug("  mov: %f => %f\n", float_value[0].f, nf);  */
 		fpu_store_float_value(cp, fd, nf, output_fmt,
@@ -1222,6 +1323,7 @@ case 15:return !(float_value[0].f > float_value[1].f);	/*  Not greater than  */
 		fatal("fpu_op(): unimplemented op %i\n", op);
 	}
 
+	ieee_set_rounding_mode(IEEE_ROUND_NEAREST);
 	return 0;
 }
 
@@ -1375,9 +1477,7 @@ static int fpu_function(struct cpu *cpu, struct mips_coproc *cp,
 		if (unassemble_only)
 			return 1;
 
-		/*  TODO: not CVT?  */
-
-		fpu_op(cpu, cp, FPU_OP_CVT, fmt, -1, fs, fd, -1, COP1_FMT_L);
+		fpu_op(cpu, cp, FPU_OP_TRUNC, fmt, -1, fs, fd, -1, COP1_FMT_L);
 		return 1;
 	}
 
@@ -1388,9 +1488,7 @@ static int fpu_function(struct cpu *cpu, struct mips_coproc *cp,
 		if (unassemble_only)
 			return 1;
 
-		/*  TODO: not CVT?  */
-
-		fpu_op(cpu, cp, FPU_OP_CVT, fmt, -1, fs, fd, -1, COP1_FMT_W);
+		fpu_op(cpu, cp, FPU_OP_TRUNC, fmt, -1, fs, fd, -1, COP1_FMT_W);
 		return 1;
 	}
 
@@ -1407,6 +1505,8 @@ static int fpu_function(struct cpu *cpu, struct mips_coproc *cp,
 
 		cond_true = fpu_op(cpu, cp, FPU_OP_C, fmt,
 		    ft, fs, -1, cond, fmt);
+		if (cond_true < 0)
+			return 1;
 
 		/*
 		 *  Both the FCCR and FCSR contain condition code bits:
@@ -2233,3 +2333,114 @@ void coproc_function(struct cpu *cpu, struct mips_coproc *cp, int cpnr,
 	mips_cpu_exception(cpu, EXCEPTION_CPU, 0, 0, cp->coproc_nr, 0, 0, 0);
 }
 
+
+
+/*****************************************************************************/
+
+
+#ifdef WITHUNITTESTS
+
+#include "UnitTest.h"
+
+extern int quiet_mode;
+
+/*
+ *  mips_coproc_test_setup():
+ *
+ *  Create a minimal MIPS machine with an R4000 cpu, using the exact FPU.
+ *  Returns the machine's only cpu. (Machines are never destroyed; see
+ *  memory_test_setup() in memory.cc.)
+ */
+static struct cpu *mips_coproc_test_setup()
+{
+	static struct emul *emul = NULL;
+	struct machine *m;
+	int old_quiet_mode = quiet_mode;
+
+	if (emul == NULL)
+		emul = emul_new(NULL);
+
+	m = emul_add_machine(emul, NULL);
+
+	quiet_mode = 1;
+	m->arch = ARCH_MIPS;
+	m->exact_fpu = 1;
+	m->physical_ram_in_mb = 4;
+	m->memory = memory_new(4 * 1048576, m->arch);
+
+	m->ncpus = 1;
+	CHECK_ALLOCATION(m->cpus = (struct cpu **)
+	    malloc(sizeof(struct cpu *)));
+	m->cpus[0] = cpu_new(m->memory, m, 0, (char *) "R4000");
+	quiet_mode = old_quiet_mode;
+
+	m->cpus[0]->pc = (int32_t) 0x80001000;
+	return m->cpus[0];
+}
+
+/*  div.s f6,f2,f4, with f2 = 1.0 and f4 = 0.0:  */
+static void mips_coproc_test_div_by_zero(struct cpu *cpu, uint32_t fcsr)
+{
+	struct mips_coproc *cp = cpu->cd.mips.coproc[1];
+
+	cp->reg[2] = 0x3f800000;
+	cp->reg[4] = 0;
+	cp->reg[6] = 0x12345678;
+	cp->fcr[MIPS_FPU_FCSR] = fcsr;
+	cpu->cd.mips.coproc[0]->reg[COP0_CAUSE] = 0;
+
+	coproc_function(cpu, cp, 1, 0x46041183, 0, 1);
+}
+
+static void Test_cpu_mips_coproc_ExactFPU_Flags()
+{
+	struct cpu *cpu = mips_coproc_test_setup();
+	struct mips_coproc *cp = cpu->cd.mips.coproc[1];
+
+	mips_coproc_test_div_by_zero(cpu, 0);
+
+	UnitTest::Assert("the result should be +infinity",
+	    cp->reg[6] & 0xffffffff, 0x7f800000);
+	UnitTest::Assert("cause and flag bits",
+	    cp->fcr[MIPS_FPU_FCSR], (IEEE_FLAG_DIVBYZERO <<
+	    MIPS_FCSR_CAUSE_SHIFT) | (IEEE_FLAG_DIVBYZERO <<
+	    MIPS_FCSR_FLAGS_SHIFT));
+	UnitTest::Assert("no exception should have been caused",
+	    cpu->pc, (int32_t) 0x80001000);
+}
+
+static void Test_cpu_mips_coproc_ExactFPU_EnabledExceptionTraps()
+{
+	struct cpu *cpu = mips_coproc_test_setup();
+	struct mips_coproc *cp = cpu->cd.mips.coproc[1];
+	uint32_t enables = IEEE_FLAG_DIVBYZERO << MIPS_FCSR_ENABLES_SHIFT;
+
+	mips_coproc_test_div_by_zero(cpu, enables);
+
+	UnitTest::Assert("fd should be unchanged", cp->reg[6], 0x12345678);
+	UnitTest::Assert("only the cause bit should be set",
+	    cp->fcr[MIPS_FPU_FCSR], enables |
+	    (IEEE_FLAG_DIVBYZERO << MIPS_FCSR_CAUSE_SHIFT));
+	UnitTest::Assert("a floating-point exception should be caused",
+	    (cpu->cd.mips.coproc[0]->reg[COP0_CAUSE] & CAUSE_EXCCODE_MASK)
+	    >> CAUSE_EXCCODE_SHIFT, EXCEPTION_FPE);
+	UnitTest::Assert("epc", cpu->cd.mips.coproc[0]->reg[COP0_EPC],
+	    (int32_t) 0x80001000);
+
+	/*  Other enabled exceptions do not trap:  */
+	cpu->pc = (int32_t) 0x80001000;
+	mips_coproc_test_div_by_zero(cpu, IEEE_FLAG_INEXACT <<
+	    MIPS_FCSR_ENABLES_SHIFT);
+	UnitTest::Assert("the result should have been stored",
+	    cp->reg[6] & 0xffffffff, 0x7f800000);
+	UnitTest::Assert("no exception with only inexact enabled",
+	    cpu->cd.mips.coproc[0]->reg[COP0_CAUSE] & CAUSE_EXCCODE_MASK, 0);
+}
+
+UNITTESTS(cpu_mips_coproc)
+{
+	UNITTEST(Test_cpu_mips_coproc_ExactFPU_Flags);
+	UNITTEST(Test_cpu_mips_coproc_ExactFPU_EnabledExceptionTraps);
+}
+
+#endif	// WITHUNITTESTS
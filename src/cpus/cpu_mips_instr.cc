@@ -2695,6 +2695,9 @@ X(ei_r5900)
  *  s:	addiu	rX,rX,4			rX = arg[0] and arg[1]
  *	bne	rY,rX,s  (or rX,rY,s)	rt=arg[1], rs=arg[0]
  *	sw	rZ,-4(rX)		rt=arg[0], rs=arg[1]
+ *
+ *  The part of the loop which fits within the current page is performed
+ *  using a host memset (or a word fill, if rZ isn't the same byte repeated).
  */
 X(sw_loop)
 {
@@ -2702,12 +2705,14 @@ X(sw_loop)
 	uint64_t *rYp = (uint64_t *) ic[1].arg[0];
 	MODE_uint_t rY, bytes_to_write;
 	unsigned char *page;
+	uint32_t data = rZ, *p;
 	int partial = 0;
+	size_t i;
 
-	page = cpu->cd.mips.host_store[rX >> 12];
+	page = VPH32_HOST_STORE(cpu->cd.mips.l1_32, (uint32_t)rX >> 12);
 
 	/*  Fallback:  */
-	if (cpu->delay_slot || page == NULL || (rX & 3) != 0 || rZ != 0) {
+	if (cpu->delay_slot || page == NULL || (rX & 3) != 0) {
 		instr(addiu)(cpu, ic);
 		return;
 	}
@@ -2717,8 +2722,11 @@ X(sw_loop)
 
 	rY = reg(rYp);
 
+	/*  If rY can never be reached, then fill up to the end of the page
+	    (and then continue with the next page, if any).  */
 	bytes_to_write = rY - rX;
-	if ((rX & 0xfff) + bytes_to_write > 0x1000) {
+	if (bytes_to_write == 0 || (bytes_to_write & 3) != 0 ||
+	    (rX & 0xfff) + bytes_to_write > 0x1000) {
 		bytes_to_write = 0x1000 - (rX & 0xfff);
 		partial = 1;
 	}
@@ -2728,7 +2736,18 @@ X(sw_loop)
 	    printf("rZ = %08x\n", (int)rZ);
 	    printf("%i bytes\n", (int)bytes_to_write);  */
 
-	memset(page + (rX & 0xfff), 0, bytes_to_write);
+	if (cpu->byte_order == EMUL_LITTLE_ENDIAN)
+		data = LE32_TO_HOST(data);
+	else
+		data = BE32_TO_HOST(data);
+
+	if (data == (data & 0xff) * 0x01010101)
+		memset(page + (rX & 0xfff), data & 0xff, bytes_to_write);
+	else {
+		p = (uint32_t *) (page + (rX & 0xfff));
+		for (i=0; i<bytes_to_write / 4; i++)
+			p[i] = data;
+	}
 
 	reg(ic->arg[0]) = rX + bytes_to_write;
 
@@ -2742,6 +2761,84 @@ X(sw_loop)
 #ifdef MODE32
 /*  multi_{l,s}w_2, _3, etc.  */
 #include "tmp_mips_loadstore_multi.cc"
+
+
+/*
+ *  lw_sw_loop:
+ *
+ *  A word copy loop, as in NetBSD's bcopy and in compiler generated code:
+ *
+ *  s:	lw	rT,0(rS)
+ *	addiu	rS,rS,4
+ *	addiu	rD,rD,4
+ *	bne	rS,rE,s  (or rE,rS,s)
+ *	sw	rT,-4(rD)
+ *
+ *  The part of the loop where both the source and the destination are
+ *  within their current pages is performed using a host memcpy. Overlapping
+ *  ranges, and anything which could cause an exception, are left to the
+ *  normal (non-combined) instructions.
+ *
+ *  NetBSD's copyin() and copyout() set pcb_onfault and then call bcopy, so
+ *  they end up here too, and need no combinations of their own.
+ */
+X(lw_sw_loop)
+{
+	MODE_uint_t rS = reg(ic[1].arg[0]), rD = reg(ic[2].arg[0]), rE;
+	MODE_uint_t bytes_to_copy;
+	unsigned char *src_page, *dst_page, *src, *dst;
+	uint32_t last_word;
+	int partial = 0;
+
+	src_page = VPH32_HOST_LOAD(cpu->cd.mips.l1_32, (uint32_t)rS >> 12);
+	dst_page = VPH32_HOST_STORE(cpu->cd.mips.l1_32, (uint32_t)rD >> 12);
+
+	rE = reg(ic[3].arg[0] == ic[1].arg[0]? ic[3].arg[1] : ic[3].arg[0]);
+	bytes_to_copy = rE - rS;
+
+	/*  Fallback:  */
+	if (cpu->delay_slot || src_page == NULL || dst_page == NULL ||
+	    ((rS | rD) & 3) != 0 || (bytes_to_copy & 3) != 0 ||
+	    bytes_to_copy == 0) {
+		mips32_loadstore[(cpu->byte_order == EMUL_LITTLE_ENDIAN?
+		    0 : 16) + 2*2 + 1](cpu, ic);
+		return;
+	}
+
+	if ((rS & 0xfff) + bytes_to_copy > 0x1000) {
+		bytes_to_copy = 0x1000 - (rS & 0xfff);
+		partial = 1;
+	}
+	if ((rD & 0xfff) + bytes_to_copy > 0x1000) {
+		bytes_to_copy = 0x1000 - (rD & 0xfff);
+		partial = 1;
+	}
+
+	src = src_page + (rS & 0xfff);
+	dst = dst_page + (rD & 0xfff);
+	if (src < dst + bytes_to_copy && dst < src + bytes_to_copy) {
+		mips32_loadstore[(cpu->byte_order == EMUL_LITTLE_ENDIAN?
+		    0 : 16) + 2*2 + 1](cpu, ic);
+		return;
+	}
+
+	memcpy(dst, src, bytes_to_copy);
+
+	last_word = *(uint32_t *) (src + bytes_to_copy - 4);
+	if (cpu->byte_order == EMUL_LITTLE_ENDIAN)
+		last_word = LE32_TO_HOST(last_word);
+	else
+		last_word = BE32_TO_HOST(last_word);
+
+	reg(ic[0].arg[0]) = (int32_t) last_word;
+	reg(ic[1].arg[0]) = rS + bytes_to_copy;
+	reg(ic[2].arg[0]) = rD + bytes_to_copy;
+
+	cpu->n_translated_instrs += bytes_to_copy / 4 * 5 - 1;
+	cpu->cd.mips.next_ic = partial?
+	    (struct mips_instr_call *) &ic[0] :
+	    (struct mips_instr_call *) &ic[5];
+}
 #endif
 
 
@@ -2816,7 +2913,7 @@ X(netbsd_pmax_idle)
 	addr = reg(ic[0].arg[0]) + (int32_t)ic[1].arg[2];
 	pageindex = addr >> 12;
 	i = (addr & 0xfff) >> 2;
-	page = (int32_t *) cpu->cd.mips.host_load[pageindex];
+	page = (int32_t *) VPH32_HOST_LOAD(cpu->cd.mips.l1_32, pageindex);
 
 	/*  Fallback:  */
 	if (cpu->delay_slot || page == NULL || page[i] != 0)
@@ -2849,12 +2946,12 @@ X(linux_pmax_idle)
 	addr = reg(ic[0].arg[0]) + (int32_t)ic[1].arg[2];
 	pageindex = addr >> 12;
 	i = (addr & 0xfff) >> 2;
-	page = (int32_t *) cpu->cd.mips.host_load[pageindex];
+	page = (int32_t *) VPH32_HOST_LOAD(cpu->cd.mips.l1_32, pageindex);
 
 	addr2 = reg(ic[5].arg[1]) + (int32_t)ic[5].arg[2];
 	pageindex2 = addr2 >> 12;
 	i2 = (addr2 & 0xfff) >> 2;
-	page2 = (int32_t *) cpu->cd.mips.host_load[pageindex2];
+	page2 = (int32_t *) VPH32_HOST_LOAD(cpu->cd.mips.l1_32, pageindex2);
 
 	/*  Fallback:  */
 	if (cpu->delay_slot || page == NULL || page[i] != 0 || page2[i2] != 0)
@@ -2880,7 +2977,7 @@ X(netbsd_strlen)
 	uint32_t pageindex = rx >> 12;
 	int i;
 
-	page = (signed char *) cpu->cd.mips.host_load[pageindex];
+	page = (signed char *) VPH32_HOST_LOAD(cpu->cd.mips.l1_32, pageindex);
 
 	/*  Fallback:  */
 	if (cpu->delay_slot || page == NULL) {
@@ -3161,6 +3258,51 @@ void COMBINE(sw_loop)(struct cpu *cpu, struct mips_instr_call *ic, int low_addr)
 
 /*  Only for 32-bit virtual address translation so far.  */
 #ifdef MODE32
+/*
+ *  Combine:  Word copy loop (lw, addiu, addiu, bne, sw)
+ *
+ *  s:	lw	rT,0(rS)
+ *	addiu	rS,rS,4
+ *	addiu	rD,rD,4
+ *	bne	rS,rE,s
+ *	sw	rT,-4(rD)
+ */
+void COMBINE(lw_sw_loop)(struct cpu *cpu, struct mips_instr_call *ic,
+	int low_addr)
+{
+	int n_back = (low_addr >> MIPS_INSTR_ALIGNMENT_SHIFT)
+	    & (MIPS_IC_ENTRIES_PER_PAGE - 1);
+	size_t rT = ic[0].arg[0], rD = ic[0].arg[1], rS, rE;
+
+	if (n_back < 4)
+		return;
+
+	if (ic[-4].f != mips32_loadstore[(cpu->byte_order ==
+	    EMUL_LITTLE_ENDIAN? 0 : 16) + 2*2 + 1] ||
+	    ic[0].f != mips32_loadstore[(cpu->byte_order ==
+	    EMUL_LITTLE_ENDIAN? 0 : 16) + 8 + 2*2] ||
+	    ic[-3].f != instr(addiu) || ic[-2].f != instr(addiu) ||
+	    ic[-1].f != instr(bne_samepage))
+		return;
+
+	rS = ic[-4].arg[1];
+	rE = ic[-1].arg[0] == rS? ic[-1].arg[1] : ic[-1].arg[0];
+
+	if (ic[-4].arg[0] == rT && (int32_t)ic[-4].arg[2] == 0 &&
+	    ic[-3].arg[0] == rS && ic[-3].arg[1] == rS &&
+	    (int32_t)ic[-3].arg[2] == 4 &&
+	    ic[-2].arg[0] == rD && ic[-2].arg[1] == rD &&
+	    (int32_t)ic[-2].arg[2] == 4 &&
+	    (ic[-1].arg[0] == rS || ic[-1].arg[1] == rS) &&
+	    ic[-1].arg[2] == (size_t) &ic[-4] &&
+	    (int32_t)ic[0].arg[2] == -4 &&
+	    rS != rD && rS != rT && rS != rE && rD != rT && rD != rE &&
+	    rT != rE) {
+		ic[-4].f = instr(lw_sw_loop);
+	}
+}
+
+
 /*
  *  Combine:  Multiple SW in a row using the same base register
  *
@@ -3208,6 +3350,22 @@ void COMBINE(multi_sw)(struct cpu *cpu, struct mips_instr_call *ic,
 #endif
 
 
+#ifdef MODE32
+/*
+ *  Combine:  Store word
+ *
+ *  Memory fill and copy loops end with a sw in the delay slot of the
+ *  loop's branch. Otherwise, check for multiple stores in a row.
+ */
+void COMBINE(sw)(struct cpu *cpu, struct mips_instr_call *ic, int low_addr)
+{
+	COMBINE(sw_loop)(cpu, ic, low_addr);
+	COMBINE(lw_sw_loop)(cpu, ic, low_addr);
+	COMBINE(multi_sw)(cpu, ic, low_addr);
+}
+#endif
+
+
 /*  Only for 32-bit virtual address translation so far.  */
 #ifdef MODE32
 /*
@@ -3551,7 +3709,7 @@ X(to_be_translated)
 
 	/*  Read the instruction word from memory:  */
 #ifdef MODE32
-	page = cpu->cd.mips.host_load[(uint32_t)addr >> 12];
+	page = VPH32_HOST_LOAD(cpu->cd.mips.l1_32, (uint32_t)addr >> 12);
 #else
 	{
 		const uint32_t mask1 = (1 << DYNTRANS_L1N) - 1;
@@ -4618,7 +4776,7 @@ X(to_be_translated)
 		if (main_opcode == HI6_LW)
 			cpu->cd.mips.combination_check = COMBINE(multi_lw);
 		if (main_opcode == HI6_SW)
-			cpu->cd.mips.combination_check = COMBINE(multi_sw);
+			cpu->cd.mips.combination_check = COMBINE(sw);
 #endif
 		break;
 
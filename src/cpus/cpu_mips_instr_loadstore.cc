@@ -117,9 +117,9 @@ void LS_N(struct cpu *cpu, struct mips_instr_call *ic)
 	unsigned char *p;
 #ifdef MODE32
 #ifdef LS_LOAD
-	p = cpu->cd.mips.host_load[addr >> 12];
+	p = VPH32_HOST_LOAD(cpu->cd.mips.l1_32, addr >> 12);
 #else
-	p = cpu->cd.mips.host_store[addr >> 12];
+	p = VPH32_HOST_STORE(cpu->cd.mips.l1_32, addr >> 12);
 #endif
 #else	/*  !MODE32  */
 	const uint32_t mask1 = (1 << DYNTRANS_L1N) - 1;
@@ -832,7 +832,8 @@ X(dcbz)
 		int to_clear = cacheline_size < sizeof(cacheline)?
 		    cacheline_size : sizeof(cacheline);
 #ifdef MODE32
-		unsigned char *page = cpu->cd.ppc.host_store[addr >> 12];
+		unsigned char *page =
+		    VPH32_HOST_STORE(cpu->cd.ppc.l1_32, addr >> 12);
 		if (page != NULL) {
 			memset(page + (addr & 0xfff), 0, to_clear);
 		} else
@@ -2673,6 +2674,142 @@ X(tlbld)
 /*****************************************************************************/
 
 
+#ifdef MODE32
+/*
+ *  stwu_bdnz:
+ *
+ *  The core of a word fill loop, as used in NetBSD's and Linux' memset:
+ *
+ *  s:	stwu	rS,4(rA)
+ *	bdnz	s
+ *
+ *  The iterations which store within the current page are performed as one
+ *  host memset (or word fill). Anything else is left to the normal stwu.
+ */
+X(stwu_bdnz)
+{
+	uint32_t addr = reg(ic->arg[1]) + 4, data = reg(ic->arg[0]), *p;
+	uint64_t ctr = cpu->cd.ppc.spr[SPR_CTR], n, i;
+	unsigned char *page = VPH32_HOST_STORE(cpu->cd.ppc.l1_32, addr >> 12);
+
+	if (page == NULL || (addr & 3) != 0 || ctr == 0) {
+		instr(stwu)(cpu, ic);
+		return;
+	}
+
+	n = (0x1000 - (addr & 0xfff)) / sizeof(uint32_t);
+	if (n > ctr)
+		n = ctr;
+
+	data = BE32_TO_HOST(data);
+	if (data == 0 || data == 0xffffffff)
+		memset(page + (addr & 0xfff), data & 0xff, n * sizeof(uint32_t));
+	else {
+		p = (uint32_t *) (page + (addr & 0xfff));
+		for (i=0; i<n; i++)
+			p[i] = data;
+	}
+
+	reg(ic->arg[1]) = addr + (n - 1) * sizeof(uint32_t);
+	cpu->cd.ppc.spr[SPR_CTR] = ctr - n;
+
+	cpu->n_translated_instrs += 2 * n - 1;
+	cpu->cd.ppc.next_ic = ctr == n? &ic[2] : &ic[0];
+}
+
+
+/*
+ *  lwzu_stwu_bdnz:
+ *
+ *  The core of a word copy loop, as used in Linux' memcpy:
+ *
+ *  s:	lwzu	rT,4(rS)
+ *	stwu	rT,4(rD)
+ *	bdnz	s
+ *
+ *  The iterations where both the source and the destination are within their
+ *  current pages are performed as one host memcpy, unless the ranges
+ *  overlap. Anything else is left to the normal lwzu.
+ */
+X(lwzu_stwu_bdnz)
+{
+	uint32_t src_addr = reg(ic[0].arg[1]) + 4;
+	uint32_t dst_addr = reg(ic[1].arg[1]) + 4, last_word;
+	uint64_t ctr = cpu->cd.ppc.spr[SPR_CTR], n, n_dst;
+	unsigned char *src_page, *dst_page, *src, *dst;
+
+	src_page = VPH32_HOST_LOAD(cpu->cd.ppc.l1_32, src_addr >> 12);
+	dst_page = VPH32_HOST_STORE(cpu->cd.ppc.l1_32, dst_addr >> 12);
+
+	if (src_page == NULL || dst_page == NULL || ctr == 0 ||
+	    ((src_addr | dst_addr) & 3) != 0) {
+		instr(lwzu)(cpu, ic);
+		return;
+	}
+
+	n = (0x1000 - (src_addr & 0xfff)) / sizeof(uint32_t);
+	n_dst = (0x1000 - (dst_addr & 0xfff)) / sizeof(uint32_t);
+	if (n > n_dst)
+		n = n_dst;
+	if (n > ctr)
+		n = ctr;
+
+	src = src_page + (src_addr & 0xfff);
+	dst = dst_page + (dst_addr & 0xfff);
+	if (src < dst + n * sizeof(uint32_t) &&
+	    dst < src + n * sizeof(uint32_t)) {
+		instr(lwzu)(cpu, ic);
+		return;
+	}
+
+	memcpy(dst, src, n * sizeof(uint32_t));
+
+	last_word = *(uint32_t *) (src + (n - 1) * sizeof(uint32_t));
+	reg(ic[0].arg[0]) = BE32_TO_HOST(last_word);
+	reg(ic[0].arg[1]) = src_addr + (n - 1) * sizeof(uint32_t);
+	reg(ic[1].arg[1]) = dst_addr + (n - 1) * sizeof(uint32_t);
+	cpu->cd.ppc.spr[SPR_CTR] = ctr - n;
+
+	cpu->n_translated_instrs += 3 * n - 1;
+	cpu->cd.ppc.next_ic = ctr == n? &ic[3] : &ic[0];
+}
+
+
+/*
+ *  Combine: bdnz (bc_samepage with bo = 16) at the end of a fill or copy
+ *  loop. See stwu_bdnz and lwzu_stwu_bdnz above.
+ */
+void COMBINE(bdnz)(struct cpu *cpu, struct ppc_instr_call *ic, int low_addr)
+{
+	int n_back = (low_addr >> PPC_INSTR_ALIGNMENT_SHIFT)
+	    & (PPC_IC_ENTRIES_PER_PAGE - 1);
+
+	if (ic[0].f != instr(bc_samepage) || ic[0].arg[1] != 16)
+		return;
+
+	if (n_back >= 1 && ic[0].arg[0] == (size_t) &ic[-1] &&
+	    ic[-1].f == instr(stwu) && (int32_t)ic[-1].arg[2] == 4 &&
+	    ic[-1].arg[0] != ic[-1].arg[1]) {
+		ic[-1].f = instr(stwu_bdnz);
+		return;
+	}
+
+	if (n_back >= 2 && ic[0].arg[0] == (size_t) &ic[-2] &&
+	    ic[-2].f == instr(lwzu) && (int32_t)ic[-2].arg[2] == 4 &&
+	    ic[-1].f == instr(stwu) && (int32_t)ic[-1].arg[2] == 4 &&
+	    ic[-1].arg[0] == ic[-2].arg[0] &&
+	    ic[-2].arg[0] != ic[-2].arg[1] &&
+	    ic[-1].arg[0] != ic[-1].arg[1] &&
+	    ic[-2].arg[1] != ic[-1].arg[1]) {
+		ic[-2].f = instr(lwzu_stwu_bdnz);
+	}
+}
+#endif
+
+
+/*****************************************************************************/
+
+
 X(end_of_page)
 {
 	/*  Update the PC:  (offset 0, but on the next page)  */
@@ -2721,7 +2858,7 @@ X(to_be_translated)
 
 	/*  Read the instruction word from memory:  */
 #ifdef MODE32
-	page = cpu->cd.ppc.host_load[((uint32_t)addr) >> 12];
+	page = VPH32_HOST_LOAD(cpu->cd.ppc.l1_32, ((uint32_t)addr) >> 12);
 #else
 	{
 		const uint32_t mask1 = (1 << DYNTRANS_L1N) - 1;
@@ -3010,6 +3147,9 @@ X(to_be_translated)
 				    ((new_pc & mask_within_page) >> 2));
 			}
 		}
+#ifdef MODE32
+		cpu->cd.ppc.combination_check = COMBINE(bdnz);
+#endif
 		break;
 
 	case PPC_HI6_SC:
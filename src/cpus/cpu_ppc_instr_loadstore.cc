@@ -194,13 +194,12 @@ void LS_N(struct cpu *cpu, struct ppc_instr_call *ic)
 #endif
 	    ;
 
-	unsigned char *page = cpu->cd.ppc.
+	unsigned char *page =
 #ifdef LS_LOAD
-	    host_load
+	    VPH32_HOST_LOAD(cpu->cd.ppc.l1_32, (uint32_t)addr >> 12);
 #else
-	    host_store
+	    VPH32_HOST_STORE(cpu->cd.ppc.l1_32, (uint32_t)addr >> 12);
 #endif
-	    [addr >> 12];
 #ifdef LS_UPDATE
 	uint32_t new_addr = addr;
 #endif
@@ -276,6 +276,12 @@ void sh_update_interrupt_priorities(struct cpu *cpu)
 	cpu->cd.sh.int_prio_and_pending[SH_INTEVT_TMU2_TUNI2 / 0x20] |=
 	    (cpu->cd.sh.intc_ipra >> 4) & 0xf;
 
+	for (i=SH4_INTEVT_DMAC_DMTE0; i<=SH4_INTEVT_DMAC_DMAE; i+=0x20) {
+		cpu->cd.sh.int_prio_and_pending[i/0x20] &= ~SH_INT_PRIO_MASK;
+		cpu->cd.sh.int_prio_and_pending[i/0x20] |=
+		    ((cpu->cd.sh.intc_iprc >> 8) & 0xf);
+	}
+
 	for (i=SH4_INTEVT_SCIF_ERI; i<=SH4_INTEVT_SCIF_TXI; i+=0x20) {
 		cpu->cd.sh.int_prio_and_pending[i/0x20] &= ~SH_INT_PRIO_MASK;
 		cpu->cd.sh.int_prio_and_pending[i/0x20] |=
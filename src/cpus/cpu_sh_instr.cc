@@ -214,7 +214,7 @@ X(tst_imm_r0)
 X(xor_b_imm_r0_gbr)
 {
 	uint32_t addr = cpu->cd.sh.gbr + cpu->cd.sh.r[0];
-	uint8_t *p = (uint8_t *) cpu->cd.sh.host_store[addr >> 12];
+	uint8_t *p = (uint8_t *) VPH32_HOST_STORE(cpu->cd.sh.l1_32, addr >> 12);
 
 	if (p != NULL) {
 		p[addr & 0xfff] ^= ic->arg[0];
@@ -237,7 +237,7 @@ X(xor_b_imm_r0_gbr)
 X(or_b_imm_r0_gbr)
 {
 	uint32_t addr = cpu->cd.sh.gbr + cpu->cd.sh.r[0];
-	uint8_t *p = (uint8_t *) cpu->cd.sh.host_store[addr >> 12];
+	uint8_t *p = (uint8_t *) VPH32_HOST_STORE(cpu->cd.sh.l1_32, addr >> 12);
 
 	if (p != NULL) {
 		p[addr & 0xfff] |= ic->arg[0];
@@ -260,7 +260,7 @@ X(or_b_imm_r0_gbr)
 X(and_b_imm_r0_gbr)
 {
 	uint32_t addr = cpu->cd.sh.gbr + cpu->cd.sh.r[0];
-	uint8_t *p = (uint8_t *) cpu->cd.sh.host_store[addr >> 12];
+	uint8_t *p = (uint8_t *) VPH32_HOST_STORE(cpu->cd.sh.l1_32, addr >> 12);
 
 	if (p != NULL) {
 		p[addr & 0xfff] &= ic->arg[0];
@@ -310,7 +310,7 @@ X(dec_rn)     { reg(ic->arg[1]) --; }
 X(mov_b_rm_predec_rn)
 {
 	uint32_t addr = reg(ic->arg[1]) - sizeof(uint8_t);
-	int8_t *p = (int8_t *) cpu->cd.sh.host_store[addr >> 12];
+	int8_t *p = (int8_t *) VPH32_HOST_STORE(cpu->cd.sh.l1_32, addr >> 12);
 	int8_t data = reg(ic->arg[0]);
 	if (p != NULL) {
 		p[addr & 0xfff] = data;
@@ -329,7 +329,8 @@ X(mov_b_rm_predec_rn)
 X(mov_w_rm_predec_rn)
 {
 	uint32_t addr = reg(ic->arg[1]) - sizeof(uint16_t);
-	uint16_t *p = (uint16_t *) cpu->cd.sh.host_store[addr >> 12];
+	uint16_t *p = (uint16_t *)
+	    VPH32_HOST_STORE(cpu->cd.sh.l1_32, addr >> 12);
 	uint16_t data = reg(ic->arg[0]);
 
 	if (cpu->byte_order == EMUL_LITTLE_ENDIAN)
@@ -354,7 +355,8 @@ X(mov_w_rm_predec_rn)
 X(mov_l_rm_predec_rn)
 {
 	uint32_t addr = reg(ic->arg[1]) - sizeof(uint32_t);
-	uint32_t *p = (uint32_t *) cpu->cd.sh.host_store[addr >> 12];
+	uint32_t *p = (uint32_t *)
+	    VPH32_HOST_STORE(cpu->cd.sh.l1_32, addr >> 12);
 	uint32_t data = reg(ic->arg[0]);
 
 	if (cpu->byte_order == EMUL_LITTLE_ENDIAN)
@@ -379,7 +381,8 @@ X(mov_l_rm_predec_rn)
 X(stc_l_rm_predec_rn_md)
 {
 	uint32_t addr = reg(ic->arg[1]) - sizeof(uint32_t);
-	uint32_t *p = (uint32_t *) cpu->cd.sh.host_store[addr >> 12];
+	uint32_t *p = (uint32_t *)
+	    VPH32_HOST_STORE(cpu->cd.sh.l1_32, addr >> 12);
 	uint32_t data = reg(ic->arg[0]);
 
 	RES_INST_IF_NOT_MD;
@@ -416,7 +419,8 @@ X(mov_l_disp_pc_rn)
 {
 	uint32_t addr = ic->arg[0] + (cpu->pc &
 	    ~((SH_IC_ENTRIES_PER_PAGE-1) << SH_INSTR_ALIGNMENT_SHIFT));
-	uint32_t *p = (uint32_t *) cpu->cd.sh.host_load[addr >> 12];
+	uint32_t *p = (uint32_t *)
+	    VPH32_HOST_LOAD(cpu->cd.sh.l1_32, addr >> 12);
 	uint32_t data;
 
 	if (p != NULL) {
@@ -460,7 +464,8 @@ X(mov_w_disp_pc_rn)
 {
 	uint32_t addr = ic->arg[0] + (cpu->pc &
 	    ~((SH_IC_ENTRIES_PER_PAGE-1) << SH_INSTR_ALIGNMENT_SHIFT));
-	uint16_t *p = (uint16_t *) cpu->cd.sh.host_load[addr >> 12];
+	uint16_t *p = (uint16_t *)
+	    VPH32_HOST_LOAD(cpu->cd.sh.l1_32, addr >> 12);
 	uint16_t data;
 
 	if (p != NULL) {
@@ -511,7 +516,7 @@ X(mov_w_disp_pc_rn)
 X(load_b_rm_rn)
 {
 	uint32_t addr = reg(ic->arg[0]);
-	uint8_t *p = (uint8_t *) cpu->cd.sh.host_load[addr >> 12];
+	uint8_t *p = (uint8_t *) VPH32_HOST_LOAD(cpu->cd.sh.l1_32, addr >> 12);
 	uint8_t data;
 
 	if (p != NULL) {
@@ -529,7 +534,7 @@ X(load_b_rm_rn)
 X(load_w_rm_rn)
 {
 	uint32_t addr = reg(ic->arg[0]);
-	int16_t *p = (int16_t *) cpu->cd.sh.host_load[addr >> 12];
+	int16_t *p = (int16_t *) VPH32_HOST_LOAD(cpu->cd.sh.l1_32, addr >> 12);
 	int16_t data;
 
 	if (p != NULL) {
@@ -551,7 +556,8 @@ X(load_w_rm_rn)
 X(load_l_rm_rn)
 {
 	uint32_t addr = reg(ic->arg[0]);
-	uint32_t *p = (uint32_t *) cpu->cd.sh.host_load[addr >> 12];
+	uint32_t *p = (uint32_t *)
+	    VPH32_HOST_LOAD(cpu->cd.sh.l1_32, addr >> 12);
 	uint32_t data;
 
 	if (p != NULL) {
@@ -574,7 +580,8 @@ X(load_l_rm_rn)
 X(fmov_rm_frn)
 {
 	uint32_t addr = reg(ic->arg[0]);
-	uint32_t *p = (uint32_t *) cpu->cd.sh.host_load[addr >> 12];
+	uint32_t *p = (uint32_t *)
+	    VPH32_HOST_LOAD(cpu->cd.sh.l1_32, addr >> 12);
 	uint32_t data;
 
 	FLOATING_POINT_AVAILABLE_CHECK;
@@ -635,7 +642,8 @@ X(fmov_rm_frn)
 X(fmov_r0_rm_frn)
 {
 	uint32_t data, addr = reg(ic->arg[0]) + cpu->cd.sh.r[0];
-	uint32_t *p = (uint32_t *) cpu->cd.sh.host_load[addr >> 12];
+	uint32_t *p = (uint32_t *)
+	    VPH32_HOST_LOAD(cpu->cd.sh.l1_32, addr >> 12);
 
 	FLOATING_POINT_AVAILABLE_CHECK;
 
@@ -667,7 +675,8 @@ X(fmov_rm_postinc_frn)
 {
 	int d = cpu->cd.sh.fpscr & SH_FPSCR_SZ;
 	uint32_t data, data2, addr = reg(ic->arg[0]);
-	uint32_t *p = (uint32_t *) cpu->cd.sh.host_load[addr >> 12];
+	uint32_t *p = (uint32_t *)
+	    VPH32_HOST_LOAD(cpu->cd.sh.l1_32, addr >> 12);
 	size_t r1 = ic->arg[1];
 
 	if (d) {
@@ -716,7 +725,7 @@ X(fmov_rm_postinc_frn)
 X(mov_b_disp_gbr_r0)
 {
 	uint32_t addr = cpu->cd.sh.gbr + ic->arg[1];
-	int8_t *p = (int8_t *) cpu->cd.sh.host_load[addr >> 12];
+	int8_t *p = (int8_t *) VPH32_HOST_LOAD(cpu->cd.sh.l1_32, addr >> 12);
 	int8_t data;
 	if (p != NULL) {
 		data = p[addr & 0xfff];
@@ -733,7 +742,7 @@ X(mov_b_disp_gbr_r0)
 X(mov_w_disp_gbr_r0)
 {
 	uint32_t addr = cpu->cd.sh.gbr + ic->arg[1];
-	int16_t *p = (int16_t *) cpu->cd.sh.host_load[addr >> 12];
+	int16_t *p = (int16_t *) VPH32_HOST_LOAD(cpu->cd.sh.l1_32, addr >> 12);
 	int16_t data;
 	if (p != NULL) {
 		data = p[(addr & 0xfff) >> 1];
@@ -754,7 +763,8 @@ X(mov_w_disp_gbr_r0)
 X(mov_l_disp_gbr_r0)
 {
 	uint32_t addr = cpu->cd.sh.gbr + ic->arg[1];
-	uint32_t *p = (uint32_t *) cpu->cd.sh.host_load[addr >> 12];
+	uint32_t *p = (uint32_t *)
+	    VPH32_HOST_LOAD(cpu->cd.sh.l1_32, addr >> 12);
 	uint32_t data;
 	if (p != NULL) {
 		data = p[(addr & 0xfff) >> 2];
@@ -775,7 +785,7 @@ X(mov_l_disp_gbr_r0)
 X(mov_b_arg1_postinc_to_arg0)
 {
 	uint32_t addr = reg(ic->arg[1]);
-	int8_t *p = (int8_t *) cpu->cd.sh.host_load[addr >> 12];
+	int8_t *p = (int8_t *) VPH32_HOST_LOAD(cpu->cd.sh.l1_32, addr >> 12);
 	int8_t data;
 	if (p != NULL) {
 		data = p[addr & 0xfff];
@@ -794,7 +804,8 @@ X(mov_b_arg1_postinc_to_arg0)
 X(mov_w_arg1_postinc_to_arg0)
 {
 	uint32_t addr = reg(ic->arg[1]);
-	uint16_t *p = (uint16_t *) cpu->cd.sh.host_load[addr >> 12];
+	uint16_t *p = (uint16_t *)
+	    VPH32_HOST_LOAD(cpu->cd.sh.l1_32, addr >> 12);
 	uint16_t data;
 
 	if (p != NULL) {
@@ -818,7 +829,8 @@ X(mov_w_arg1_postinc_to_arg0)
 X(mov_l_arg1_postinc_to_arg0)
 {
 	uint32_t addr = reg(ic->arg[1]);
-	uint32_t *p = (uint32_t *) cpu->cd.sh.host_load[addr >> 12];
+	uint32_t *p = (uint32_t *)
+	    VPH32_HOST_LOAD(cpu->cd.sh.l1_32, addr >> 12);
 	uint32_t data;
 
 	if (p != NULL) {
@@ -842,7 +854,8 @@ X(mov_l_arg1_postinc_to_arg0)
 X(mov_l_arg1_postinc_to_arg0_md)
 {
 	uint32_t addr = reg(ic->arg[1]);
-	uint32_t *p = (uint32_t *) cpu->cd.sh.host_load[addr >> 12];
+	uint32_t *p = (uint32_t *)
+	    VPH32_HOST_LOAD(cpu->cd.sh.l1_32, addr >> 12);
 	uint32_t data;
 
 	RES_INST_IF_NOT_MD;
@@ -873,7 +886,8 @@ X(mov_l_arg1_postinc_to_arg0_md)
 X(mov_l_arg1_postinc_to_arg0_fp)
 {
 	uint32_t addr = reg(ic->arg[1]);
-	uint32_t *p = (uint32_t *) cpu->cd.sh.host_load[addr >> 12];
+	uint32_t *p = (uint32_t *)
+	    VPH32_HOST_LOAD(cpu->cd.sh.l1_32, addr >> 12);
 	uint32_t data;
 
 	FLOATING_POINT_AVAILABLE_CHECK;
@@ -904,7 +918,7 @@ X(mov_l_arg1_postinc_to_arg0_fp)
 X(mov_b_r0_rm_rn)
 {
 	uint32_t addr = reg(ic->arg[0]) + cpu->cd.sh.r[0];
-	int8_t *p = (int8_t *) cpu->cd.sh.host_load[addr >> 12];
+	int8_t *p = (int8_t *) VPH32_HOST_LOAD(cpu->cd.sh.l1_32, addr >> 12);
 	int8_t data;
 
 	if (p != NULL) {
@@ -923,7 +937,7 @@ X(mov_b_r0_rm_rn)
 X(mov_w_r0_rm_rn)
 {
 	uint32_t addr = reg(ic->arg[0]) + cpu->cd.sh.r[0];
-	int16_t *p = (int16_t *) cpu->cd.sh.host_load[addr >> 12];
+	int16_t *p = (int16_t *) VPH32_HOST_LOAD(cpu->cd.sh.l1_32, addr >> 12);
 	int16_t data;
 
 	if (p != NULL) {
@@ -946,7 +960,8 @@ X(mov_w_r0_rm_rn)
 X(mov_l_r0_rm_rn)
 {
 	uint32_t addr = reg(ic->arg[0]) + cpu->cd.sh.r[0];
-	uint32_t *p = (uint32_t *) cpu->cd.sh.host_load[addr >> 12];
+	uint32_t *p = (uint32_t *)
+	    VPH32_HOST_LOAD(cpu->cd.sh.l1_32, addr >> 12);
 	uint32_t data;
 
 	if (p != NULL) {
@@ -970,7 +985,8 @@ X(mov_l_disp_rm_rn)
 {
 	uint32_t addr = cpu->cd.sh.r[ic->arg[0] & 0xf] +
 	    ((ic->arg[0] >> 4) << 2);
-	uint32_t *p = (uint32_t *) cpu->cd.sh.host_load[addr >> 12];
+	uint32_t *p = (uint32_t *)
+	    VPH32_HOST_LOAD(cpu->cd.sh.l1_32, addr >> 12);
 	uint32_t data;
 
 	if (p != NULL) {
@@ -993,7 +1009,7 @@ X(mov_l_disp_rm_rn)
 X(mov_b_disp_rn_r0)
 {
 	uint32_t addr = reg(ic->arg[0]) + ic->arg[1];
-	uint8_t *p = (uint8_t *) cpu->cd.sh.host_load[addr >> 12];
+	uint8_t *p = (uint8_t *) VPH32_HOST_LOAD(cpu->cd.sh.l1_32, addr >> 12);
 	uint8_t data;
 
 	if (p != NULL) {
@@ -1012,7 +1028,8 @@ X(mov_b_disp_rn_r0)
 X(mov_w_disp_rn_r0)
 {
 	uint32_t addr = reg(ic->arg[0]) + ic->arg[1];
-	uint16_t *p = (uint16_t *) cpu->cd.sh.host_load[addr >> 12];
+	uint16_t *p = (uint16_t *)
+	    VPH32_HOST_LOAD(cpu->cd.sh.l1_32, addr >> 12);
 	uint16_t data;
 
 	if (p != NULL) {
@@ -1058,7 +1075,7 @@ X(mov_w_disp_rn_r0)
 X(mov_b_store_rm_rn)
 {
 	uint32_t addr = reg(ic->arg[1]);
-	uint8_t *p = (uint8_t *) cpu->cd.sh.host_store[addr >> 12];
+	uint8_t *p = (uint8_t *) VPH32_HOST_STORE(cpu->cd.sh.l1_32, addr >> 12);
 	uint8_t data = reg(ic->arg[0]);
 
 	if (p != NULL) {
@@ -1075,7 +1092,8 @@ X(mov_b_store_rm_rn)
 X(mov_w_store_rm_rn)
 {
 	uint32_t addr = reg(ic->arg[1]);
-	uint16_t *p = (uint16_t *) cpu->cd.sh.host_store[addr >> 12];
+	uint16_t *p = (uint16_t *)
+	    VPH32_HOST_STORE(cpu->cd.sh.l1_32, addr >> 12);
 	uint16_t data = reg(ic->arg[0]);
 
 	if (cpu->byte_order == EMUL_LITTLE_ENDIAN)
@@ -1097,7 +1115,8 @@ X(mov_w_store_rm_rn)
 X(mov_l_store_rm_rn)
 {
 	uint32_t addr = reg(ic->arg[1]);
-	uint32_t *p = (uint32_t *) cpu->cd.sh.host_store[addr >> 12];
+	uint32_t *p = (uint32_t *)
+	    VPH32_HOST_STORE(cpu->cd.sh.l1_32, addr >> 12);
 	uint32_t data = reg(ic->arg[0]);
 
 	if (cpu->byte_order == EMUL_LITTLE_ENDIAN)
@@ -1119,7 +1138,8 @@ X(mov_l_store_rm_rn)
 X(fmov_frm_rn)
 {
 	uint32_t addr = reg(ic->arg[1]);
-	uint32_t *p = (uint32_t *) cpu->cd.sh.host_store[addr >> 12];
+	uint32_t *p = (uint32_t *)
+	    VPH32_HOST_STORE(cpu->cd.sh.l1_32, addr >> 12);
 	uint32_t data = reg(ic->arg[0]);
 
 	FLOATING_POINT_AVAILABLE_CHECK;
@@ -1168,7 +1188,8 @@ X(fmov_frm_rn)
 X(fmov_frm_r0_rn)
 {
 	uint32_t addr = reg(ic->arg[1]) + cpu->cd.sh.r[0];
-	uint32_t *p = (uint32_t *) cpu->cd.sh.host_store[addr >> 12];
+	uint32_t *p = (uint32_t *)
+	    VPH32_HOST_STORE(cpu->cd.sh.l1_32, addr >> 12);
 	uint32_t data = reg(ic->arg[0]);
 
 	FLOATING_POINT_AVAILABLE_CHECK;
@@ -1199,7 +1220,8 @@ X(fmov_frm_predec_rn)
 {
 	int d = cpu->cd.sh.fpscr & SH_FPSCR_SZ? 1 : 0;
 	uint32_t data, addr = reg(ic->arg[1]) - (d? 8 : 4);
-	uint32_t *p = (uint32_t *) cpu->cd.sh.host_store[addr >> 12];
+	uint32_t *p = (uint32_t *)
+	    VPH32_HOST_STORE(cpu->cd.sh.l1_32, addr >> 12);
 	size_t r0 = ic->arg[0];
 
 	if (d) {
@@ -1247,7 +1269,7 @@ X(fmov_frm_predec_rn)
 X(mov_b_rm_r0_rn)
 {
 	uint32_t addr = reg(ic->arg[1]) + cpu->cd.sh.r[0];
-	int8_t *p = (int8_t *) cpu->cd.sh.host_store[addr >> 12];
+	int8_t *p = (int8_t *) VPH32_HOST_STORE(cpu->cd.sh.l1_32, addr >> 12);
 	int8_t data = reg(ic->arg[0]);
 	if (p != NULL) {
 		p[addr & 0xfff] = data;
@@ -1263,7 +1285,8 @@ X(mov_b_rm_r0_rn)
 X(mov_w_rm_r0_rn)
 {
 	uint32_t addr = reg(ic->arg[1]) + cpu->cd.sh.r[0];
-	uint16_t *p = (uint16_t *) cpu->cd.sh.host_store[addr >> 12];
+	uint16_t *p = (uint16_t *)
+	    VPH32_HOST_STORE(cpu->cd.sh.l1_32, addr >> 12);
 	uint16_t data = reg(ic->arg[0]);
 
 	if (cpu->byte_order == EMUL_LITTLE_ENDIAN)
@@ -1285,7 +1308,8 @@ X(mov_w_rm_r0_rn)
 X(mov_l_rm_r0_rn)
 {
 	uint32_t addr = reg(ic->arg[1]) + cpu->cd.sh.r[0];
-	uint32_t *p = (uint32_t *) cpu->cd.sh.host_store[addr >> 12];
+	uint32_t *p = (uint32_t *)
+	    VPH32_HOST_STORE(cpu->cd.sh.l1_32, addr >> 12);
 	uint32_t data = reg(ic->arg[0]);
 
 	if (cpu->byte_order == EMUL_LITTLE_ENDIAN)
@@ -1307,7 +1331,7 @@ X(mov_l_rm_r0_rn)
 X(mov_b_r0_disp_gbr)
 {
 	uint32_t addr = cpu->cd.sh.gbr + ic->arg[1];
-	uint8_t *p = (uint8_t *) cpu->cd.sh.host_store[addr >> 12];
+	uint8_t *p = (uint8_t *) VPH32_HOST_STORE(cpu->cd.sh.l1_32, addr >> 12);
 	uint8_t data = cpu->cd.sh.r[0];
 	if (p != NULL) {
 		p[addr & 0xfff] = data;
@@ -1323,7 +1347,8 @@ X(mov_b_r0_disp_gbr)
 X(mov_w_r0_disp_gbr)
 {
 	uint32_t addr = cpu->cd.sh.gbr + ic->arg[1];
-	uint16_t *p = (uint16_t *) cpu->cd.sh.host_store[addr >> 12];
+	uint16_t *p = (uint16_t *)
+	    VPH32_HOST_STORE(cpu->cd.sh.l1_32, addr >> 12);
 	uint16_t data = cpu->cd.sh.r[0];
 
 	if (cpu->byte_order == EMUL_LITTLE_ENDIAN)
@@ -1345,7 +1370,8 @@ X(mov_w_r0_disp_gbr)
 X(mov_l_r0_disp_gbr)
 {
 	uint32_t addr = cpu->cd.sh.gbr + ic->arg[1];
-	uint32_t *p = (uint32_t *) cpu->cd.sh.host_store[addr >> 12];
+	uint32_t *p = (uint32_t *)
+	    VPH32_HOST_STORE(cpu->cd.sh.l1_32, addr >> 12);
 	uint32_t data = cpu->cd.sh.r[0];
 
 	if (cpu->byte_order == EMUL_LITTLE_ENDIAN)
@@ -1368,7 +1394,8 @@ X(mov_l_rm_disp_rn)
 {
 	uint32_t addr = cpu->cd.sh.r[ic->arg[1] & 0xf] +
 	    ((ic->arg[1] >> 4) << 2);
-	uint32_t *p = (uint32_t *) cpu->cd.sh.host_store[addr >> 12];
+	uint32_t *p = (uint32_t *)
+	    VPH32_HOST_STORE(cpu->cd.sh.l1_32, addr >> 12);
 	uint32_t data = reg(ic->arg[0]);
 
 	if (cpu->byte_order == EMUL_LITTLE_ENDIAN)
@@ -1390,7 +1417,7 @@ X(mov_l_rm_disp_rn)
 X(mov_b_r0_disp_rn)
 {
 	uint32_t addr = reg(ic->arg[0]) + ic->arg[1];
-	uint8_t *p = (uint8_t *) cpu->cd.sh.host_store[addr >> 12];
+	uint8_t *p = (uint8_t *) VPH32_HOST_STORE(cpu->cd.sh.l1_32, addr >> 12);
 	uint8_t data = cpu->cd.sh.r[0];
 
 	if (p != NULL) {
@@ -1407,7 +1434,8 @@ X(mov_b_r0_disp_rn)
 X(mov_w_r0_disp_rn)
 {
 	uint32_t addr = reg(ic->arg[0]) + ic->arg[1];
-	uint16_t *p = (uint16_t *) cpu->cd.sh.host_store[addr >> 12];
+	uint16_t *p = (uint16_t *)
+	    VPH32_HOST_STORE(cpu->cd.sh.l1_32, addr >> 12);
 	uint16_t data = cpu->cd.sh.r[0];
 
 	if (cpu->byte_order == EMUL_LITTLE_ENDIAN)
@@ -3021,7 +3049,8 @@ X(bt_samepage_wait_for_variable)
 	// mov_l_disp_gbr_r0:
 	// Bail out quickly if the memory is not on a readable page.
 	uint32_t addr = cpu->cd.sh.gbr + ic->arg[1];
-	uint32_t *p = (uint32_t *) cpu->cd.sh.host_load[addr >> 12];
+	uint32_t *p = (uint32_t *)
+	    VPH32_HOST_LOAD(cpu->cd.sh.l1_32, addr >> 12);
 	if (p == NULL) {
 		instr(mov_l_disp_gbr_r0)(cpu, ic);
 		return;
@@ -3055,6 +3084,64 @@ X(bt_samepage_wait_for_variable)
 }
 
 
+/*
+ *  mov_l_predec_loop:
+ *
+ *  The core of a descending word fill loop, as used in memset:
+ *
+ *	s:  dt     rN			dt_rn with arg[1] = rN
+ *	    bf/s   s			bf_s_samepage with arg[1] = s
+ *	    mov.l  rM,@-rA		mov_l_rm_predec_rn with rM and rA
+ *
+ *  The iterations which store within the current page are performed as one
+ *  host memset (or word fill). Anything else is left to the normal dt.
+ */
+X(mov_l_predec_loop)
+{
+	uint32_t rn = reg(ic[0].arg[1]), addr = reg(ic[2].arg[1]);
+	uint32_t data = reg(ic[2].arg[0]), n, i, *p;
+	unsigned char *page;
+
+	page = VPH32_HOST_STORE(cpu->cd.sh.l1_32, (addr - 4) >> 12);
+
+	if (cpu->delay_slot || page == NULL || (addr & 3) != 0 || rn == 0) {
+		instr(dt_rn)(cpu, ic);
+		return;
+	}
+
+	/*  Number of words below addr, within the same page:  */
+	n = (((addr - 4) & 0xfff) >> 2) + 1;
+	if (n > rn)
+		n = rn;
+
+	if (cpu->byte_order == EMUL_LITTLE_ENDIAN)
+		data = LE32_TO_HOST(data);
+	else
+		data = BE32_TO_HOST(data);
+
+	addr -= n * sizeof(uint32_t);
+	if (data == 0 || data == 0xffffffff)
+		memset(page + (addr & 0xfff), data & 0xff, n * sizeof(uint32_t));
+	else {
+		p = (uint32_t *) (page + (addr & 0xfff));
+		for (i=0; i<n; i++)
+			p[i] = data;
+	}
+
+	reg(ic[2].arg[1]) = addr;
+	reg(ic[0].arg[1]) = rn - n;
+
+	cpu->n_translated_instrs += 3 * n - 1;
+	if (rn == n) {
+		cpu->cd.sh.sr |= SH_SR_T;
+		cpu->cd.sh.next_ic = &ic[3];
+	} else {
+		cpu->cd.sh.sr &= ~SH_SR_T;
+		cpu->cd.sh.next_ic = &ic[0];
+	}
+}
+
+
 /*****************************************************************************/
 
 
@@ -3081,6 +3168,31 @@ void COMBINE(bt_samepage)(struct cpu *cpu, struct sh_instr_call *ic, int low_add
 }
 
 
+/*
+ *  Combine: a mov.l rM,@-rA in the delay slot of a bf/s.
+ *
+ *  See comment for mov_l_predec_loop above for details.
+ */
+void COMBINE(mov_l_rm_predec_rn)(struct cpu *cpu, struct sh_instr_call *ic,
+	int low_addr)
+{
+	int n_back = (low_addr >> SH_INSTR_ALIGNMENT_SHIFT)
+	    & (SH_IC_ENTRIES_PER_PAGE - 1);
+
+	if (n_back < 2)
+		return;
+
+	if (ic[-2].f == instr(dt_rn) &&
+	    ic[-1].f == instr(bf_s_samepage) &&
+	    ic[-1].arg[1] == (size_t) &ic[-2] &&
+	    ic[-2].arg[1] != ic[0].arg[0] &&
+	    ic[-2].arg[1] != ic[0].arg[1] &&
+	    ic[0].arg[0] != ic[0].arg[1]) {
+		ic[-2].f = instr(mov_l_predec_loop);
+	}
+}
+
+
 /*****************************************************************************/
 
 
@@ -3193,7 +3305,7 @@ X(to_be_translated)
 	addr &= ~((1 << SH_INSTR_ALIGNMENT_SHIFT) - 1);
 
 	/*  Read the instruction word from memory:  */
-	page = cpu->cd.sh.host_load[(uint32_t)addr >> 12];
+	page = VPH32_HOST_LOAD(cpu->cd.sh.l1_32, (uint32_t)addr >> 12);
 
 	if (page != NULL) {
 		/*  fatal("TRANSLATION HIT!\n");  */
@@ -3435,6 +3547,8 @@ X(to_be_translated)
 			break;
 		case 0x6:	/*  MOV.L Rm,@-Rn  */
 			ic->f = instr(mov_l_rm_predec_rn);
+			cpu->cd.sh.combination_check =
+			    COMBINE(mov_l_rm_predec_rn);
 			break;
 		case 0x7:	/*  DIV0S Rm,Rn  */
 			ic->f = instr(div0s_rm_rn);
@@ -111,8 +111,8 @@ void generate_opcode(uint32_t opcode)
 	if (p)
 		printf("\taddr %s 4;\n", u? "+=" : "-=");
 
-	printf("\tpage = cpu->cd.arm.host_%s[addr >> 12];\n",
-	    load? "load" : "store");
+	printf("\tpage = VPH32_HOST_%s(cpu->cd.arm.l1_32, addr >> 12);\n",
+	    load? "LOAD" : "STORE");
 
 	printf("\taddr &= 0xffc;\n");
 
@@ -88,6 +88,9 @@ int main(int argc, char *argv[])
 	    "#define DYNTRANS_L3_64_TABLE %s_l3_64_table\n", a, a);
 	printf("#endif\n");
 
+	/*  For 32-bit (and dual-mode) platforms:  */
+	printf("#define DYNTRANS_L2_32_TABLE %s_l2_32_table\n", a);
+
 	/*  Default pagesize is 4KB.  */
 	printf("#ifndef DYNTRANS_PAGESIZE\n"
 	    "#define DYNTRANS_PAGESIZE 4096\n"
@@ -48,8 +48,8 @@ void generate_multi(int store, int endianness, int n)
 	for (i=0; i<n; i++)
 		printf("\tuint32_t index%i = addr%i >> 12;\n", i, i);
 
-	printf("\tpage = (uint32_t *) cpu->cd.mips.host_%s[index0];\n",
-	    store? "store" : "load");
+	printf("\tpage = (uint32_t *) VPH32_HOST_%s(cpu->cd.mips.l1_32, "
+	    "index0);\n", store? "STORE" : "LOAD");
 
 	printf("\tif (cpu->delay_slot ||\n"
 	    "\t    page == NULL");
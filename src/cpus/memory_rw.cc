@@ -237,150 +237,160 @@ int MEMORY_RW(struct cpu *cpu, struct memory *mem, uint64_t vaddr,
 	 */
 	if (paddr >= mem->mmap_dev_minaddr && paddr < mem->mmap_dev_maxaddr) {
 		uint64_t orig_paddr = paddr;
-		int i, start, end, res;
-
-#if 0
-
-TODO: The correct solution for this is to add RAM devices _around_ the
-dangerous device. The solution below incurs a slowdown for _everything_,
-not just the device in question.
+		size_t devmap_entry = 0, *devmap = mem->devmap;
+		int i, start, end, res, shift = 64 - DEVMAP_BITS_PER_LEVEL;
+
+		/*  Look up the page in the device map:  */
+		while (devmap != NULL) {
+			devmap_entry = devmap[(paddr >> shift) &
+			    ((1 << DEVMAP_BITS_PER_LEVEL) - 1)];
+			if (devmap_entry == 0 || devmap_entry & DEVMAP_VALUE)
+				break;
+			devmap = (size_t *) devmap_entry;
+			shift -= DEVMAP_BITS_PER_LEVEL;
+		}
 
 		/*
-		 *  Really really slow, but unfortunately necessary. This is
-		 *  to avoid the folowing scenario:
-		 *
-		 *	a) offsets 0x000..0x123 are normal memory
-		 *	b) offsets 0x124..0x777 are a device
-		 *
-		 *	1) a read is done from offset 0x100. the page is
-		 *	   added to the dyntrans system as a "RAM" page
-		 *	2) a dyntranslated read is done from offset 0x200,
-		 *	   which should access the device, but since the
-		 *	   entire page is added, it will access non-existant
-		 *	   RAM instead, without warning.
-		 *
-		 *  Setting dyntrans_device_danger = 1 on accesses which are
-		 *  on _any_ offset on pages that are device mapped avoids
-		 *  this problem, but it is probably not very fast.
-		 *
-		 *  TODO: Convert this into a quick (multi-level, 64-bit)
-		 *  address space lookup, to find dangerous pages.
+		 *  Pages which are only partially covered by a device must
+		 *  not be added to the dyntrans translation tables, neither
+		 *  as device pages nor as RAM. Otherwise, a later access to
+		 *  the same page would go to the wrong place, without warning.
 		 */
-		for (i=0; i<mem->n_mmapped_devices; i++)
-			if (paddr >= (mem->devices[i].baseaddr & ~offset_mask)&&
-			    paddr <= ((mem->devices[i].endaddr-1)|offset_mask)){
-				dyntrans_device_danger = 1;
-				break;
-			}
-#endif
+		if (devmap_entry & DEVMAP_PARTIAL)
+			dyntrans_device_danger = 1;
+
+		i = (int)(devmap_entry >> DEVMAP_INDEX_SHIFT) - 1;
+
+		if (devmap_entry & DEVMAP_MULTIPLE) {
+			/*  Several devices on this page; binary search:  */
+			start = 0; end = mem->n_mmapped_devices - 1;
+			i = mem->last_accessed_device;
+
+			do {
+				if (paddr >= mem->devices[i].baseaddr &&
+				    paddr < mem->devices[i].endaddr)
+					break;
+				if (paddr < mem->devices[i].baseaddr)
+					end = i - 1;
+				if (paddr >= mem->devices[i].endaddr)
+					start = i + 1;
+				i = (start + end) >> 1;
+			} while (start <= end);
+
+			if (start > end)
+				i = -1;
+		} else if (i >= 0 && (paddr < mem->devices[i].baseaddr ||
+		    paddr >= mem->devices[i].endaddr))
+			i = -1;
+
+		if (i >= 0) {
+			/*  Found a device, let's access it:  */
+			mem->last_accessed_device = i;
+
+			paddr -= mem->devices[i].baseaddr;
+			if (paddr + len > mem->devices[i].length)
+				len = mem->devices[i].length - paddr;
+
+			if (cpu->update_translation_table != NULL &&
+			    !(ok & MEMORY_NOT_FULL_PAGE) &&
+			    !dyntrans_device_danger &&
+			    mem->devices[i].flags & DM_DYNTRANS_OK) {
+				int wf = writeflag == MEM_WRITE? 1 : 0;
+				unsigned char *host_addr;
+
+				if (!(mem->devices[i].flags &
+				    DM_DYNTRANS_WRITE_OK))
+					wf = 0;
+
+				/*  Writes through a RAM alias must go via the
+				    device (and thus be marked as dirty) while
+				    dirty pages are being tracked:  */
+				if (mem->devices[i].flags & DM_EMULATED_RAM &&
+				    mem->n_dirty_clients > 0)
+					wf = 0;
+
+				if (writeflag && wf) {
+					if (paddr < mem->devices[i].
+					    dyntrans_write_low)
+						mem->devices[i].
+						dyntrans_write_low =
+						    paddr &~offset_mask;
+					if (paddr >= mem->devices[i].
+					    dyntrans_write_high)
+						mem->devices[i].
+					 	dyntrans_write_high =
+						    paddr | offset_mask;
+				}
 
-		start = 0; end = mem->n_mmapped_devices - 1;
-		i = mem->last_accessed_device;
-
-		/*  Scan through all devices:  */
-		do {
-			if (paddr >= mem->devices[i].baseaddr &&
-			    paddr < mem->devices[i].endaddr) {
-				/*  Found a device, let's access it:  */
-				mem->last_accessed_device = i;
-
-				paddr -= mem->devices[i].baseaddr;
-				if (paddr + len > mem->devices[i].length)
-					len = mem->devices[i].length - paddr;
-
-				if (cpu->update_translation_table != NULL &&
-				    !(ok & MEMORY_NOT_FULL_PAGE) &&
-				    mem->devices[i].flags & DM_DYNTRANS_OK) {
-					int wf = writeflag == MEM_WRITE? 1 : 0;
-					unsigned char *host_addr;
-
-					if (!(mem->devices[i].flags &
-					    DM_DYNTRANS_WRITE_OK))
-						wf = 0;
-
-					if (writeflag && wf) {
-						if (paddr < mem->devices[i].
-						    dyntrans_write_low)
-							mem->devices[i].
-							dyntrans_write_low =
-							    paddr &~offset_mask;
-						if (paddr >= mem->devices[i].
-						    dyntrans_write_high)
-							mem->devices[i].
-						 	dyntrans_write_high =
-							    paddr | offset_mask;
-					}
-
-					if (mem->devices[i].flags &
-					    DM_EMULATED_RAM) {
-						/*  MEM_WRITE to force the page
-						    to be allocated, if it
-						    wasn't already  */
-						uint64_t *pp = (uint64_t *)mem->
-						    devices[i].dyntrans_data;
-						uint64_t p = orig_paddr - *pp;
+				if (mem->devices[i].flags &
+				    DM_EMULATED_RAM) {
+					uint64_t *pp = (uint64_t *)mem->
+					    devices[i].dyntrans_data;
+					uint64_t p = orig_paddr - *pp;
+
+					/*  MEM_WRITE to force the page
+					    to be allocated, if it
+					    wasn't already  */
+					host_addr =
+					    memory_paddr_to_hostaddr(
+					    mem, p & ~offset_mask,
+					    MEM_READ);
+					if (host_addr == NULL)
 						host_addr =
 						    memory_paddr_to_hostaddr(
 						    mem, p & ~offset_mask,
 						    MEM_WRITE);
-					} else {
-						host_addr = mem->devices[i].
-						    dyntrans_data +
-						    (paddr & ~offset_mask);
-					}
-
-					cpu->update_translation_table(cpu,
-					    vaddr & ~offset_mask, host_addr,
-					    wf, orig_paddr & ~offset_mask);
+				} else {
+					host_addr = mem->devices[i].
+					    dyntrans_data +
+					    (paddr & ~offset_mask);
 				}
 
-				res = 0;
-				if (!no_exceptions || (mem->devices[i].flags &
-				    DM_READS_HAVE_NO_SIDE_EFFECTS))
-					res = mem->devices[i].f(cpu, mem, paddr,
-					    data, len, writeflag,
-					    mem->devices[i].extra);
-
-				if (res == 0)
-					res = -1;
+				cpu->update_translation_table(cpu,
+				    vaddr & ~offset_mask, host_addr,
+				    wf, orig_paddr & ~offset_mask);
+			}
 
-				/*
-				 *  If accessing the memory mapped device
-				 *  failed, then return with an exception.
-				 *  (Architecture specific.)
-				 */
-				if (res <= 0 && !no_exceptions) {
-					debug("[ %s device '%s' addr %08lx "
-					    "failed ]\n", writeflag?
-					    "writing to" : "reading from",
-					    mem->devices[i].name, (long)paddr);
+			res = 0;
+			if (!no_exceptions || (mem->devices[i].flags &
+			    DM_READS_HAVE_NO_SIDE_EFFECTS))
+				res = mem->devices[i].f(cpu, mem, paddr,
+				    data, len, writeflag,
+				    mem->devices[i].extra);
+
+			if (res == 0)
+				res = -1;
+
+			/*
+			 *  If accessing the memory mapped device
+			 *  failed, then return with an exception.
+			 *  (Architecture specific.)
+			 */
+			if (res <= 0 && !no_exceptions) {
+				debug("[ %s device '%s' addr %08lx "
+				    "failed ]\n", writeflag?
+				    "writing to" : "reading from",
+				    mem->devices[i].name, (long)paddr);
 #ifdef MEM_MIPS
-					mips_cpu_exception(cpu,
-					    cache == CACHE_INSTRUCTION?
-					    EXCEPTION_IBE : EXCEPTION_DBE,
-					    0, vaddr, 0, 0, 0, 0);
+				mips_cpu_exception(cpu,
+				    cache == CACHE_INSTRUCTION?
+				    EXCEPTION_IBE : EXCEPTION_DBE,
+				    0, vaddr, 0, 0, 0, 0);
 #endif
 #ifdef MEM_M88K
-					/*  TODO: This is enough for
-					    OpenBSD/mvme88k's badaddr()
-					    implementation... but the
-					    faulting address should probably
-					    be included somewhere too!  */
-					m88k_exception(cpu, cache == CACHE_INSTRUCTION
-					    ? M88K_EXCEPTION_INSTRUCTION_ACCESS
-					    : M88K_EXCEPTION_DATA_ACCESS, 0);
+				/*  TODO: This is enough for
+				    OpenBSD/mvme88k's badaddr()
+				    implementation... but the
+				    faulting address should probably
+				    be included somewhere too!  */
+				m88k_exception(cpu, cache == CACHE_INSTRUCTION
+				    ? M88K_EXCEPTION_INSTRUCTION_ACCESS
+				    : M88K_EXCEPTION_DATA_ACCESS, 0);
 #endif
-					return MEMORY_ACCESS_FAILED;
-				}
-				goto do_return_ok;
+				return MEMORY_ACCESS_FAILED;
 			}
-
-			if (paddr < mem->devices[i].baseaddr)
-				end = i - 1;
-			if (paddr >= mem->devices[i].endaddr)
-				start = i + 1;
-			i = (start + end) >> 1;
-		} while (start <= end);
+			goto do_return_ok;
+		}
 	}
 
 
@@ -490,12 +500,19 @@ not just the device in question.
             !(cpu->cd.mips.coproc[0]->reg[COP0_STATUS] & MIPS1_ISOL_CACHES))
 #endif
 	    && !(ok & MEMORY_NOT_FULL_PAGE)
-	    && !no_exceptions)
+	    && !no_exceptions) {
+		int wf = cache == CACHE_INSTRUCTION?
+		    (writeflag == MEM_WRITE? 1 : 0) : ok - 1;
+
+		/*  When tracking dirty pages, only map pages as writable
+		    when they are actually written to:  */
+		if (mem->n_dirty_clients > 0 && writeflag == MEM_READ)
+			wf = 0;
+
 		cpu->update_translation_table(cpu, vaddr & ~offset_mask,
-		    memblock, (misc_flags & MEMORY_USER_ACCESS) |
-		    (cache == CACHE_INSTRUCTION?
-			(writeflag == MEM_WRITE? 1 : 0) : ok - 1),
+		    memblock, (misc_flags & MEMORY_USER_ACCESS) | wf,
 		    paddr & ~offset_mask);
+	}
 
 	/*
 	 *  If writing, or if mapping a page where writing is ok later on,
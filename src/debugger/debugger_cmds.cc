@@ -535,6 +535,67 @@ static void debugger_cmd_machine(struct machine *m, char *cmd_line)
 }
 
 
+/*
+ *  debugger_cmd_memory():
+ *
+ *  Memory checksums and checkpoints.
+ */
+static void debugger_cmd_memory(struct machine *m, char *cmd_line)
+{
+	struct cpu *c;
+	int a, b = -1;
+
+	if (m->cpus == NULL || (c = m->cpus[m->bootstrap_cpu]) == NULL) {
+		printf("No cpus (?)\n");
+		return;
+	}
+
+	while (cmd_line[0] == ' ')
+		cmd_line ++;
+
+	if (strcmp(cmd_line, "checksum") == 0) {
+		printf("0x%016" PRIx64 "\n", memory_checksum(c, c->mem));
+	} else if (strcmp(cmd_line, "checkpoint") == 0) {
+		a = memory_checkpoint(c, c->mem);
+		printf("checkpoint %i: checksum 0x%016" PRIx64 "\n", a,
+		    memory_checksum(c, c->mem));
+	} else if (strncmp(cmd_line, "diff ", 5) == 0) {
+		if (sscanf(cmd_line + 5, "%i %i", &a, &b) < 1)
+			goto return_help;
+		memory_checkpoint_diff(c, c->mem, a, b);
+	} else if (strcmp(cmd_line, "clear") == 0) {
+		memory_checkpoints_clear(c->mem);
+	} else if (strcmp(cmd_line, "track on") == 0) {
+		memory_checksum_tracking(c, c->mem, 1);
+	} else if (strcmp(cmd_line, "track off") == 0) {
+		memory_checksum_tracking(c, c->mem, 0);
+	} else if (strcmp(cmd_line, "track") == 0) {
+		printf("incremental checksums: %s (%" PRIu64 " pages hashed)\n",
+		    c->mem->hash_tree_tracking? "on" : "off",
+		    c->mem->n_pages_hashed);
+	} else
+		goto return_help;
+
+	return;
+
+return_help:
+	printf("syntax: memory cmd [...]\n");
+	printf("Available cmds are:\n");
+	printf("  checksum               print a checksum of the current"
+	    " machine's RAM\n");
+	printf("  checkpoint             save the current RAM state as a"
+	    " new checkpoint\n");
+	printf("  clear                  forget all checkpoints\n");
+	printf("  track [on|off]         keep the hash tree between checksums"
+	    " (faster when\n"
+	    "                         checksums are frequent)\n");
+	printf("  diff a [b]             show the physical address ranges "
+	    "that differ\n"
+	    "                         between checkpoints a and b (or the"
+	    " current RAM)\n");
+}
+
+
 /*
  *  debugger_cmd_ninstrs():
  */
@@ -1229,6 +1290,9 @@ static struct cmd cmds[] = {
 	{ "machine", "", 0, debugger_cmd_machine,
 		"print a summary of the current machine" },
 
+	{ "memory", "...", 0, debugger_cmd_memory,
+		"RAM checksums, checkpoints, and differences" },
+
 	{ "ninstrs", "[on|off]", 0, debugger_cmd_ninstrs,
 		"toggle (set or unset) show_nr_of_instructions" },
 
@@ -141,7 +141,7 @@ int dec21143_rx(struct cpu *cpu, struct dec21143_data *d)
 	uint64_t addr = d->cur_rx_addr, bufaddr;
 	unsigned char descr[16];
 	uint32_t rdes0, rdes1, rdes2, rdes3;
-	int bufsize, buf1_size, buf2_size, i, writeback_len = 4, to_xfer;
+	int bufsize, buf1_size, buf2_size, writeback_len = 4, to_xfer;
 
 	/*  No current packet? Then check for new ones.  */
 	if (d->cur_rx_buf == NULL) {
@@ -220,12 +220,8 @@ int dec21143_rx(struct cpu *cpu, struct dec21143_data *d)
 		to_xfer = bufsize;
 
 	/*  DMA bytes from the packet into emulated physical memory:  */
-	for (i=0; i<to_xfer; i++) {
-		cpu->memory_rw(cpu, cpu->mem, bufaddr + i,
-		    d->cur_rx_buf + d->cur_rx_offset + i, 1, MEM_WRITE,
-		    PHYSICAL | NO_EXCEPTIONS);
-		/*  fatal(" %02x", d->cur_rx_buf[d->cur_rx_offset + i]);  */
-	}
+	memory_dma_copy(cpu, cpu->mem, bufaddr,
+	    d->cur_rx_buf + d->cur_rx_offset, to_xfer, MEM_WRITE);
 
 	/*  Was this the first buffer in a frame? Then mark it as such.  */
 	if (d->cur_rx_offset == 0)
@@ -285,7 +281,7 @@ int dec21143_tx(struct cpu *cpu, struct dec21143_data *d)
 	uint64_t addr = d->cur_tx_addr, bufaddr;
 	unsigned char descr[16];
 	uint32_t tdes0, tdes1, tdes2, tdes3;
-	int bufsize, buf1_size, buf2_size, i;
+	int bufsize, buf1_size, buf2_size;
 
 	addr &= 0x7fffffff;
 
@@ -387,13 +383,8 @@ int dec21143_tx(struct cpu *cpu, struct dec21143_data *d)
 		}
 
 		/*  "DMA" data from emulated physical memory into the buf:  */
-		for (i=0; i<bufsize; i++) {
-			cpu->memory_rw(cpu, cpu->mem, bufaddr + i,
-			    d->cur_tx_buf + d->cur_tx_buf_len + i, 1, MEM_READ,
-			    PHYSICAL | NO_EXCEPTIONS);
-			/*  fatal(" %02x", d->cur_tx_buf[
-			    d->cur_tx_buf_len + i]);  */
-		}
+		memory_dma_copy(cpu, cpu->mem, bufaddr,
+		    d->cur_tx_buf + d->cur_tx_buf_len, bufsize, MEM_READ);
 
 		d->cur_tx_buf_len += bufsize;
 
@@ -203,15 +203,15 @@ size_t dev_jazz_dma_controller(void *dma_controller_data,
 		/*  fatal(" !!! dma_addr = %08x, phys_addr = %08x\n",
 		    (int)dma_addr, (int)phys_addr);  */
 
-		/*  Speed up the copying by copying 16 or 256 bytes:  */
-		ncpy = 1;
-		if ((phys_addr & 15) == 0 && i + 15 <= (int32_t)len)
-			ncpy = 15;
-		if ((phys_addr & 255) == 0 && i + 255 <= (int32_t)len)
-			ncpy = 255;
-
-		res = cpu->memory_rw(cpu, cpu->mem, phys_addr,
-		    &data[i], ncpy, writeflag, PHYSICAL | NO_EXCEPTIONS);
+		/*  Copy everything up to the end of this DMA page:  */
+		ncpy = 0x1000 - (dma_addr & 0xfff);
+		if (ncpy > (int32_t)len - i)
+			ncpy = (int32_t)len - i;
+		if ((uint32_t)ncpy > d->dma0_addr + d->dma0_count - dma_addr)
+			ncpy = d->dma0_addr + d->dma0_count - dma_addr;
+
+		memory_dma_copy(cpu, cpu->mem, phys_addr, &data[i], ncpy,
+		    writeflag);
 
 		dma_addr += ncpy;
 		i += ncpy;
@@ -266,24 +266,37 @@ void pvr_dma_transfer(struct cpu *cpu, struct pvr_data *d)
 
 			break;
 		} else {
+			/*
+			 *  If the source is incremented, then read it in
+			 *  batches of several units at a time, instead of
+			 *  one word at a time:
+			 */
+			unsigned char buf[4096];
+			uint32_t units_per_batch = src_delta == transmit_size?
+			    sizeof(buf) / transmit_size : 1;
+			size_t chunksize = transmit_size;
+
+			if (chunksize > sizeof(uint32_t))
+				chunksize = sizeof(uint32_t);
+
 			while (count > 0) {
-				unsigned char buf[sizeof(uint32_t)];
+				uint32_t n = units_per_batch, unit;
 				int ofs;
-				size_t chunksize = transmit_size;
 
-				if (chunksize > sizeof(uint32_t))
-					chunksize = sizeof(uint32_t);
+				if (n > count)
+					n = count;
 
-				for (ofs = 0; ofs < transmit_size; ofs += chunksize) {
-					cpu->memory_rw(cpu, cpu->mem, sar + ofs, buf,
-					    chunksize, MEM_READ, NO_EXCEPTIONS | PHYSICAL);
+				memory_dma_copy(cpu, cpu->mem, sar, buf,
+				    n * transmit_size, MEM_READ);
 
-					dev_pvr_ta_access(cpu, cpu->mem, ofs, buf, chunksize,
-					    MEM_WRITE, d);
-				}
+				for (unit = 0; unit < n; unit ++)
+					for (ofs = 0; ofs < transmit_size; ofs += chunksize)
+						dev_pvr_ta_access(cpu, cpu->mem, ofs,
+						    buf + unit * transmit_size + ofs,
+						    chunksize, MEM_WRITE, d);
 
-				count --;
-				sar += src_delta;
+				count -= n;
+				sar += src_delta * n;
 			}
 		}
 
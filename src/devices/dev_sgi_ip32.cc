@@ -637,7 +637,7 @@ static int mec_try_rx(struct cpu *cpu, struct sgi_mec_data *d)
 {
 	uint64_t base;
 	unsigned char data[8];
-	int i, res, retval = 0;
+	int res, retval = 0;
 
 	base = d->rx_addr[d->cur_rx_addr_index];
 	if (base & 0xfff)
@@ -657,7 +657,7 @@ static int mec_try_rx(struct cpu *cpu, struct sgi_mec_data *d)
 
 #if 0
 	printf("{ mec: rxdesc %i: ", d->cur_rx_addr_index);
-	for (i=0; i<sizeof(data); i++) {
+	for (int i=0; i<sizeof(data); i++) {
 		if ((i & 3) == 0)
 			printf(" ");
 		printf("%02x", data[i]);
@@ -680,13 +680,8 @@ static int mec_try_rx(struct cpu *cpu, struct sgi_mec_data *d)
 		goto skip;
 
 	/*  Copy the packet data:  */
-	/*  printf("RX: ");  */
-	for (i=0; i<d->cur_rx_packet_len; i++) {
-		res = cpu->memory_rw(cpu, cpu->mem, base + 32 + i + 2,
-		    d->cur_rx_packet + i, 1, MEM_WRITE, PHYSICAL);
-		/*  printf(" %02x", d->cur_rx_packet[i]);  */
-	}
-	/*  printf("\n");  */
+	memory_dma_copy(cpu, cpu->mem, base + 32 + 2, d->cur_rx_packet,
+	    d->cur_rx_packet_len, MEM_WRITE);
 
 #if 0
 	printf("RX: %i bytes, index %i, base = 0x%x\n",
@@ -826,21 +821,14 @@ static int mec_try_tx(struct cpu *cpu, struct sgi_mec_data *d)
 			/*  printf("dma_base = %08x, dma_len = %i\n",
 			    (int)dma_base, dma_len);  */
 
-			while (dma_len > 0) {
-				unsigned char ch;
-				res = cpu->memory_rw(cpu, cpu->mem, dma_base,
-				    &ch, sizeof(ch), MEM_READ, PHYSICAL);
-				/*  printf(" %02x", ch);  */
-
-				d->cur_tx_packet[j++] = ch;
-				if (j >= MAX_TX_PACKET_LEN) {
-					fatal("[ mec_try_tx: packet too large?"
-					    " ]\n");
-					break;
-				}
-				dma_base ++;
-				dma_len --;
+			if (j + dma_len >= MAX_TX_PACKET_LEN) {
+				fatal("[ mec_try_tx: packet too large? ]\n");
+				dma_len = MAX_TX_PACKET_LEN - j;
 			}
+
+			memory_dma_copy(cpu, cpu->mem, dma_base,
+			    d->cur_tx_packet + j, dma_len, MEM_READ);
+			j += dma_len;
 		}
 	}
 
@@ -67,6 +67,7 @@
 #define	SH4_REG_BASE		0xff000000
 #define	SH4_TICK_SHIFT		14
 #define	N_SH4_TIMERS		3
+#define	N_SH4_DMAC_IRQS		4
 
 /*  PCI stuff:  */
 #define	N_PCIC_REGS			(0x224 / sizeof(uint32_t))
@@ -154,6 +155,9 @@ struct sh4_data {
 	uint16_t	sdmr2;
 	uint16_t	sdmr3;
 
+	/*  DMAC: Transfer end interrupts for channels 0..3:  */
+	struct interrupt dmac_irq[N_SH4_DMAC_IRQS];
+
 	/*  Timer Management Unit:  */
 	struct timer	*sh4_timer;
 	struct interrupt timer_irq[4];
@@ -312,6 +316,111 @@ DEVICE_TICK(sh4)
 }
 
 
+/*
+ *  sh4_dmac_is_ram():
+ *
+ *  Returns 1 if the physical range paddr .. paddr+len-1 can be accessed
+ *  directly as host memory (see memory_dma_is_ram()), 0 otherwise. This
+ *  is only a probe; pages are marked as dirty when the copy is done.
+ */
+static int sh4_dmac_is_ram(struct cpu *cpu, uint32_t paddr, uint64_t len,
+	int writeflag)
+{
+	if ((uint64_t)paddr + len > 0x20000000)
+		return 0;
+
+	return memory_dma_is_ram(cpu->mem, paddr, len, writeflag);
+}
+
+
+/*
+ *  sh4_dmac_copy():
+ *
+ *  Copy count units of transmit_size bytes each from sar to dar, moving
+ *  the addresses by src_delta and dst_delta after each unit.
+ *
+ *  If both addresses are fixed or incremented, and both ranges are RAM,
+ *  then the transfer is done as a block copy (or fill). Otherwise (devices,
+ *  decrementing addresses, or overlapping source and destination), it is
+ *  done one unit at a time, just like the real DMAC does, and device
+ *  handlers are called for each unit.
+ *
+ *  Returns the number of units that were transferred. This is less than
+ *  count if a device refused an access.
+ */
+static uint32_t sh4_dmac_copy(struct cpu *cpu, uint32_t sar, uint32_t dar,
+	uint32_t count, int transmit_size, int src_delta, int dst_delta)
+{
+	uint64_t src_len = src_delta? (uint64_t)count * transmit_size
+	    : transmit_size;
+	uint64_t dst_len = dst_delta? (uint64_t)count * transmit_size
+	    : transmit_size;
+	unsigned char buf[4096];
+	uint32_t done = 0;
+
+	if (src_delta >= 0 && dst_delta >= 0 &&
+	    (sar + src_len <= dar || dar + dst_len <= sar) &&
+	    sh4_dmac_is_ram(cpu, sar, src_len, MEM_READ) &&
+	    sh4_dmac_is_ram(cpu, dar, dst_len, MEM_WRITE)) {
+		if (src_delta == 0) {
+			/*  Fill with the same unit, or store it just once:  */
+			size_t i, n = sizeof(buf) / transmit_size;
+
+			memory_dma_copy(cpu, cpu->mem, sar, buf,
+			    transmit_size, MEM_READ);
+			for (i=1; i<n; i++)
+				memcpy(buf + i * transmit_size, buf,
+				    transmit_size);
+
+			while (dst_len > 0) {
+				size_t chunk = n * transmit_size;
+				if (chunk > dst_len)
+					chunk = dst_len;
+				memory_dma_copy(cpu, cpu->mem, dar, buf,
+				    chunk, MEM_WRITE);
+				dar += chunk;
+				dst_len -= chunk;
+			}
+		} else if (dst_delta == 0) {
+			/*  Only the last unit remains at the destination:  */
+			memory_dma_copy(cpu, cpu->mem, sar + src_len -
+			    transmit_size, buf, transmit_size, MEM_READ);
+			memory_dma_copy(cpu, cpu->mem, dar, buf,
+			    transmit_size, MEM_WRITE);
+		} else {
+			while (src_len > 0) {
+				size_t chunk = sizeof(buf);
+				if (chunk > src_len)
+					chunk = src_len;
+				memory_dma_copy(cpu, cpu->mem, sar, buf,
+				    chunk, MEM_READ);
+				memory_dma_copy(cpu, cpu->mem, dar, buf,
+				    chunk, MEM_WRITE);
+				sar += chunk;
+				dar += chunk;
+				src_len -= chunk;
+			}
+		}
+
+		return count;
+	}
+
+	while (done < count) {
+		if (cpu->memory_rw(cpu, cpu->mem, sar, buf, transmit_size,
+		    MEM_READ, PHYSICAL) == MEMORY_ACCESS_FAILED ||
+		    cpu->memory_rw(cpu, cpu->mem, dar, buf, transmit_size,
+		    MEM_WRITE, PHYSICAL) == MEMORY_ACCESS_FAILED)
+			break;
+
+		done ++;
+		sar = (sar + src_delta) & 0x1fffffff;
+		dar = (dar + dst_delta) & 0x1fffffff;
+	}
+
+	return done;
+}
+
+
 /*
  *  sh4_dmac_transfer():
  *
@@ -326,6 +435,7 @@ void sh4_dmac_transfer(struct cpu *cpu, struct sh4_data *d, int channel)
 	uint32_t dar = cpu->cd.sh.dmac_dar[channel] & 0x1fffffff;
 	uint32_t count = cpu->cd.sh.dmac_tcr[channel] & 0x1fffffff;
 	uint32_t chcr = cpu->cd.sh.dmac_chcr[channel];
+	uint32_t done;
 	int transmit_size = 1;
 	int src_delta = 0, dst_delta = 0;
 	int cause_interrupt = chcr & CHCR_IE;
@@ -334,6 +444,11 @@ void sh4_dmac_transfer(struct cpu *cpu, struct sh4_data *d, int channel)
 	if (!(chcr & CHCR_TD))
 		return;
 
+	/*  All channels are halted after an address error, until the
+	    AE flag in DMAOR is cleared.  */
+	if (cpu->cd.sh.dmaor & DMAOR_AE)
+		return;
+
 	/*  Transfer End already set? Then don't transfer again.  */
 	if (chcr & CHCR_TE)
 		return;
@@ -398,6 +513,43 @@ void sh4_dmac_transfer(struct cpu *cpu, struct sh4_data *d, int channel)
 		    external device to do the transfer itself!  */
 		break;
 
+	case 0x400:
+		/*
+		 *  Auto-request
+		 *  External Address Space => External Address Space
+		 *
+		 *  The transfer is done right away, so a transfer end
+		 *  interrupt is caused right away as well.
+		 */
+		done = sh4_dmac_copy(cpu, sar, dar, count, transmit_size,
+		    src_delta, dst_delta);
+
+		cpu->cd.sh.dmac_sar[channel] = (sar + done * src_delta)
+		    & 0x1fffffff;
+		cpu->cd.sh.dmac_dar[channel] = (dar + done * dst_delta)
+		    & 0x1fffffff;
+		cpu->cd.sh.dmac_tcr[channel] = (count - done) & 0xffffff;
+
+		if (done < count) {
+			/*
+			 *  Address error: the transfer stops without
+			 *  a transfer end. (TODO: The DMAE interrupt.)
+			 */
+			debug("[ SH4 DMAC: address error on channel %i ]\n",
+			    channel);
+			cpu->cd.sh.dmaor |= DMAOR_AE;
+			return;
+		}
+
+		cpu->cd.sh.dmac_chcr[channel] |= CHCR_TE;
+		cpu->cd.sh.dmac_chcr[channel] &= ~CHCR_TD;
+
+		if (cause_interrupt && channel < N_SH4_DMAC_IRQS) {
+			INTERRUPT_ASSERT(d->dmac_irq[channel]);
+			return;
+		}
+		break;
+
 	default:fatal("Unimplemented SH4 RS DMAC: 0x%08x\n",
 		    (int) (chcr & CHCR_RS));
 		exit(1);
@@ -1323,6 +1475,10 @@ DEVICE_ACCESS(sh4)
 
 			cpu->cd.sh.dmac_chcr[dma_channel] = idata;
 
+			/*  Clearing TE acknowledges a transfer end interrupt:  */
+			if (!(idata & CHCR_TE) && dma_channel < N_SH4_DMAC_IRQS)
+				INTERRUPT_DEASSERT(d->dmac_irq[dma_channel]);
+
 			/*  Perform a transfer?  */
 			if (idata & CHCR_TD)
 				sh4_dmac_transfer(cpu, d, dma_channel);
@@ -1867,6 +2023,17 @@ DEVINIT(sh4)
 	INTERRUPT_CONNECT(tmp, d->scif_tx_irq);
 
 
+	/*
+	 *  DMAC transfer end interrupts:
+	 */
+
+	for (i=0; i<N_SH4_DMAC_IRQS; i++) {
+		snprintf(tmp, sizeof(tmp), "%s.irq[0x%x]",
+		    devinit->interrupt_path, SH4_INTEVT_DMAC_DMTE0 + 0x20 * i);
+		INTERRUPT_CONNECT(tmp, d->dmac_irq[i]);
+	}
+
+
 	/*
 	 *  Caches (fake):
  	 *
@@ -2001,3 +2168,149 @@ DEVINIT(sh4)
 	return 1;
 }
 
+
+
+/*****************************************************************************/
+
+
+#ifdef WITHUNITTESTS
+
+#include "emul.h"
+#include "UnitTest.h"
+
+extern int quiet_mode;
+
+#define	TEST_DEVICE_BASE	0x10000000
+#define	TEST_REFUSING_BASE	0x10001000
+
+static uint32_t sh4_dmac_test_last_write;
+static int sh4_dmac_test_nwrites;
+
+/*  A FIFO-like device, which counts its writes:  */
+DEVICE_ACCESS(sh4_dmac_test)
+{
+	if (writeflag == MEM_WRITE) {
+		sh4_dmac_test_last_write = memory_readmax64(cpu, data, len);
+		sh4_dmac_test_nwrites ++;
+	} else {
+		memory_writemax64(cpu, data, len, 0);
+	}
+
+	return 1;
+}
+
+/*  A device which refuses all accesses:  */
+DEVICE_ACCESS(sh4_dmac_test_refusing)
+{
+	return 0;
+}
+
+/*
+ *  sh4_dmac_test_setup():
+ *
+ *  Create a minimal SH4 machine with 4 MB of RAM and the two test devices.
+ *  Returns the machine's only cpu. (Machines are never destroyed; see
+ *  memory_test_setup() in memory.cc.)
+ */
+static struct cpu *sh4_dmac_test_setup()
+{
+	static struct emul *emul = NULL;
+	struct machine *m;
+	int old_quiet_mode = quiet_mode;
+
+	if (emul == NULL)
+		emul = emul_new(NULL);
+
+	m = emul_add_machine(emul, NULL);
+
+	quiet_mode = 1;
+	m->arch = ARCH_SH;
+	m->physical_ram_in_mb = 4;
+	m->memory = memory_new(4 * 1048576, m->arch);
+
+	m->ncpus = 1;
+	CHECK_ALLOCATION(m->cpus = (struct cpu **)
+	    malloc(sizeof(struct cpu *)));
+	m->cpus[0] = cpu_new(m->memory, m, 0, (char *) "SH7750");
+
+	memory_device_register(m->memory, "sh4_dmac_test", TEST_DEVICE_BASE,
+	    0x1000, dev_sh4_dmac_test_access, NULL, DM_DEFAULT, NULL);
+	memory_device_register(m->memory, "sh4_dmac_test_refusing",
+	    TEST_REFUSING_BASE, 0x1000, dev_sh4_dmac_test_refusing_access,
+	    NULL, DM_DEFAULT, NULL);
+	quiet_mode = old_quiet_mode;
+
+	return m->cpus[0];
+}
+
+static void sh4_dmac_test_start(struct cpu *cpu, struct sh4_data *d,
+	uint32_t sar, uint32_t dar, uint32_t count)
+{
+	memset(d, 0, sizeof(*d));
+	cpu->cd.sh.dmaor = DMAOR_DME;
+	cpu->cd.sh.dmac_sar[0] = sar;
+	cpu->cd.sh.dmac_dar[0] = dar;
+	cpu->cd.sh.dmac_tcr[0] = count;
+	cpu->cd.sh.dmac_chcr[0] = CHCR_SM_INCREMENTED | CHCR_DM_FIXED |
+	    0x400 | CHCR_TS_4BYTE | CHCR_TD;
+
+	sh4_dmac_transfer(cpu, d, 0);
+}
+
+static void Test_sh4_dmac_RAMToDevice()
+{
+	struct cpu *cpu = sh4_dmac_test_setup();
+	struct sh4_data d;
+	unsigned char buf[4];
+	int i;
+
+	for (i=0; i<4; i++) {
+		store_32bit_word_in_host(cpu, buf, 0x11111111 * (i+1));
+		cpu->memory_rw(cpu, cpu->mem, 0x1000 + i*4, buf, sizeof(buf),
+		    MEM_WRITE, PHYSICAL);
+	}
+
+	sh4_dmac_test_nwrites = 0;
+	sh4_dmac_test_start(cpu, &d, 0x1000, TEST_DEVICE_BASE, 4);
+
+	UnitTest::Assert("each unit should reach the device",
+	    sh4_dmac_test_nwrites, 4);
+	UnitTest::Assert("last unit", sh4_dmac_test_last_write, 0x44444444);
+	UnitTest::Assert("transfer end should be set",
+	    (cpu->cd.sh.dmac_chcr[0] & CHCR_TE) != 0);
+	UnitTest::Assert("tcr", cpu->cd.sh.dmac_tcr[0], 0);
+	UnitTest::Assert("sar", cpu->cd.sh.dmac_sar[0], 0x1010);
+	UnitTest::Assert("no address error",
+	    (cpu->cd.sh.dmaor & DMAOR_AE) == 0);
+}
+
+static void Test_sh4_dmac_RefusingDevice()
+{
+	struct cpu *cpu = sh4_dmac_test_setup();
+	struct sh4_data d;
+
+	sh4_dmac_test_start(cpu, &d, 0x1000, TEST_REFUSING_BASE, 4);
+
+	UnitTest::Assert("transfer end should not be set",
+	    (cpu->cd.sh.dmac_chcr[0] & CHCR_TE) == 0);
+	UnitTest::Assert("address error should be set",
+	    (cpu->cd.sh.dmaor & DMAOR_AE) != 0);
+	UnitTest::Assert("no units should have been transferred",
+	    cpu->cd.sh.dmac_tcr[0], 4);
+	UnitTest::Assert("sar", cpu->cd.sh.dmac_sar[0], 0x1000);
+
+	/*  Further transfers are halted until AE is cleared:  */
+	sh4_dmac_test_nwrites = 0;
+	cpu->cd.sh.dmac_dar[0] = TEST_DEVICE_BASE;
+	sh4_dmac_transfer(cpu, &d, 0);
+	UnitTest::Assert("the DMAC should be halted",
+	    sh4_dmac_test_nwrites, 0);
+}
+
+UNITTESTS(sh4_dmacreg)
+{
+	UNITTEST(Test_sh4_dmac_RAMToDevice);
+	UNITTEST(Test_sh4_dmac_RefusingDevice);
+}
+
+#endif	// WITHUNITTESTS
@@ -138,18 +138,8 @@ static void file_load_aout(struct machine *m, struct memory *mem,
 		    (int)len, (int)vaddr, buf[0], buf[1], buf[2]);  */
 
 		if (len > 0) {
-			int len2 = 0;
-			uint64_t vaddr1 = vaddr &
-			    ((1 << BITS_PER_MEMBLOCK) - 1);
-			uint64_t vaddr2 = (vaddr +
-			    len) & ((1 << BITS_PER_MEMBLOCK) - 1);
-			if (vaddr2 < vaddr1) {
-				len2 = len - vaddr2;
-				m->cpus[0]->memory_rw(m->cpus[0], mem, vaddr,
-				    &buf[0], len2, MEM_WRITE, NO_EXCEPTIONS);
-			}
-			m->cpus[0]->memory_rw(m->cpus[0], mem, vaddr + len2,
-			    &buf[len2], len-len2, MEM_WRITE, NO_EXCEPTIONS);
+			memory_rw_bulk(m->cpus[0], mem, vaddr, &buf[0], len,
+			    MEM_WRITE, NO_EXCEPTIONS);
 		} else {
 			if (flags & AOUT_FLAG_DECOSF1)
 				break;
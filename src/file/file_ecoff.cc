@@ -254,7 +254,7 @@ static void file_load_ecoff(struct machine *m, struct memory *mem,
 					break;
 				}
 
-				m->cpus[0]->memory_rw(m->cpus[0], mem, s_vaddr,
+				memory_rw_bulk(m->cpus[0], mem, s_vaddr,
 				    &buf[0], len, MEM_WRITE, NO_EXCEPTIONS);
 				s_vaddr += len;
 				total_len += len;
@@ -470,7 +470,7 @@ static void file_load_elf(struct machine *m, struct memory *mem,
 					size_t len_to_copy;
 					len_to_copy = (j + align_len) <= len?
 					    align_len : len - j;
-					m->cpus[0]->memory_rw(m->cpus[0], mem,
+					memory_rw_bulk(m->cpus[0], mem,
 					    p_vaddr + ofs, &ch[j], len_to_copy,
 					    MEM_WRITE, NO_EXCEPTIONS);
 					ofs += align_len;
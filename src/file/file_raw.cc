@@ -105,7 +105,7 @@ static void file_load_raw(struct machine *m, struct memory *mem,
 		len = fread(buf, 1, to_read, f);
 
 		if (len > 0)
-			m->cpus[0]->memory_rw(m->cpus[0], mem, vaddr, &buf[0],
+			memory_rw_bulk(m->cpus[0], mem, vaddr, &buf[0],
 			    len, MEM_WRITE, NO_EXCEPTIONS);
 
 		vaddr += len;
@@ -139,6 +139,91 @@ public:
 	 *	because of a timeout).
 	 */
 	virtual bool WriteData(const uint64_t& data, Endianness endianness) = 0;
+
+	/**
+	 * \brief Reads a block of bytes, starting at a specific address.
+	 *
+	 * The default implementation reads one byte at a time, using
+	 * AddressSelect() and ReadData(). Components which can do better
+	 * (such as the RAMComponent) should override this.
+	 *
+	 * Note that the currently selected address is undefined after a call
+	 * to ReadBlock() or WriteBlock().
+	 *
+	 * \param address The address of the first byte to read.
+	 * \param data A pointer to a buffer which will receive the data.
+	 * \param len The number of bytes to read.
+	 * \return True if the entire block was read successfully, false
+	 *	otherwise.
+	 */
+	virtual bool ReadBlock(uint64_t address, uint8_t* data, size_t len)
+	{
+		for (size_t i=0; i<len; ++i) {
+			AddressSelect(address + i);
+			if (!ReadData(data[i]))
+				return false;
+		}
+
+		return true;
+	}
+
+	/**
+	 * \brief Writes a block of bytes, starting at a specific address.
+	 *
+	 * The default implementation writes one byte at a time, using
+	 * AddressSelect() and WriteData(). Components which can do better
+	 * (such as the RAMComponent) should override this.
+	 *
+	 * \param address The address of the first byte to write.
+	 * \param data A pointer to the data to write.
+	 * \param len The number of bytes to write.
+	 * \return True if the entire block was written successfully, false
+	 *	otherwise.
+	 */
+	virtual bool WriteBlock(uint64_t address, const uint8_t* data,
+		size_t len)
+	{
+		for (size_t i=0; i<len; ++i) {
+			AddressSelect(address + i);
+			if (!WriteData(data[i]))
+				return false;
+		}
+
+		return true;
+	}
+
+	/**
+	 * \brief Looks up a host memory pointer for a page of data.
+	 *
+	 * Components which are plain memory (such as the RAMComponent) may
+	 * return a pointer to their host memory, which callers may then use
+	 * for direct access to the page, instead of AddressSelect() followed
+	 * by ReadData() or WriteData(). Data in the page is stored in the
+	 * byte order it was written with.
+	 *
+	 * The pointer is valid until cached state is flushed (see
+	 * Component::FlushCachedState()), or until the value of the
+	 * generation counter changes. (The counter changes e.g. when memory
+	 * which was shared with a snapshot is copied on write, or when the
+	 * memory becomes shared with a new snapshot.)
+	 *
+	 * The default implementation returns NULL, i.e. no direct access.
+	 *
+	 * \param address The address of the start of the page. It must be
+	 *	aligned to pageSize.
+	 * \param pageSize The size of the page, in bytes.
+	 * \param forWriting True if the caller wants to write to the page.
+	 * \param generation Set to point to the generation counter of the
+	 *	page, when a pointer is returned. The counter itself stays
+	 *	valid for as long as the component exists.
+	 * \return A pointer to the host memory for the entire page, or NULL
+	 *	if direct access is not possible.
+	 */
+	virtual uint8_t* LookupHostPage(uint64_t address, size_t pageSize,
+		bool forWriting, const uint64_t*& generation)
+	{
+		return NULL;
+	}
 };
 
 
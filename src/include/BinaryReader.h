@@ -0,0 +1,126 @@
+#ifndef BINARYREADER_H
+#define	BINARYREADER_H
+
+/*
+ *  Copyright (C) 2014  Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+#include "BinaryWriter.h"
+
+
+/**
+ * \brief Reads a binary emulation file written by BinaryWriter.
+ *
+ * Only the header, the component tree, and the section table are read when
+ * the file is opened. Sections are either mapped directly from the file
+ * using MapSection(), or read on demand.
+ */
+class BinaryReader
+{
+private:
+	/* Disable copying, since the reader owns a file descriptor. */
+	BinaryReader(const BinaryReader& other);
+	BinaryReader& operator = (const BinaryReader& other);
+
+public:
+	/**
+	 * \brief Constructs a BinaryReader.
+	 */
+	BinaryReader();
+
+	~BinaryReader();
+
+	/**
+	 * \brief Opens a binary emulation file.
+	 *
+	 * @param filename The name of the file.
+	 * @param messages A stream where error messages are written.
+	 * @return true if the file was opened, false on error.
+	 */
+	bool Open(const string& filename, ostream& messages);
+
+	/**
+	 * \brief Checks whether a file is a binary emulation file.
+	 *
+	 * @param filename The name of the file.
+	 * @return true if the file starts with the binary file magic.
+	 */
+	static bool IsBinaryFile(const string& filename);
+
+	bool ReadUInt8(uint8_t& value);
+	bool ReadUInt64(uint64_t& value);
+	bool ReadDouble(double& value);
+	bool ReadString(string& str);
+
+	/**
+	 * \brief Skips bytes in the component tree.
+	 *
+	 * @param len The number of bytes to skip.
+	 * @return false if there are fewer than len bytes left.
+	 */
+	bool Skip(uint64_t len);
+
+	/**
+	 * \brief Gets the number of bytes left to read in the component tree.
+	 *
+	 * @return The number of unread bytes.
+	 */
+	uint64_t BytesLeft() const;
+
+	/**
+	 * \brief Gets the length of a section.
+	 *
+	 * @param index The section index.
+	 * @param len Set to the section's length, in bytes.
+	 * @return false if there is no such section.
+	 */
+	bool GetSectionLength(uint64_t index, uint64_t& len) const;
+
+	/**
+	 * \brief Maps a section into host memory, copy-on-write.
+	 *
+	 * The contents are read from the file by the host OS when they are
+	 * first touched. Writes to the memory are private, i.e. they do not
+	 * affect the file. The mapping stays valid after the BinaryReader
+	 * has been destroyed; it should be released using munmap().
+	 *
+	 * @param index The section index.
+	 * @param len The number of bytes to map. This may be larger than
+	 *	the section; the rest is then zero-filled.
+	 * @return A pointer to the mapped memory, or NULL on error.
+	 */
+	void* MapSection(uint64_t index, size_t len) const;
+
+private:
+	int			m_fd;
+	string			m_tree;
+	size_t			m_pos;
+	vector<uint64_t>	m_sectionOffsets;
+	vector<uint64_t>	m_sectionLengths;
+};
+
+
+#endif	// BINARYREADER_H
@@ -0,0 +1,131 @@
+#ifndef BINARYWRITER_H
+#define	BINARYWRITER_H
+
+/*
+ *  Copyright (C) 2014  Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+#include "misc.h"
+
+#include "UnitTest.h"
+
+
+/*
+ * Binary emulation files look like this:
+ *
+ *	header:		"GXemulB\n" (8 bytes), version (uint32),
+ *			nr of sections (uint32), tree length (uint64)
+ *	tree:		the serialized component tree
+ *	section table:	offset (uint64) and length (uint64) of each section
+ *	sections:	raw data, each section aligned to
+ *			BINARY_SECTION_ALIGNMENT bytes
+ *
+ * All integers are stored in little endian byte order. Sections are aligned
+ * so that they can be mmap()ed directly from the file.
+ */
+#define	BINARY_FILE_MAGIC		"GXemulB\n"
+#define	BINARY_FILE_VERSION		2
+#define	BINARY_SECTION_ALIGNMENT	65536
+
+
+/**
+ * \brief Writes a binary emulation file.
+ *
+ * The component tree is built up in memory using the Write* functions.
+ * Large pieces of data (e.g. RAM contents) are added as separate sections,
+ * which are written after the tree when Finish() is called.
+ */
+class BinaryWriter
+	: public UnitTestable
+{
+public:
+	/**
+	 * \brief Constructs a BinaryWriter.
+	 */
+	BinaryWriter();
+
+	void WriteUInt8(uint8_t value);
+	void WriteUInt64(uint64_t value);
+	void WriteDouble(double value);
+	void WriteString(const string& str);
+
+	/**
+	 * \brief Starts a length-prefixed value.
+	 *
+	 * A placeholder for the length is written, which is filled in by
+	 * EndLengthPrefixed(). This lets readers skip values whose format
+	 * they do not know.
+	 *
+	 * @return The position to pass to EndLengthPrefixed().
+	 */
+	size_t BeginLengthPrefixed();
+
+	/**
+	 * \brief Ends a length-prefixed value.
+	 *
+	 * @param start The position returned by BeginLengthPrefixed().
+	 */
+	void EndLengthPrefixed(size_t start);
+
+	/**
+	 * \brief Adds a section of raw data to the file.
+	 *
+	 * The data is not copied, so it must remain valid until Finish()
+	 * has been called. Aligned pages which are all zeroes are left out
+	 * of the file (as holes, on file systems which support them).
+	 *
+	 * @param data A pointer to the data.
+	 * @param len The length of the data, in bytes.
+	 * @return The section's index, to be used with
+	 *	BinaryReader::MapSection().
+	 */
+	uint64_t AddSection(const void* data, size_t len);
+
+	/**
+	 * \brief Writes the file.
+	 *
+	 * @param filename The name of the file to write.
+	 * @return true if the file was written, false on error.
+	 */
+	bool Finish(const string& filename);
+
+	/********************************************************************/
+
+	static void RunUnitTests(int& nSucceeded, int& nFailures);
+
+private:
+	struct Section
+	{
+		const void*	data;
+		size_t		len;
+	};
+
+	string			m_tree;
+	vector<Section>		m_sections;
+};
+
+
+#endif	// BINARYWRITER_H
@@ -166,6 +166,26 @@ public:
 	void DetectChanges(const refcount_ptr<Component>& oldClone,
 		ostream& changeMessages) const;
 
+	/**
+	 * \brief Remembers the current values of all state variables in
+	 *	the component tree.
+	 *
+	 * This is a cheaper alternative to LightClone(), when the tree
+	 * structure itself is known not to change, e.g. when single-stepping.
+	 * Changes can then be found using DetectChanges(ostream&).
+	 */
+	void MarkUnchanged();
+
+	/**
+	 * \brief Find changes made since MarkUnchanged() was called.
+	 *
+	 * Any changes found are written as messages to changeMessages,
+	 * in the same format as the clone-based DetectChanges().
+	 *
+	 * @param changeMessages An output stream where to send messages.
+	 */
+	void DetectChanges(ostream& changeMessages) const;
+
 	/**
 	 * \brief Generates an ASCII tree dump of a component tree.
 	 *
@@ -528,6 +548,28 @@ public:
 	static refcount_ptr<Component> Deserialize(ostream& messages,
 	    const string& str, size_t& pos);
 
+	/**
+	 * \brief Serializes the %Component tree into a binary emulation file.
+	 *
+	 * @param writer The BinaryWriter to write to.
+	 */
+	void SerializeBinary(BinaryWriter& writer) const;
+
+	/**
+	 * \brief Deserializes a component tree from a binary emulation file.
+	 *
+	 * Large data, such as RAM contents, is mapped from the file and is
+	 * not actually read until it is used.
+	 *
+	 * @param messages A stream where errors/warnings may be reported.
+	 * @param reader The BinaryReader to read from.
+	 * @return If deserialization was successful, the
+	 *	reference counted pointer will point to a component tree;
+	 *	on error, it will be set to NULL
+	 */
+	static refcount_ptr<Component> DeserializeBinary(ostream& messages,
+	    BinaryReader& reader);
+
 	/**
 	 * \brief Checks consistency by serializing and deserializing the
 	 *	component (including all its child components), and comparing
@@ -34,9 +34,50 @@
 
 #include "CommandInterpreter.h"
 #include "Component.h"
+#include "StateVariableRef.h"
 #include "UI.h"
 
 
+/**
+ * \brief An executable component, and its scheduling state.
+ *
+ * Used internally by GXemul::Execute().
+ */
+struct ComponentAndFrequency
+{
+	ComponentAndFrequency()
+		: frequency(0.0)
+		, intFrequency(1)
+		, nextTimeToExecute(0)
+		, periodQuotient(0)
+		, periodRemainder(0)
+		, timeQuotient(0)
+		, timeRemainder(0)
+	{
+	}
+
+	refcount_ptr<Component>		component;
+	StateVariableRef<double>	frequencyVariable;
+	StateVariableRef<uint64_t>	step;
+
+	// The frequency, as read at the start of each call to Execute(), and
+	// rounded to whole Hz for scheduling.
+	double				frequency;
+	uint64_t			intFrequency;
+
+	// A component with frequency f executes its n'th step (n = 1, 2, ..)
+	// during step ceil(n * F / f) - 1 of the fastest component, which
+	// has frequency F. n * F / f is kept as a quotient and a remainder,
+	// and is advanced by the period F / f for each executed step, so
+	// that no division (and no floating point rounding) is needed.
+	uint64_t			nextTimeToExecute;
+	uint64_t			periodQuotient;
+	uint64_t			periodRemainder;
+	uint64_t			timeQuotient;
+	uint64_t			timeRemainder;
+};
+
+
 /**
  * \brief The main emulator class.
  *
@@ -272,6 +313,16 @@ public:
 	 */
 	void Execute(const int longestTotalRun = 100000);
 
+	/**
+	 * \brief Forgets the cached list of executable components.
+	 *
+	 * Execute() keeps handles to the frequency and step variables of
+	 * all executable components between calls. This must be called when
+	 * the component tree changes, or when a component is paused or
+	 * unpaused, so that the list is gathered again.
+	 */
+	void InvalidateExecutableComponents();
+
 	/**
 	 * \brief Dump a list to stdout with all available machine templates.
 	 */
@@ -311,9 +362,28 @@ private:
 
 	/**
 	 * \brief Takes a snapshot of the full emulation state.
+	 *
+	 * Snapshots share RAM contents with the running emulation
+	 * (copy-on-write), so they are cheap unless the emulation writes
+	 * to large parts of memory between snapshots.
 	 */
 	void TakeSnapshot();
 
+	/**
+	 * \brief Gets the number of steps between periodic snapshots.
+	 *
+	 * This is root.snapshotInterval, multiplied by a factor which grows
+	 * when the number of snapshots would otherwise become too large.
+	 *
+	 * @return The number of steps between snapshots.
+	 */
+	uint64_t GetSnapshotSpacing() const;
+
+	/**
+	 * \brief Discards all snapshots.
+	 */
+	void DiscardSnapshots();
+
 
 	/********************************************************************/
 public:
@@ -339,9 +409,15 @@ private:
 	string			m_emulationFileName;
 	refcount_ptr<Component>	m_rootComponent;
 
-	// Snapshotting:   TODO: Multiple snapshots!
+	// Snapshotting:
 	bool			m_snapshottingEnabled;
-	refcount_ptr<Component>	m_snapshot;
+	vector< refcount_ptr<Component> > m_snapshots;	// sorted by step
+	uint64_t		m_snapshotSpacingFactor;
+
+	// Executable components (cached between calls to Execute):
+	bool			m_executableComponentsValid;
+	vector<ComponentAndFrequency> m_executableComponents;
+	bool			m_sloppyAccuracy;
 };
 
 #endif	// GXEMUL_H
@@ -38,6 +38,8 @@
 #include "UnitTest.h"
 
 
+class BinaryReader;
+class BinaryWriter;
 class StateVariable;
 typedef map<string,StateVariable> StateVariableMap;
 
@@ -56,6 +58,25 @@ public:
 	virtual void Serialize(ostream& ss) const = 0;
 	virtual bool Deserialize(const string& value) = 0;
 	virtual void CopyValueFrom(CustomStateVariableHandler* other) = 0;
+
+	/**
+	 * \brief Serializes the value into a binary emulation file.
+	 *
+	 * The default implementation stores the text serialization.
+	 * Handlers of large values should override this, and store the
+	 * data in separate sections (see BinaryWriter::AddSection()).
+	 *
+	 * @param writer The BinaryWriter to write to.
+	 */
+	virtual void SerializeBinary(BinaryWriter& writer) const;
+
+	/**
+	 * \brief Deserializes a value written by SerializeBinary().
+	 *
+	 * @param reader The BinaryReader to read from.
+	 * @return true if the value was read, false on error.
+	 */
+	virtual bool DeserializeBinary(BinaryReader& reader);
 };
 
 
@@ -221,6 +242,64 @@ public:
 	 */
 	void Serialize(ostream& ss, SerializationContext& context) const;
 
+	/**
+	 * \brief Serializes the variable into a binary emulation file.
+	 *
+	 * The name, the type, and the value are written, in that order.
+	 *
+	 * @param writer The BinaryWriter to write to.
+	 */
+	void SerializeBinary(BinaryWriter& writer) const;
+
+	/**
+	 * \brief Deserializes a value written by SerializeBinary().
+	 *
+	 * The name and type have already been read by the caller.
+	 *
+	 * @param reader The BinaryReader to read from.
+	 * @param type The type of the stored value. If it differs from
+	 *	the type of this variable, the value is skipped.
+	 * @return true if the value was read, false on error.
+	 */
+	bool DeserializeBinaryValue(BinaryReader& reader, enum Type type);
+
+	/**
+	 * \brief Skips a value written by SerializeBinary().
+	 *
+	 * Custom values are skipped using their recorded length, since
+	 * their format is only known by their handlers.
+	 *
+	 * @param reader The BinaryReader to read from.
+	 * @param type The type of the stored value.
+	 * @return true if the value was skipped, false on error.
+	 */
+	static bool SkipBinaryValue(BinaryReader& reader, enum Type type);
+
+	/**
+	 * \brief Remembers the current value, for change detection.
+	 *
+	 * This is much cheaper than copying the variable, since no strings
+	 * are formatted (except for String variables). Custom variables are
+	 * never reported as changed.
+	 */
+	void MarkUnchanged();
+
+	/**
+	 * \brief Checks whether the value differs from the value it had
+	 *	when MarkUnchanged() was last called.
+	 *
+	 * @return true if the value has changed, false otherwise.
+	 */
+	bool HasChanged() const;
+
+	/**
+	 * \brief Returns the value remembered by MarkUnchanged() as a
+	 *	readable string, formatted like ToString().
+	 *
+	 * @return A string, representing the variable's old value.
+	 */
+	string UnchangedValueToString() const;
+
 	/**
 	 * \brief Copy the value from another variable into this variable.
 	 *
@@ -276,6 +355,21 @@ public:
 	 */
 	bool SetValue(uint64_t value);
 
+	/**
+	 * \brief Gets a typed pointer to the variable's value.
+	 *
+	 * This allows hot code paths to read and write the value directly,
+	 * without going through ToInteger() or SetValue(). Note that writes
+	 * through the pointer bypass Component::CheckVariableWrite().
+	 *
+	 * Only the exact type of the variable is accepted, e.g.
+	 * <tt>GetTypedPointer<uint64_t>()</tt> on a UInt64 variable.
+	 *
+	 * @return A pointer to the value, or NULL if the variable is not
+	 *	of type T.
+	 */
+	template<class T> T* GetTypedPointer();
+
 
 	/********************************************************************/
 
@@ -326,7 +420,35 @@ private:
 		int64_t*	psint64;
 		CustomStateVariableHandler *phandler;
 	} m_value;
+
+	// The value when MarkUnchanged() was last called:
+	union {
+		bool		b;
+		double		d;
+		uint8_t		u8;
+		uint16_t	u16;
+		uint32_t	u32;
+		uint64_t	u64;
+		int8_t		s8;
+		int16_t		s16;
+		int32_t		s32;
+		int64_t		s64;
+	} m_unchangedValue;
+	string			m_unchangedString;
 };
 
 
+template<> string* StateVariable::GetTypedPointer<string>();
+template<> bool* StateVariable::GetTypedPointer<bool>();
+template<> double* StateVariable::GetTypedPointer<double>();
+template<> uint8_t* StateVariable::GetTypedPointer<uint8_t>();
+template<> uint16_t* StateVariable::GetTypedPointer<uint16_t>();
+template<> uint32_t* StateVariable::GetTypedPointer<uint32_t>();
+template<> uint64_t* StateVariable::GetTypedPointer<uint64_t>();
+template<> int8_t* StateVariable::GetTypedPointer<int8_t>();
+template<> int16_t* StateVariable::GetTypedPointer<int16_t>();
+template<> int32_t* StateVariable::GetTypedPointer<int32_t>();
+template<> int64_t* StateVariable::GetTypedPointer<int64_t>();
+
+
 #endif	// STATEVARIABLE_H
@@ -0,0 +1,126 @@
+#ifndef STATEVARIABLEREF_H
+#define	STATEVARIABLEREF_H
+
+/*
+ *  Copyright (C) 2014  Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+#include "misc.h"
+
+#include "Component.h"
+#include "StateVariable.h"
+
+
+/**
+ * \brief A typed handle to a state variable of a component.
+ *
+ * Looking up a state variable by name, and converting its value using e.g.
+ * StateVariable::ToInteger(), is too slow for code which runs often, such
+ * as the scheduler in GXemul::Execute(). A StateVariableRef is resolved
+ * once, and then accesses the component's member variable directly.
+ *
+ * The handle keeps a reference to the component, so the pointer stays
+ * valid even if the component is removed from the tree. It is up to the
+ * owner of the handle to call Invalidate() and resolve it again when the
+ * component tree changes, e.g. when cached state is flushed.
+ *
+ * Usage:<pre>
+ * StateVariableRef<uint64_t> step;
+ * if (step.Resolve(component, "step"))
+ *	*step += 1;
+ * </pre>
+ */
+template <class T>
+class StateVariableRef
+{
+public:
+	StateVariableRef()
+		: m_ptr(NULL)
+	{
+	}
+
+	/**
+	 * \brief Resolves the handle to a named variable of a component.
+	 *
+	 * @param component The component which holds the variable.
+	 * @param name The name of the variable.
+	 * @return true if the variable exists and is of type T, false
+	 *	otherwise (the handle is then invalid).
+	 */
+	bool Resolve(refcount_ptr<Component> component, const string& name)
+	{
+		Invalidate();
+
+		if (component.IsNULL())
+			return false;
+
+		StateVariable* var = component->GetVariable(name);
+		if (var == NULL)
+			return false;
+
+		m_ptr = var->GetTypedPointer<T>();
+		if (m_ptr != NULL)
+			m_component = component;
+
+		return m_ptr != NULL;
+	}
+
+	/**
+	 * \brief Makes the handle invalid, and releases the component.
+	 */
+	void Invalidate()
+	{
+		m_ptr = NULL;
+		m_component = NULL;
+	}
+
+	/**
+	 * \brief Checks whether the handle refers to a variable.
+	 *
+	 * @return true if the handle has been resolved, false otherwise.
+	 */
+	bool IsValid() const
+	{
+		return m_ptr != NULL;
+	}
+
+	T& operator *()
+	{
+		return *m_ptr;
+	}
+
+	const T& operator *() const
+	{
+		return *m_ptr;
+	}
+
+private:
+	T*			m_ptr;
+	refcount_ptr<Component>	m_component;
+};
+
+
+#endif	// STATEVARIABLEREF_H
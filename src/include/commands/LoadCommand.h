@@ -59,6 +59,10 @@ private:
 	bool IsComponentTree(GXemul& gxemul, const string& filename) const;
 	bool LoadComponentTree(GXemul& gxemul, const string&filename,
 		refcount_ptr<Component> specifiedComponent) const;
+	bool AddLoadedComponentTree(GXemul& gxemul, const string& filename,
+		refcount_ptr<Component> specifiedComponent,
+		refcount_ptr<Component> component,
+		const string& messages) const;
 };
 
 
@@ -37,6 +37,12 @@
 #include "UnitTest.h"
 
 
+// Direct-mapped host pages, used for fast loads and stores:
+#define	HOST_PAGE_SHIFT		12
+#define	HOST_PAGE_SIZE		(1 << HOST_PAGE_SHIFT)
+#define	N_HOST_PAGES		1024
+
+
 /**
  * \brief A base-class for processors Component implementations.
  */
@@ -95,6 +101,9 @@ public:
 	virtual bool WriteData(const uint16_t& data, Endianness endianness);
 	virtual bool WriteData(const uint32_t& data, Endianness endianness);
 	virtual bool WriteData(const uint64_t& data, Endianness endianness);
+	virtual bool ReadBlock(uint64_t address, uint8_t* data, size_t len);
+	virtual bool WriteBlock(uint64_t address, const uint8_t* data,
+		size_t len);
 
 	/**
 	 * \brief Disassembles an instruction into readable strings.
@@ -176,6 +185,63 @@ protected:
 		return pc;
 	}
 
+	/**
+	 * \brief Looks up a direct host pointer for a virtual address.
+	 *
+	 * A small direct-mapped table of host pages is kept per CPU, and
+	 * filled in on demand via VirtualToPhysical() and the address data
+	 * bus' LookupHostPage(). Loads and stores to plain RAM can then skip
+	 * the AddressSelect()/ReadData()/WriteData() path entirely.
+	 *
+	 * @param vaddr The virtual address.
+	 * @param forWriting True for stores, false for loads.
+	 * @return A host pointer, or NULL if the access has to go via
+	 *	the AddressDataBus interface (e.g. for memory mapped devices).
+	 */
+	uint8_t* LookupHostPointer(uint64_t vaddr, bool forWriting)
+	{
+		const uint64_t offset = vaddr & (HOST_PAGE_SIZE - 1);
+		HostPageEntry& entry = m_hostPages[(vaddr >> HOST_PAGE_SHIFT)
+		    & (N_HOST_PAGES - 1)];
+
+		if (entry.vaddr == vaddr - offset &&
+		    *entry.generation == entry.generationValue) {
+			uint8_t* host = forWriting? entry.hostStore
+			    : entry.hostLoad;
+			if (host != NULL)
+				return host + offset;
+		}
+
+		return LookupHostPointerSlow(vaddr, forWriting);
+	}
+
+	/**
+	 * \brief Converts between guest and host byte order.
+	 *
+	 * Used for data accessed via LookupHostPointer().
+	 */
+	uint8_t GuestToHost(uint8_t x) const
+	{
+		return x;
+	}
+	uint16_t GuestToHost(uint16_t x) const
+	{
+		return m_isBigEndian? BE16_TO_HOST(x) : LE16_TO_HOST(x);
+	}
+	uint32_t GuestToHost(uint32_t x) const
+	{
+		return m_isBigEndian? BE32_TO_HOST(x) : LE32_TO_HOST(x);
+	}
+	uint64_t GuestToHost(uint64_t x) const
+	{
+		return m_isBigEndian? BE64_TO_HOST(x) : LE64_TO_HOST(x);
+	}
+
+	/**
+	 * \brief Invalidates all direct host page mappings.
+	 */
+	void InvalidateHostPages();
+
 	// CPUComponent:
 	bool FunctionTraceCall();
 	bool FunctionTraceReturn();
@@ -187,6 +253,7 @@ protected:
 
 private:
 	bool LookupAddressDataBus(GXemul* gxemul = NULL);
+	uint8_t* LookupHostPointerSlow(uint64_t vaddr, bool forWriting);
 
 protected:
 	/*
@@ -230,6 +297,18 @@ protected:
 	uint64_t		m_addressSelect;
 	bool			m_exceptionOrAbortInDelaySlot;
 
+	// Direct-mapped host pages, see LookupHostPointer(). hostStore is
+	// only set once the page has been looked up for writing. The entry
+	// is only valid while *generation is equal to generationValue.
+	struct HostPageEntry {
+		uint64_t		vaddr;
+		uint8_t*		hostLoad;
+		uint8_t*		hostStore;
+		const uint64_t*		generation;
+		uint64_t		generationValue;
+	};
+	HostPageEntry		m_hostPages[N_HOST_PAGES];
+
 private:
 	SymbolRegistry		m_symbolRegistry;
 };
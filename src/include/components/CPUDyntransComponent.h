@@ -41,6 +41,12 @@ class CPUDyntransComponent;
 
 
 #define N_DYNTRANS_IC_ARGS	3
+
+// The largest number of cycles that a single instruction call may account
+// for, e.g. a combination of several instructions, or a branch together with
+// its delay slot.
+#define DYNTRANS_MAX_IC_CYCLES	8
+
 /**
  * \brief A dyntrans instruction call.
  *
@@ -101,6 +107,12 @@ public:
 
 	virtual int Execute(GXemul* gxemul, int nrOfCycles);
 
+	virtual void GetMethodNames(vector<string>& names) const;
+
+	virtual void ExecuteMethod(GXemul* gxemul,
+		const string& methodName,
+		const vector<string>& arguments);
+
 
 	/********************************************************************/
 
@@ -116,6 +128,39 @@ protected:
 	bool DyntransReadInstruction(uint32_t& iword);
 	void DyntransToBeTranslatedDone(struct DyntransIC*);
 
+	/**
+	 * \brief Combine a newly translated instruction call with the
+	 *	preceding instruction calls on the same page.
+	 *
+	 * Called after an instruction has been translated, but before it is
+	 * executed. Implementations may only rewrite instruction calls
+	 * <i>before</i> ic on the page. A combined instruction call must
+	 * account for all the cycles it executes (by increasing
+	 * m_executedCycles by the number of extra instructions), must not
+	 * account for more than DYNTRANS_MAX_IC_CYCLES cycles, and should
+	 * fall back to executing only its own instruction when it is executed
+	 * in a delay slot or when fewer cycles are left to execute.
+	 *
+	 * The default implementation combines runs of nops. CPU
+	 * implementations that override this function should also call the
+	 * base class' implementation.
+	 *
+	 * @param ic The newly translated instruction call.
+	 */
+	virtual void DyntransCombineInstructions(struct DyntransIC* ic);
+
+	/**
+	 * \brief Stop the current run because the CPU is spinning in an
+	 *	idle loop.
+	 *
+	 * Called by an instruction call which has just executed the first
+	 * instruction of a two-instruction loop that cannot change any state
+	 * for the rest of the run, with m_nextIC pointing to the second
+	 * instruction of the loop. Execute() then counts the rest of the run
+	 * as executed, without actually executing it.
+	 */
+	void DyntransIdle();
+
 	/**
 	 * \brief Calculate m_pc based on m_nextIC and m_firstIConPage.
 	 */
@@ -141,6 +186,7 @@ protected:
 	 * several different cpu architectures.
 	 */
 	DECLARE_DYNTRANS_INSTR(nop);
+	DECLARE_DYNTRANS_INSTR(multi_nop);
 	DECLARE_DYNTRANS_INSTR(abort);
 	DECLARE_DYNTRANS_INSTR(endOfPage);
 	DECLARE_DYNTRANS_INSTR(endOfPage2);
@@ -177,14 +223,13 @@ protected:
 	DECLARE_DYNTRANS_INSTR(shift_left_u64_u64_imm5_truncS32);
 	DECLARE_DYNTRANS_INSTR(shift_right_u64_u64asu32_imm5_truncS32);
 
-private:
+public:
 	class DyntransTranslationPage
 	{
 	public:
 		DyntransTranslationPage(int nICentriesPerpage)
 			: m_prev(-1)
 			, m_next(-1)
-			, m_nextCacheEntryForAddr(-1)
 			, m_addr(0)
 			, m_showFunctionTraceCall(false)
 		{
@@ -197,7 +242,6 @@ private:
 		int				m_next;
 
 		// Address match:
-		int				m_nextCacheEntryForAddr;
 		uint64_t			m_addr;
 
 		// Flags for this page:
@@ -210,9 +254,29 @@ private:
 		vector< struct DyntransIC >	m_ic;
 	};
 
+	/**
+	 * \brief A cache of translated pages.
+	 *
+	 * Pages are looked up in an open addressing hash table (with linear
+	 * probing), keyed on the full page address. The table has at least
+	 * twice as many slots as there are pages in the cache, so probe
+	 * sequences stay short regardless of how much memory is emulated, or
+	 * where in the address space it is.
+	 */
 	class DyntransTranslationCache
 	{
 	public:
+		/**
+		 * \brief Lookup statistics, for tuning the translation cache.
+		 */
+		struct Statistics
+		{
+			uint64_t	hits;
+			uint64_t	misses;
+			uint64_t	probes;		// hash table slots examined
+			uint64_t	longestProbe;	// most slots for one lookup
+		};
+
 		DyntransTranslationCache()
 			: m_nICentriesPerpage(0)
 			, m_pageShift(0)
@@ -220,7 +284,9 @@ private:
 			, m_lastFree(-1)
 			, m_firstMRU(-1)
 			, m_lastMRU(-1)
+			, m_hashShift(0)
 		{
+			ResetStatistics();
 		}
 
 		void Reinit(size_t approximateSize, int nICentriesPerpage, int pageShift)
@@ -261,17 +327,35 @@ private:
 			// No pages in use yet, so nothing on the MRU list:
 			m_firstMRU = m_lastMRU = -1;
 
-			// Reset the quick lookup table:
-			// (Currently hardcoded to allow the first 1 GB of emulated physical memory
-			// to be looked up with 1 call, if more than 1 GB of RAM is used, the
-			// m_nextCacheEntryForAddr chain must be traversed...)
-			m_addrToFirstPageIndex.resize(1024 * 1048576 >> m_pageShift);
-			for (size_t i=0; i<m_addrToFirstPageIndex.size(); ++i)
-				m_addrToFirstPageIndex[i] = -1;
+			// Reset the hash table. Its size is a power of two, with
+			// at least twice as many slots as there are pages:
+			size_t hashTableSize = 1;
+			m_hashShift = 64;
+			while (hashTableSize < nrOfPages * 2) {
+				hashTableSize <<= 1;
+				m_hashShift --;
+			}
 
+			m_hashTable.clear();
+			m_hashTable.resize(hashTableSize, -1);
+
+			ResetStatistics();
 			ValidateConsistency();
 		}
 
+		const Statistics& GetStatistics() const
+		{
+			return m_statistics;
+		}
+
+		void ResetStatistics()
+		{
+			m_statistics.hits = 0;
+			m_statistics.misses = 0;
+			m_statistics.probes = 0;
+			m_statistics.longestProbe = 0;
+		}
+
 		void ValidateConsistency()
 		{
 #ifndef NDEBUG
@@ -331,59 +415,26 @@ private:
 				}
 			}
 
-			vector<bool> pageIsPointedToByQuickLookupTable;
-			vector<bool> pageIsPointedToByQLTChain;
-			pageIsPointedToByQuickLookupTable.resize(m_pageCache.size(), false);
-			pageIsPointedToByQLTChain.resize(m_pageCache.size(), false);
+			vector<bool> pageIsInHashTable;
+			pageIsInHashTable.resize(m_pageCache.size(), false);
 
-			for (size_t k=0; k<m_addrToFirstPageIndex.size(); ++k)
-				if (m_addrToFirstPageIndex[k] >= 0)
-					pageIsPointedToByQuickLookupTable[m_addrToFirstPageIndex[k]] = true;
+			for (size_t k=0; k<m_hashTable.size(); ++k)
+				if (m_hashTable[k] >= 0)
+					pageIsInHashTable[m_hashTable[k]] = true;
 
 			for (size_t k=0; k<m_pageCache.size(); ++k) {
-				int index = m_pageCache[k].m_nextCacheEntryForAddr;
-				if (index >= 0)
-					pageIsPointedToByQLTChain[index] = true;
-			}
-
-			for (size_t k=0; k<pageIsInFreeList.size(); ++k) {
-				if (!pageIsInFreeList[k])
-					continue;
-
-				if (m_pageCache[k].m_nextCacheEntryForAddr >= 0) {
-					std::cerr << "Pages on the free-list should not have m_nextCacheEntryForAddr set!\n";
-					throw std::exception();
-				}
-
-				if (pageIsPointedToByQuickLookupTable[k]) {
-					std::cerr << "Pages on the free-list should not be pointed to by the quick lookup table!\n";
-					throw std::exception();
-				}
-
-				if (pageIsPointedToByQLTChain[k]) {
-					std::cerr << "Pages on the free-list should not be in the quick lookup table chain!\n";
+				if (pageIsInFreeList[k] && pageIsInHashTable[k]) {
+					std::cerr << "Pages on the free-list should not be in the hash table!\n";
 					throw std::exception();
 				}
-			}
 
-			for (size_t k=0; k<pageIsInMRUList.size(); ++k) {
 				if (!pageIsInMRUList[k])
 					continue;
 
-				uint64_t addr = m_pageCache[k].m_addr;
-				uint64_t physPageNumber = addr >> m_pageShift;
-				int quickLookupIndex = physPageNumber & (m_addrToFirstPageIndex.size() - 1);
-				int pageIndex = m_addrToFirstPageIndex[quickLookupIndex];
-
-				while (pageIndex >= 0) {
-					if (m_pageCache[pageIndex].m_addr == addr)
-						break;
-
-					pageIndex = m_pageCache[pageIndex].m_nextCacheEntryForAddr;
-				}
-
-				if (pageIndex < 0) {
-					std::cerr << "Pages in the MRU list must be reachable from the quick lookup table!\n";
+				size_t probes;
+				size_t slot = FindSlot(m_pageCache[k].m_addr, probes);
+				if (m_hashTable[slot] != (int) k) {
+					std::cerr << "Pages in the MRU list must be reachable from the hash table!\n";
 					throw std::exception();
 				}
 			}
@@ -423,26 +474,8 @@ private:
 				m_firstFree = index;
 			}
 
-			// Remove from the quick lookup chain:
-			uint64_t physPageNumber = m_pageCache[index].m_addr >> m_pageShift;
-			int quickLookupIndex = physPageNumber & (m_addrToFirstPageIndex.size() - 1);
-			int pageIndex = m_addrToFirstPageIndex[quickLookupIndex];
-			if (pageIndex == index) {
-				// Direct hit? Then remove from the base quick look up table...
-				m_addrToFirstPageIndex[quickLookupIndex] = m_pageCache[index].m_nextCacheEntryForAddr;
-			} else {
-				// ... otherwise traverse the chain until the next entry is the one we are removing.
-				while (true) {
-					if (m_pageCache[pageIndex].m_nextCacheEntryForAddr == index) {
-						m_pageCache[pageIndex].m_nextCacheEntryForAddr = m_pageCache[index].m_nextCacheEntryForAddr;
-						break;
-					}
-
-					pageIndex = m_pageCache[pageIndex].m_nextCacheEntryForAddr;
-				}
-			}
-
-			m_pageCache[index].m_nextCacheEntryForAddr = -1;
+			// Remove from the hash table:
+			RemoveFromHashTable(m_pageCache[index].m_addr);
 
 			ValidateConsistency();
 		}
@@ -484,19 +517,11 @@ private:
 			m_pageCache[index].m_addr = addr;
 			m_pageCache[index].m_showFunctionTraceCall = showFunctionTraceCall;
 
-			// Insert into quick lookup table:
-			uint64_t physPageNumber = addr >> m_pageShift;
-			int quickLookupIndex = physPageNumber & (m_addrToFirstPageIndex.size() - 1);
-
-			// Are we the only one? (I.e. the first page for this quick lookup index.)
-			if (m_addrToFirstPageIndex[quickLookupIndex] < 0) {
-				m_addrToFirstPageIndex[quickLookupIndex] = index;
-				m_pageCache[index].m_nextCacheEntryForAddr = -1;
-			} else {
-				// No. Let's add ourselves first in the chain:
-				m_pageCache[index].m_nextCacheEntryForAddr = m_addrToFirstPageIndex[quickLookupIndex];
-				m_addrToFirstPageIndex[quickLookupIndex] = index;
-			}
+			// Insert into the hash table:
+			size_t probes;
+			size_t slot = FindSlot(addr, probes);
+			assert(m_hashTable[slot] < 0);
+			m_hashTable[slot] = index;
 
 			ValidateConsistency();
 
@@ -509,26 +534,20 @@ private:
 
 			// Strip of the low bits:
 			addr >>= m_pageShift;
-			uint64_t physPageNumber = addr;
 			addr <<= m_pageShift;
 
-			int quickLookupIndex = physPageNumber & (m_addrToFirstPageIndex.size() - 1);
-			int pageIndex = m_addrToFirstPageIndex[quickLookupIndex];
+			size_t probes;
+			size_t slot = FindSlot(addr, probes);
+			int pageIndex = m_hashTable[slot];
 
-			// std::cerr << "addr " << addr << ", physPageNumber " << physPageNumber << ", quickLookupIndex " << quickLookupIndex << ", pageIndex " << pageIndex << "\n";
-
-			// If pageIndex >= 0, then pageIndex points to a page which _may_ be for this addr.
-			while (pageIndex >= 0) {
-				if (m_pageCache[pageIndex].m_addr == addr)
-					break;
-
-				// If the page for pageIndex was for some other address, then
-				// let's continue searching the chain...
-				pageIndex = m_pageCache[pageIndex].m_nextCacheEntryForAddr;
-			}
+			m_statistics.probes += probes;
+			if (probes > m_statistics.longestProbe)
+				m_statistics.longestProbe = probes;
 
 			// If we have a definite page index, then return a pointer that page's ICs:
 			if (pageIndex >= 0) {
+				++ m_statistics.hits;
+
 				// Update the MRU list, unless this page was already first,
 				// so that m_firstMRU points to the page.
 				if (m_firstMRU != pageIndex) {
@@ -551,15 +570,15 @@ private:
 					m_firstMRU = pageIndex;
 				}
 
-				// TODO: Hm... also move to front of the Quick Lookup chain?
-				// Only necessary if more memory is used/emulated than the
-				// size of the quick lookup table, e.g. if 2 GB ram are used,
-				// and the size of the lookup table is 1 GB, and pages
-				// at exactly 0 GB and 1 GB are used in this order:
-				// 1 0 1 1 1 1 1 1 1 1 1 1 1
-				// then 1 would first be placed in the chain, then 0 (which
-				// would insert it first in the chain). But all lookups after
-				// that would have to search the whole chain (0, 1) to find 1.
+				// Move to front: swap places with the entry in the
+				// page's home slot, so that the next lookup needs
+				// only one probe. There are no empty slots between
+				// the two, so the other entry remains reachable.
+				if (probes > 1) {
+					size_t home = HashSlot(addr);
+					m_hashTable[slot] = m_hashTable[home];
+					m_hashTable[home] = pageIndex;
+				}
 
 				ValidateConsistency();
 
@@ -574,6 +593,7 @@ private:
 
 			// The address was NOT in the translation cache at all. So we have
 			// to create a new page.
+			++ m_statistics.misses;
 
 			// If the free-list is all used up, that means we have to free something
 			// before we can allocate a new page...
@@ -586,6 +606,63 @@ private:
 		}
 
 	private:
+		/**
+		 * \brief Calculates the home slot of a page in the hash table.
+		 *
+		 * Multiplicative (Fibonacci) hashing: the top bits of the
+		 * product depend on all bits of the page number, so pages which
+		 * are far apart in the address space do not collide more often
+		 * than pages which are close together.
+		 */
+		size_t HashSlot(uint64_t addr) const
+		{
+			uint64_t physPageNumber = addr >> m_pageShift;
+			return (size_t) ((physPageNumber * 0x9e3779b97f4a7c15ULL) >> m_hashShift);
+		}
+
+		/**
+		 * \brief Finds the slot which holds a page address, or the empty
+		 *	slot where it would be inserted.
+		 */
+		size_t FindSlot(uint64_t addr, size_t& probes) const
+		{
+			size_t mask = m_hashTable.size() - 1;
+			size_t slot = HashSlot(addr);
+
+			probes = 1;
+			while (m_hashTable[slot] >= 0 &&
+			    m_pageCache[m_hashTable[slot]].m_addr != addr) {
+				slot = (slot + 1) & mask;
+				++ probes;
+			}
+
+			return slot;
+		}
+
+		void RemoveFromHashTable(uint64_t addr)
+		{
+			size_t probes;
+			size_t slot = FindSlot(addr, probes);
+			size_t mask = m_hashTable.size() - 1;
+			assert(m_hashTable[slot] >= 0);
+
+			// Move later entries of the probe sequence back into the
+			// hole, unless that would place them before their home
+			// slot. (No tombstones are needed that way.)
+			size_t next = (slot + 1) & mask;
+			while (m_hashTable[next] >= 0) {
+				size_t home = HashSlot(m_pageCache[m_hashTable[next]].m_addr);
+				if (((next - home) & mask) >= ((next - slot) & mask)) {
+					m_hashTable[slot] = m_hashTable[next];
+					slot = next;
+				}
+
+				next = (next + 1) & mask;
+			}
+
+			m_hashTable[slot] = -1;
+		}
+
 		// Number of translated instructions per page, and number of bits
 		// to shift to convert address to page number:
 		int				m_nICentriesPerpage;
@@ -599,11 +676,14 @@ private:
 		int				m_firstMRU;
 		int				m_lastMRU;
 
-		// "Usually" quick lookup table, address to page index:
-		vector<int>			m_addrToFirstPageIndex;
+		// Hash table, page address to page index (-1 = empty slot):
+		vector<int>			m_hashTable;
+		int				m_hashShift;
 
 		// The actual pages:
 		vector<DyntransTranslationPage>	m_pageCache;
+
+		Statistics			m_statistics;
 	};
 
 protected:
@@ -617,6 +697,7 @@ protected:
 	int			m_dyntransICshift;
 	int			m_executedCycles;
 	int			m_nrOfCyclesToExecute;
+	bool			m_idling;
 
 	/*
 	 * Translation cache:
@@ -378,6 +378,7 @@ protected:
 
 	virtual int GetDyntransICshift() const;
 	virtual DyntransIC_t GetDyntransToBeTranslated() const ;
+	virtual void DyntransCombineInstructions(struct DyntransIC* ic);
 
 	virtual void ShowRegisters(GXemul* gxemul, const vector<string>& arguments) const;
 
@@ -420,6 +421,7 @@ private:
 	template<bool one> static void instr_tb(CPUDyntransComponent* cpubase, DyntransIC* ic);
 	template<bool store, typename T, bool doubleword, bool regofs, bool scaled, bool signedLoad> static void instr_loadstore(CPUDyntransComponent* cpubase, DyntransIC* ic);
 	template<int scaleFactor> static void instr_lda(CPUDyntransComponent* cpubase, DyntransIC* ic);
+	DECLARE_DYNTRANS_INSTR(idle);
 
 	void Translate(uint32_t iword, struct DyntransIC* ic);
 	DECLARE_DYNTRANS_INSTR(ToBeTranslated);
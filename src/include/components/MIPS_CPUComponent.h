@@ -197,6 +197,7 @@ protected:
 
 	virtual int GetDyntransICshift() const;
 	virtual DyntransIC_t GetDyntransToBeTranslated() const;
+	virtual void DyntransCombineInstructions(struct DyntransIC* ic);
 
 	virtual void ShowRegisters(GXemul* gxemul, const vector<string>& arguments) const;
 
@@ -216,6 +217,7 @@ private:
 	DECLARE_DYNTRANS_INSTR(sltu);
 
 	template<bool store, typename addressType, typename T, bool signedLoad> static void instr_loadstore(CPUDyntransComponent* cpubase, DyntransIC* ic);
+	template<bool store, typename addressType, int n> static void instr_multi_loadstore(CPUDyntransComponent* cpubase, DyntransIC* ic);
 
 	void Translate(uint32_t iword, struct DyntransIC* ic);
 	DECLARE_DYNTRANS_INSTR(ToBeTranslated);
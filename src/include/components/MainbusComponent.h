@@ -87,6 +87,11 @@ public:
 	virtual bool WriteData(const uint16_t& data, Endianness endianness);
 	virtual bool WriteData(const uint32_t& data, Endianness endianness);
 	virtual bool WriteData(const uint64_t& data, Endianness endianness);
+	virtual bool ReadBlock(uint64_t address, uint8_t* data, size_t len);
+	virtual bool WriteBlock(uint64_t address, const uint8_t* data,
+		size_t len);
+	virtual uint8_t* LookupHostPage(uint64_t address, size_t pageSize,
+		bool forWriting, const uint64_t*& generation);
 
 
 	/********************************************************************/
@@ -97,26 +102,34 @@ protected:
 	virtual void FlushCachedStateForComponent();
 	virtual bool PreRunCheckForComponent(GXemul* gxemul);
 
-private:
-	bool MakeSureMemoryMapExists(GXemul* gxemul = NULL);
-
 private:
 	struct MemoryMapEntry {
 		uint64_t		base;
 		uint64_t		size;
 		uint64_t		addrMul;
 		AddressDataBus *	addressDataBus;
+		Component *		component;
+
+		bool operator < (const MemoryMapEntry& other) const
+		{
+			return base < other.base;
+		}
 	};
 
+	bool MakeSureMemoryMapExists(GXemul* gxemul = NULL);
+	const MemoryMapEntry* FindMemoryMapEntry(uint64_t address);
+
+private:
+	// The memory map is sorted by base address, and looked up using
+	// binary search. The most recently found entry is checked first.
 	typedef vector<MemoryMapEntry> MemoryMap;
 	MemoryMap			m_memoryMap;
 	bool				m_memoryMapFailed;
 	bool				m_memoryMapValid;
+	size_t				m_lastHitIndex;
 
 	// For the currently selected address:
 	AddressDataBus *	m_currentAddressDataBus;
-
-	// TODO: direct page access...
 };
 
 
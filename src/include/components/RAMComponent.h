@@ -37,6 +37,7 @@
 #include "UnitTest.h"
 
 #include <string.h>
+#include <deque>
 #include <iomanip>
 
 
@@ -127,6 +128,11 @@ public:
 	virtual bool WriteData(const uint16_t& data, Endianness endianness);
 	virtual bool WriteData(const uint32_t& data, Endianness endianness);
 	virtual bool WriteData(const uint64_t& data, Endianness endianness);
+	virtual bool ReadBlock(uint64_t address, uint8_t* data, size_t len);
+	virtual bool WriteBlock(uint64_t address, const uint8_t* data,
+		size_t len);
+	virtual uint8_t* LookupHostPage(uint64_t address, size_t pageSize,
+		bool forWriting, const uint64_t*& generation);
 
 
 	/********************************************************************/
@@ -136,7 +142,47 @@ public:
 private:
 	void ReleaseAllBlocks();
 
-	void* AllocateBlock();
+	/*
+	 * Changes the generation counter of block nr blockNr, so that host
+	 * pointers into the block handed out by LookupHostPage() are not
+	 * used anymore.
+	 */
+	void InvalidateHostPages(uint64_t blockNr);
+
+	/*
+	 * Returns a pointer to host memory block nr blockNr, which may be
+	 * written to. The block is allocated if it did not exist yet, and
+	 * copied if it was shared with a clone of this component.
+	 */
+	void* GetWritableBlock(uint64_t blockNr);
+
+	/*
+	 * A host memory block. Blocks are reference counted, so that clones
+	 * of the RAM component (e.g. snapshots) can share them until one
+	 * of the components writes to the block.
+	 */
+	class RAMBlock : public ReferenceCountable
+	{
+	public:
+		RAMBlock(size_t size);
+
+		/*
+		 * Takes over already mmap()ed memory, e.g. a section
+		 * mapped from a binary emulation file.
+		 */
+		RAMBlock(void* data, size_t size);
+
+		~RAMBlock();
+
+		void* GetData() const
+		{
+			return m_data;
+		}
+
+	private:
+		void*		m_data;
+		size_t		m_size;
+	};
 
 	class RAMDataHandler : public CustomStateVariableHandler
 	{
@@ -150,141 +196,49 @@ private:
 		{
 		}
 	
-		virtual void Serialize(ostream& ss) const
-		{
-			for (size_t i=0; i<m_ram.m_memoryBlocks.size(); ++i)
-				if (m_ram.m_memoryBlocks[i] != NULL)
-					SerializeMemoryBlock(ss, i, m_ram.m_memoryBlocks[i]);
+		/*
+		 * The contents are serialized as a sequence of records, one
+		 * per run of non-zero rows of RAM (all-zero rows are left
+		 * out), followed by a final dot:
+		 *
+		 *	xxxxxxxxxxxxxxxx:yyyyyyyy=data.
+		 *
+		 * where x = address in the RAM component, y = length of
+		 * data in bytes, and data is base64 encoded. (Older files
+		 * use a hex dump instead, with ':' instead of '='.)
+		 */
+		virtual void Serialize(ostream& ss) const;
+		virtual bool Deserialize(const string& value);
+
+		/*
+		 * In binary emulation files, each allocated host memory
+		 * block is stored as a section of its own, which is mapped
+		 * (copy-on-write) directly from the file when loading.
+		 */
+		virtual void SerializeBinary(BinaryWriter& writer) const;
+		virtual bool DeserializeBinary(BinaryReader& reader);
 
-			// End of data.
-			ss << ".";
-		}
-		
-		virtual bool Deserialize(const string& value)
-		{
-			m_ram.ReleaseAllBlocks();
-			
-			size_t p = 0;
-			size_t len = value.length();
-			const char *cstr = value.c_str();
-			
-			while (p < len) {
-				if (cstr[p] == '.') {
-					p++;
-					continue;
-				}
-
-				// xxxxxxxxxxxxxxxx:yyyyyyyy:data.
-				// where x = address in the RAM component,
-				// y = length of data in bytes.
-				// data = hex dump.
-
-				// Some margin... :)  Yuck. This is ugly.
-				if (p + 40 > len) {
-					std::cerr << "deserialize ram: internal error\n";
-					throw std::exception();
-				}
-
-				char s1[17];
-				char s2[9];
-				memcpy(s1, cstr + p, 16);
-				p += 17;
-				memcpy(s2, cstr + p, 8);
-				p += 9;
-				s1[16] = 0;
-				s2[8] = 0;
-				stringstream ss1;
-				ss1.flags(std::ios::hex);
-				ss1 << s1;
-				uint64_t addr;
-				ss1 >> addr;
-				stringstream ss2;
-				ss2.flags(std::ios::hex);
-				ss2 << s2;
-				uint32_t datalen;
-				ss2 >> datalen;
-				// p points to data.
-				if (p + 2*datalen < len) {
-					for (size_t i=0; i<datalen; i++) {
-						char c1 = cstr[p++];
-						char c2 = cstr[p++];
-						
-						if (c1 >= 'a' && c1 <= 'f')
-							c1 = (c1-'a') + 10;
-						else
-							c1 -= '0';
-
-						if (c2 >= 'a' && c2 <= 'f')
-							c2 = (c2-'a') + 10;
-						else
-							c2 -= '0';
-						
-						uint8_t b = c1*16 + c2;
-						
-						m_ram.AddressSelect(i + addr);
-						m_ram.WriteData(b, BigEndian);
-					}
-				} else {
-					std::cerr << "deserialize ram: internal error\n";
-					throw std::exception();
-				}
-				
-				if (cstr[p] != '.') {
-					std::cerr << "deserialize ram: internal error: no dot\n";
-					throw std::exception();
-				}
-			}
-			
-			return true;
-		}
-		
 		virtual void CopyValueFrom(CustomStateVariableHandler* other)
 		{
-			// NOTE/TODO: Not space efficient, but works for now.
-
-			stringstream ss;
-			other->Serialize(ss);
-			Deserialize(ss.str());
-		}
-
-	private:
-		void SerializeMemoryBlock(ostream& ss, size_t blockNr, void *block) const
-		{
-			const size_t rowSize = 1024;
-			uint64_t addr = blockNr << m_ram.m_blockSizeShift;
-			uint64_t addrWithinBlock = 0;
-
-			while (addrWithinBlock < m_ram.m_blockSize) {
-				uint8_t *data = (uint8_t*)block + addrWithinBlock;
-
-				bool allZeroes = true;
-				for (size_t i=0; i<rowSize; i++)
-					if (data[i] != 0x00) {
-						allZeroes = false;
-						break;
-					}
-
-				// Only output the row if it contains something
-				// which is non-zero.
-				if (!allZeroes)
-					SerializeRow(ss, addr, data, rowSize);
-
-				addrWithinBlock += rowSize;
-				addr += rowSize;
-			}
-		}
-
-		// NOTE/TODO: Not space efficient, but works for now.
-		void SerializeRow(ostream& ss, uint64_t addr, uint8_t* data, size_t rowSize) const
-		{
-			ss.flags(std::ios::hex);
-			ss << std::setw(16) << std::setfill('0') << addr << ":";
-			ss << std::setw(8) << std::setfill('0') << rowSize << ":";
-
-			for (size_t i=0; i<rowSize; i++)
-				ss << std::setw(2) << std::setfill('0') << (int)data[i];
+			// Custom variables are only copied between components
+			// of the same class, so other is a RAMDataHandler.
+			RAMDataHandler* otherRAM =
+			    static_cast<RAMDataHandler*>(other);
+
+			// Share the host memory blocks. They are copied when
+			// either component writes to them, so host pages
+			// which were handed out for writing may not be
+			// written through anymore.
+			m_ram.ReleaseAllBlocks();
+			m_ram.m_memoryBlocks = otherRAM->m_ram.m_memoryBlocks;
+			for (size_t i=0; i<m_ram.m_memoryBlocks.size(); ++i)
+				otherRAM->m_ram.InvalidateHostPages(i);
 
-			ss << ".";
+			// Neither component may write to its currently
+			// selected block without copying it first.
+			m_ram.AddressSelect(m_ram.m_addressSelect);
+			otherRAM->m_ram.AddressSelect(
+			    otherRAM->m_ram.m_addressSelect);
 		}
 
 	private:
@@ -298,14 +252,18 @@ private:
 	RAMDataHandler m_dataHandler;
 	
 	// State:
-	typedef vector<void *> BlockNrToMemoryBlockVector;
+	typedef vector< refcount_ptr<RAMBlock> > BlockNrToMemoryBlockVector;
 	BlockNrToMemoryBlockVector	m_memoryBlocks;
+	// Generation counters for LookupHostPage(), per block. (A deque,
+	// so that the counters do not move when more blocks are added.)
+	std::deque<uint64_t>		m_blockGenerations;
 	bool				m_writeProtected;
 	uint64_t			m_lastDumpAddr;
 
 	// Cached/runtime state:
 	uint64_t	m_addressSelect;  // For AddressDataBus read/write
 	void *		m_selectedHostMemoryBlock;
+	bool		m_selectedBlockWritable; // not shared with a clone
 	size_t		m_selectedOffsetWithinBlock;
 };
 
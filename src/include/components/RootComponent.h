@@ -49,6 +49,8 @@ class GXemul;
  *
  * <ul>
  *	<li>accuracy ("cycle" or "sloppy")
+ *	<li>snapshotInterval (nr of steps between snapshots, when
+ *		snapshotting/reverse execution is enabled)
  * </ul>
  *
  * NOTE: A RootComponent is not registered in the component registry, and
@@ -71,6 +73,8 @@ public:
 
 	virtual bool PreRunCheckForComponent(GXemul* gxemul);
 
+	virtual void FlushCachedStateForComponent();
+
 	GXemul* GetOwner()
 	{
 		return m_gxemul;
@@ -92,6 +96,7 @@ private:
 
 	// Model:
 	string		m_accuracy;
+	uint64_t	m_snapshotInterval;	// in steps
 };
 
 
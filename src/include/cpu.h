@@ -92,6 +92,17 @@
 		unsigned char	*host_page;				\
 	};
 
+#define	DYNTRANS_MISC32_DECLARATIONS(arch,ARCH,tlbindextype)		\
+	struct arch ## _l2_32_table {					\
+		unsigned char	*host_load[1 << DYNTRANS_L2N_32];	\
+		unsigned char	*host_store[1 << DYNTRANS_L2N_32];	\
+		uint32_t	phys_addr[1 << DYNTRANS_L2N_32];	\
+		tlbindextype	vaddr_to_tlbindex[1 << DYNTRANS_L2N_32]; \
+		struct arch ## _tc_physpage *phys_page[1 << DYNTRANS_L2N_32]; \
+		struct arch ## _l2_32_table	*next;			\
+		int		refcount;				\
+	};
+
 #define	DYNTRANS_MISC64_DECLARATIONS(arch,ARCH,tlbindextype)		\
 	struct arch ## _l3_64_table {					\
 		unsigned char	*host_load[1 << ARCH ## _L3N];		\
@@ -163,17 +174,22 @@ struct physpage_ranges {
  *  -------------------------------------------------------------------------
  *
  *  This stuff assumes that 4 KB pages are used. 20 bits to select a page
- *  means just 1 M entries needed. This is small enough that a couple of
- *  full-size tables can fit in virtual memory on modern hosts (both 32-bit
- *  and 64-bit hosts). :-)
+ *  means 1 M entries. Instead of having full-size tables in each cpu struct,
+ *  a two-level table is used: the top DYNTRANS_L1N_32 bits of the page number
+ *  select an l2 table in l1_32, and the remaining DYNTRANS_L2N_32 bits select
+ *  the entry within that table. (Each l2 table covers 4 MB.)
  *
  *  Usage: e.g. VPH32(arm,ARM)
  *           or VPH32(sparc,SPARC)
  *
- *  The vph_tlb_entry entries are cpu dependent tlb entries.
+ *  l2_32_dummy is a pointer to a "dummy l2 table", in which all entries are
+ *  NULL/zero. Unused slots in l1_32 point to the dummy table instead of
+ *  being NULL, so the lookup never has to check for a missing table. Real
+ *  l2 tables are allocated when a translation is added, and are put on the
+ *  next_free_l2_32 list when their last translation is removed.
  *
- *  The host_load and host_store entries point to host pages; the phys_addr
- *  entries are uint32_t (emulated physical addresses).
+ *  In each l2 table, the host_load and host_store entries point to host
+ *  pages; the phys_addr entries are uint32_t (emulated physical addresses).
  *
  *  phys_page points to translation cache physpages.
  *
@@ -182,28 +198,33 @@ struct physpage_ranges {
  *  3 means tlb index 2. A value of 0 would mean a tlb index of -1, which
  *  is not a valid index. (I.e. no hit.)
  *
- *  The VPH32EXTENDED variant adds an additional postfix to the array
- *  names. Used so far only for usermode addresses in M88K emulation.
+ *  The VPH32EXTENDED variant adds an additional postfix to the l1 table
+ *  name. Used so far only for usermode addresses in M88K emulation.
+ *
+ *  The VPH32_* macros below take an l1 table and a 20-bit page number (i.e.
+ *  a 32-bit virtual address shifted right by 12), and evaluate to the
+ *  corresponding l2 table entry.
  */
 #define	N_VPH32_ENTRIES		1048576
+#define	DYNTRANS_L1N_32		10
+#define	DYNTRANS_L2N_32		10
 #define	VPH32(arch,ARCH)						\
-	unsigned char		*host_load[N_VPH32_ENTRIES];		\
-	unsigned char		*host_store[N_VPH32_ENTRIES];		\
-	uint32_t		phys_addr[N_VPH32_ENTRIES];		\
-	struct arch ## _tc_physpage  *phys_page[N_VPH32_ENTRIES];	\
-	uint8_t			vaddr_to_tlbindex[N_VPH32_ENTRIES];
-#define	VPH32_16BITVPHENTRIES(arch,ARCH)				\
-	unsigned char		*host_load[N_VPH32_ENTRIES];		\
-	unsigned char		*host_store[N_VPH32_ENTRIES];		\
-	uint32_t		phys_addr[N_VPH32_ENTRIES];		\
-	struct arch ## _tc_physpage  *phys_page[N_VPH32_ENTRIES];	\
-	uint16_t		vaddr_to_tlbindex[N_VPH32_ENTRIES];
+	struct arch ## _l2_32_table	*l2_32_dummy;			\
+	struct arch ## _l2_32_table	*next_free_l2_32;		\
+	struct arch ## _l2_32_table	*l1_32[1 << DYNTRANS_L1N_32];
 #define	VPH32EXTENDED(arch,ARCH,ex)					\
-	unsigned char		*host_load_ ## ex[N_VPH32_ENTRIES];	\
-	unsigned char		*host_store_ ## ex[N_VPH32_ENTRIES];	\
-	uint32_t		phys_addr_ ## ex[N_VPH32_ENTRIES];	\
-	struct arch ## _tc_physpage  *phys_page_ ## ex[N_VPH32_ENTRIES];\
-	uint8_t			vaddr_to_tlbindex_ ## ex[N_VPH32_ENTRIES];
+	struct arch ## _l2_32_table	*l1_32_ ## ex[1 << DYNTRANS_L1N_32];
+
+#define	VPH32_L2_TABLE(l1,pagenr)	((l1)[(pagenr) >> DYNTRANS_L2N_32])
+#define	VPH32_L2_INDEX(pagenr)		((pagenr) & ((1<<DYNTRANS_L2N_32)-1))
+#define	VPH32_HOST_LOAD(l1,pagenr)					\
+	(VPH32_L2_TABLE(l1,pagenr)->host_load[VPH32_L2_INDEX(pagenr)])
+#define	VPH32_HOST_STORE(l1,pagenr)					\
+	(VPH32_L2_TABLE(l1,pagenr)->host_store[VPH32_L2_INDEX(pagenr)])
+#define	VPH32_PHYS_ADDR(l1,pagenr)					\
+	(VPH32_L2_TABLE(l1,pagenr)->phys_addr[VPH32_L2_INDEX(pagenr)])
+#define	VPH32_PHYS_PAGE(l1,pagenr)					\
+	(VPH32_L2_TABLE(l1,pagenr)->phys_page[VPH32_L2_INDEX(pagenr)])
 
 
 /*
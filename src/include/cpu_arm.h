@@ -122,6 +122,7 @@ struct arm_cpu_type_def {
 #define	ARM_EXCEPTION_FIQ	7
 
 DYNTRANS_MISC_DECLARATIONS(arm,ARM,uint32_t)
+DYNTRANS_MISC32_DECLARATIONS(arm,ARM,uint16_t)
 
 #define	ARM_MAX_VPH_TLB_ENTRIES		384
 
@@ -233,7 +234,7 @@ struct arm_cpu {
 	 */
 	DYNTRANS_ITC(arm)
 	VPH_TLBS(arm,ARM)
-	VPH32_16BITVPHENTRIES(arm,ARM)
+	VPH32(arm,ARM)
 
 	/*  ARM specific: */
 	uint32_t			is_userpage[N_VPH32_ENTRIES/32];
@@ -162,6 +162,7 @@ struct m88k_cpu_type_def {
 					+ M88K_INSTR_ALIGNMENT_SHIFT))
 
 DYNTRANS_MISC_DECLARATIONS(m88k,M88K,uint32_t)
+DYNTRANS_MISC32_DECLARATIONS(m88k,M88K,uint8_t)
 
 #define	M88K_MAX_VPH_TLB_ENTRIES		128
 
@@ -92,6 +92,12 @@ struct mips_tlb {
 #define	MIPS_FPU_FCIR			0
 #define	MIPS_FPU_FCCR			25
 #define	MIPS_FPU_FCSR			31
+#define	   MIPS_FCSR_RM_MASK		   0x3	/*  IEEE_ROUND_*  */
+#define	   MIPS_FCSR_FLAGS_SHIFT	   2	/*  IEEE_FLAG_*  */
+#define	   MIPS_FCSR_ENABLES_SHIFT	   7	/*  IEEE_FLAG_*  */
+#define	   MIPS_FCSR_CAUSE_SHIFT	   12
+#define	   MIPS_FCSR_CAUSE_MASK		   0x0003f000
+#define	   MIPS_FCSR_CAUSE_UNIMPLEMENTED   0x00020000
 #define	   MIPS_FCSR_FCC0_SHIFT		   23
 #define	   MIPS_FCSR_FCC1_SHIFT		   25
 
@@ -199,6 +205,7 @@ struct r3000_cache_line {
 #define	MIPS_MAX_VPH_TLB_ENTRIES	192
 
 DYNTRANS_MISC_DECLARATIONS(mips,MIPS,uint64_t)
+DYNTRANS_MISC32_DECLARATIONS(mips,MIPS,uint8_t)
 DYNTRANS_MISC64_DECLARATIONS(mips,MIPS,uint8_t)
 
 
@@ -102,6 +102,7 @@ struct ppc_cpu_type_def {
 #define	PPC_L3N			18
 
 DYNTRANS_MISC_DECLARATIONS(ppc,PPC,uint64_t)
+DYNTRANS_MISC32_DECLARATIONS(ppc,PPC,uint8_t)
 DYNTRANS_MISC64_DECLARATIONS(ppc,PPC,uint8_t)
 
 #define	PPC_MAX_VPH_TLB_ENTRIES		128
@@ -77,6 +77,7 @@ struct sh_cpu_type_def {
 					+ SH_INSTR_ALIGNMENT_SHIFT))
 
 DYNTRANS_MISC_DECLARATIONS(sh,SH,uint32_t)
+DYNTRANS_MISC32_DECLARATIONS(sh,SH,uint8_t)
 
 #define	SH_MAX_VPH_TLB_ENTRIES		128
 
@@ -45,8 +45,52 @@ struct ieee_float_value {
 #define	IEEE_FMT_W		3	/*  word, 32-bit integer  */
 #define	IEEE_FMT_L		4	/*  long, 64-bit integer  */
 
+/*  Rounding modes (same encoding as MIPS FCSR RM and PowerPC FPSCR RN):  */
+#define	IEEE_ROUND_NEAREST	0
+#define	IEEE_ROUND_ZERO		1
+#define	IEEE_ROUND_UP		2	/*  towards +infinity  */
+#define	IEEE_ROUND_DOWN		3	/*  towards -infinity  */
+#define	IEEE_ROUND_MASK		3
+
+/*
+ *  May be ORed into the rounding mode argument of the bit-exact functions
+ *  below, to use the legacy MIPS encoding of NaNs (where the most significant
+ *  fraction bit is clear in quiet NaNs) instead of the IEEE 754-2008 one.
+ */
+#define	IEEE_LEGACY_NANS	4
+
+/*  Exception flags (in the same order as in the MIPS FCSR):  */
+#define	IEEE_FLAG_INEXACT	0x01
+#define	IEEE_FLAG_UNDERFLOW	0x02
+#define	IEEE_FLAG_OVERFLOW	0x04
+#define	IEEE_FLAG_DIVBYZERO	0x08
+#define	IEEE_FLAG_INVALID	0x10
+
+/*  Results from ieee_compare():  */
+#define	IEEE_CMP_LESS		0
+#define	IEEE_CMP_EQUAL		1
+#define	IEEE_CMP_GREATER	2
+#define	IEEE_CMP_UNORDERED	3
+
+void ieee_set_rounding_mode(int mode);
 void ieee_interpret_float_value(uint64_t x, struct ieee_float_value *fvp,
 	int fmt);
 uint64_t ieee_store_float_value(double nf, int fmt, int nan);
 
+/*  Bit-exact software arithmetic, with exception flags:  */
+uint64_t ieee_add(uint64_t a, uint64_t b, int fmt, int rm, int *flagsp);
+uint64_t ieee_sub(uint64_t a, uint64_t b, int fmt, int rm, int *flagsp);
+uint64_t ieee_mul(uint64_t a, uint64_t b, int fmt, int rm, int *flagsp);
+uint64_t ieee_div(uint64_t a, uint64_t b, int fmt, int rm, int *flagsp);
+uint64_t ieee_sqrt(uint64_t a, int fmt, int rm, int *flagsp);
+uint64_t ieee_convert(uint64_t a, int from_fmt, int to_fmt, int rm,
+	int *flagsp);
+int ieee_compare(uint64_t a, uint64_t b, int fmt, int signaling, int rm,
+	int *flagsp);
+
+/*  Unit tests (in float_emul.cc):  */
+struct float_emul {
+	static void RunUnitTests(int& nSucceeded, int& nFailures);
+};
+
 #endif	/*  FLOAT_EMUL_H  */
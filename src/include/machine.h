@@ -144,6 +144,11 @@ struct machine {
 	struct symbol_context symbol_context;
 
 	int	random_mem_contents;
+	int	contiguous_ram;
+	int	merge_identical_pages;
+	int	exact_fpu;		/*  bit-exact software FPU  */
+	char	*memory_filename;	/*  file backing the RAM, or NULL  */
+	int	memory_file_private;
 	int	physical_ram_in_mb;
 	int	memory_offset_in_mb;
 	int	prom_emulation;
@@ -375,6 +380,7 @@ void machine_destroy(struct machine *machine);
 int machine_name_to_type(char *stype, char *ssubtype,
 	int *type, int *subtype, int *arch);
 void machine_add_breakpoint_string(struct machine *machine, char *str);
+void machine_set_memory_string(struct machine *machine, const char *str);
 void machine_add_tickfunction(struct machine *machine,
 	void (*func)(struct cpu *, void *), void *extra, int clockshift);
 void machine_statistics_init(struct machine *, char *fname);
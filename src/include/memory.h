@@ -76,6 +76,29 @@ struct memory {
 	uint64_t	physical_max;
 	void		*pagetable;
 
+	/*  Optional single host mapping of all physical RAM:  */
+	unsigned char	*contiguous_base;
+	uint64_t	contiguous_size;
+
+	/*  Let the host merge identical pages (see memory_new()):  */
+	int		merge_identical_pages;
+
+	/*  Dirty page tracking; one bitmap per client (NULL if released):  */
+	int		n_dirty_clients;
+	int		n_dirty_bitmaps;
+	uint64_t	**dirty_bitmaps;
+
+	/*  Page hash tree for memory_checksum(), and saved checkpoints.
+	    hash_tree_client is -1 when the tree is not kept up to date.
+	    It is kept while hash_tree_tracking is set, or while there are
+	    checkpoints. n_pages_hashed counts rehashed pages.  */
+	uint64_t	*hash_tree;
+	int		hash_tree_client;
+	int		hash_tree_tracking;
+	uint64_t	n_pages_hashed;
+	int		n_checkpoints;
+	uint64_t	**checkpoints;
+
 	int		dev_dyntrans_alignment;
 
 	int		n_mmapped_devices;
@@ -86,8 +109,47 @@ struct memory {
 	uint64_t	mmap_dev_maxaddr;
 
 	struct memory_device *devices;
+
+	/*  Physical page to device index lookup table. (See below.)  */
+	size_t		*devmap;
+
+	/*  Unit tests (in memory.cc):  */
+	static void RunUnitTests(int& nSucceeded, int& nFailures);
 };
 
+/*
+ *  The device map is a radix tree with DEVMAP_LEVELS levels, indexed by
+ *  the physical page number. Each entry is either NULL (no device), a
+ *  pointer to a table at the next level, or a value (with DEVMAP_VALUE
+ *  set) describing the device(s) on that page. Values may be placed at
+ *  any level, if an entire slot is covered by one single device.
+ *
+ *  Pages which are only partially covered by devices are marked with
+ *  DEVMAP_PARTIAL; such pages must not be entered into the dyntrans
+ *  translation tables. If more than one device share a page, the page is
+ *  marked DEVMAP_MULTIPLE, and the device array has to be searched.
+ */
+#define	DEVMAP_PAGE_SHIFT	12
+#define	DEVMAP_BITS_PER_LEVEL	13
+#define	DEVMAP_LEVELS		4
+#define	DEVMAP_VALUE		1
+#define	DEVMAP_PARTIAL		2
+#define	DEVMAP_MULTIPLE		4
+#define	DEVMAP_INDEX_SHIFT	3	/*  device index + 1  */
+
+/*
+ *  Dirty page tracking: When there is at least one client, every physical
+ *  RAM page which is written to is marked as dirty in all clients' bitmaps.
+ *  Pages are then only entered into the dyntrans translation tables as
+ *  writable when they are actually written to, and are downgraded to
+ *  read-only again when a client clears their dirty bit.
+ */
+#define	DIRTY_PAGE_SHIFT	12
+#define	MEMORY_MARK_DIRTY(mem,paddr)	{				\
+		if ((mem)->n_dirty_clients > 0)				\
+			memory_dirty_mark(mem, paddr);			\
+	}
+
 #define	BITS_PER_PAGETABLE	20
 #define	BITS_PER_MEMBLOCK	20
 #define	MAX_BITS		40
@@ -102,6 +164,9 @@ void memory_writemax64(struct cpu *cpu, unsigned char *buf, int len,
 void *zeroed_alloc(size_t s);
 
 struct memory *memory_new(uint64_t physical_max, int arch);
+void memory_reserve_contiguous(struct memory *mem);
+void memory_map_file(struct memory *mem, const char *filename,
+	int private_mapping);
 
 int memory_points_to_string(struct cpu *cpu, struct memory *mem,
 	uint64_t addr, int min_string_length);
@@ -158,7 +223,40 @@ void memory_device_register(struct memory *mem, const char *,
 	void *extra, int flags, unsigned char *dyntrans_data);
 void memory_device_remove(struct memory *mem, int i);
 
-uint64_t memory_checksum(struct memory *mem);
+/*
+ *  DMA: A physical address range is resolved into segments, each being
+ *  either a host pointer into emulated RAM, or NULL for anything which
+ *  needs to go via memory_rw (devices, or outside of RAM).
+ */
+struct memory_dma_segment {
+	unsigned char	*host;
+	uint64_t	paddr;
+	size_t		len;
+};
+
+#define	MEMORY_DMA_MAX_SEGMENTS		16
+
+int memory_dma_map(struct cpu *cpu, struct memory *mem, uint64_t paddr,
+	size_t len, int writeflag, struct memory_dma_segment *segs,
+	int max_segs);
+int memory_dma_is_ram(struct memory *mem, uint64_t paddr, uint64_t len,
+	int writeflag);
+void memory_dma_copy(struct cpu *cpu, struct memory *mem, uint64_t paddr,
+	unsigned char *data, size_t len, int writeflag);
+int memory_rw_bulk(struct cpu *cpu, struct memory *mem, uint64_t vaddr,
+	unsigned char *data, size_t len, int writeflag, int misc_flags);
+
+int memory_dirty_client_new(struct memory *mem);
+void memory_dirty_client_free(struct memory *mem, int client);
+void memory_dirty_mark(struct memory *mem, uint64_t paddr);
+int memory_dirty_fetch_and_clear(struct cpu *cpu, struct memory *mem,
+	int client, uint64_t *paddrp, uint64_t *lenp);
+
+uint64_t memory_checksum(struct cpu *cpu, struct memory *mem);
+void memory_checksum_tracking(struct cpu *cpu, struct memory *mem, int on);
+int memory_checkpoint(struct cpu *cpu, struct memory *mem);
+void memory_checkpoints_clear(struct memory *mem);
+void memory_checkpoint_diff(struct cpu *cpu, struct memory *mem, int a, int b);
 
 void dump_mem_string(struct cpu *cpu, uint64_t addr);
 void store_string(struct cpu *cpu, uint64_t addr, const char *s);
@@ -6,7 +6,8 @@
 #define	quick_pc_to_pointers(cpu) {					\
 	uint32_t pc_tmp32 = cpu->pc;					\
 	struct DYNTRANS_TC_PHYSPAGE *ppp_tmp;				\
-	ppp_tmp = cpu->cd.DYNTRANS_ARCH.phys_page[pc_tmp32 >> 12];	\
+	ppp_tmp = VPH32_PHYS_PAGE(cpu->cd.DYNTRANS_ARCH.l1_32,		\
+	    pc_tmp32 >> 12);						\
 	if (ppp_tmp != NULL) {						\
 		cpu->cd.DYNTRANS_ARCH.cur_ic_page = &ppp_tmp->ics[0];	\
 		cpu->cd.DYNTRANS_ARCH.next_ic =				\
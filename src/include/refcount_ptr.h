@@ -81,6 +81,19 @@ public:
 		}
 	}
 
+	/**
+	 * \brief Gets the current reference count of the object.
+	 *
+	 * Useful for copy-on-write schemes: an object with a reference
+	 * count of 1 is only referenced by the caller.
+	 *
+	 * @return The number of references to the object.
+	 */
+	int GetRefCount() const
+	{
+		return m_refCount;
+	}
+
 private:
 	template<class T> friend class refcount_ptr;
 
@@ -135,4 +135,9 @@
 #define	CHCR_TE		0x00000002	/*  Transfer End  */
 #define	CHCR_TD		0x00000001	/*  DMAC Enable  */
 
+/*  Unit tests (in dev_sh4.cc):  */
+struct sh4_dmacreg {
+	static void RunUnitTests(int& nSucceeded, int& nFailures);
+};
+
 #endif	/*  SH4_DMACREG_H  */
@@ -101,6 +101,12 @@
 #define	SH_INTEVT_IRL11		0x360
 #define	SH_INTEVT_IRL13		0x3a0
 
+#define	SH4_INTEVT_DMAC_DMTE0	0x640
+#define	SH4_INTEVT_DMAC_DMTE1	0x660
+#define	SH4_INTEVT_DMAC_DMTE2	0x680
+#define	SH4_INTEVT_DMAC_DMTE3	0x6a0
+#define	SH4_INTEVT_DMAC_DMAE	0x6c0
+
 #define	SH4_INTEVT_SCIF_ERI	0x700
 #define	SH4_INTEVT_SCIF_RXI	0x720
 #define	SH4_INTEVT_SCIF_BRI	0x740
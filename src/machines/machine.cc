@@ -265,6 +265,42 @@ void machine_add_breakpoint_string(struct machine *machine, char *str)
 }
 
 
+/*
+ *  machine_set_memory_string():
+ *
+ *  Set the amount of RAM from a string such as "128". The string may also
+ *  be on the form "128@filename", in which case the RAM is backed by a
+ *  shared mapping of the given host file (changes to the RAM are written to
+ *  the file), or "128@@filename", which uses a private copy-on-write
+ *  mapping of the file instead (the file is not modified).
+ */
+void machine_set_memory_string(struct machine *machine, const char *str)
+{
+	const char *p = strchr(str, '@');
+
+	machine->physical_ram_in_mb = atoi(str);
+
+	if (p == NULL)
+		return;
+
+	p ++;
+	machine->memory_file_private = 0;
+	if (*p == '@') {
+		machine->memory_file_private = 1;
+		p ++;
+	}
+
+	if (*p == '\0') {
+		fatal("No filename given after '@' in the memory size.\n");
+		exit(1);
+	}
+
+	if (machine->memory_filename != NULL)
+		free(machine->memory_filename);
+	CHECK_ALLOCATION(machine->memory_filename = strdup(p));
+}
+
+
 /*
  *  machine_add_tickfunction():
  *
@@ -403,6 +439,9 @@ void machine_dumpinfo(struct machine *m)
 		debug(" (offset by %i MB)", m->memory_offset_in_mb);
 	if (m->random_mem_contents)
 		debug(", randomized contents");
+	if (m->memory_filename != NULL)
+		debug(", %s mapping of '%s'", m->memory_file_private?
+		    "private" : "shared", m->memory_filename);
 	debug("\n");
 
 	if (!m->prom_emulation)
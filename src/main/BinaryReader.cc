@@ -0,0 +1,258 @@
+/*
+ *  Copyright (C) 2014  Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright  
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE   
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "BinaryReader.h"
+
+
+static uint64_t ExtractInteger(const string& str, size_t pos, int nBytes)
+{
+	uint64_t value = 0;
+
+	for (int i=nBytes-1; i>=0; --i)
+		value = (value << 8) | (uint8_t) str[pos + i];
+
+	return value;
+}
+
+
+static bool ReadAt(int fd, void* data, size_t len, uint64_t offset)
+{
+	char* p = (char*) data;
+
+	while (len > 0) {
+		ssize_t n = pread(fd, p, len, offset);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+
+		p += n;
+		len -= n;
+		offset += n;
+	}
+
+	return true;
+}
+
+
+BinaryReader::BinaryReader()
+	: m_fd(-1)
+	, m_pos(0)
+{
+}
+
+
+BinaryReader::~BinaryReader()
+{
+	if (m_fd >= 0)
+		close(m_fd);
+}
+
+
+bool BinaryReader::Open(const string& filename, ostream& messages)
+{
+	m_fd = open(filename.c_str(), O_RDONLY);
+	if (m_fd < 0) {
+		messages << "Unable to open " << filename << " for reading.\n";
+		return false;
+	}
+
+	struct stat st;
+	char buf[24];
+	if (fstat(m_fd, &st) != 0 || !ReadAt(m_fd, buf, sizeof(buf), 0) ||
+	    memcmp(buf, BINARY_FILE_MAGIC, 8) != 0) {
+		messages << filename << " is not a binary emulation file.\n";
+		return false;
+	}
+
+	string header(buf, sizeof(buf));
+	uint64_t version = ExtractInteger(header, 8, 4);
+	uint64_t nSections = ExtractInteger(header, 12, 4);
+	uint64_t treeLength = ExtractInteger(header, 16, 8);
+
+	if (version != BINARY_FILE_VERSION) {
+		messages << filename << " has unsupported version " <<
+		    version << ".\n";
+		return false;
+	}
+
+	uint64_t fileSize = st.st_size;
+	if (treeLength > fileSize - sizeof(buf) ||
+	    nSections * 16 > fileSize - sizeof(buf) - treeLength) {
+		messages << filename << " is truncated.\n";
+		return false;
+	}
+
+	m_tree.resize(treeLength + nSections * 16);
+	if (m_tree.length() > 0 && !ReadAt(m_fd, &m_tree[0], m_tree.length(),
+	    sizeof(buf))) {
+		messages << "Could not read " << filename << ".\n";
+		return false;
+	}
+
+	for (size_t i=0; i<nSections; ++i) {
+		uint64_t offset = ExtractInteger(m_tree, treeLength + i*16, 8);
+		uint64_t len = ExtractInteger(m_tree, treeLength + i*16 + 8, 8);
+
+		if (offset > fileSize || len > fileSize - offset) {
+			messages << filename << " is truncated.\n";
+			return false;
+		}
+
+		m_sectionOffsets.push_back(offset);
+		m_sectionLengths.push_back(len);
+	}
+
+	m_tree.resize(treeLength);
+	m_pos = 0;
+
+	return true;
+}
+
+
+bool BinaryReader::ReadUInt8(uint8_t& value)
+{
+	if (m_pos + sizeof(value) > m_tree.length())
+		return false;
+
+	value = ExtractInteger(m_tree, m_pos, sizeof(value));
+	m_pos += sizeof(value);
+	return true;
+}
+
+
+bool BinaryReader::ReadUInt64(uint64_t& value)
+{
+	if (m_pos + sizeof(value) > m_tree.length())
+		return false;
+
+	value = ExtractInteger(m_tree, m_pos, sizeof(value));
+	m_pos += sizeof(value);
+	return true;
+}
+
+
+bool BinaryReader::ReadDouble(double& value)
+{
+	uint64_t bits;
+	if (!ReadUInt64(bits))
+		return false;
+
+	memcpy(&value, &bits, sizeof(value));
+	return true;
+}
+
+
+bool BinaryReader::ReadString(string& str)
+{
+	uint64_t len;
+	if (!ReadUInt64(len) || len > m_tree.length() - m_pos)
+		return false;
+
+	str = m_tree.substr(m_pos, len);
+	m_pos += len;
+	return true;
+}
+
+
+bool BinaryReader::Skip(uint64_t len)
+{
+	if (len > m_tree.length() - m_pos)
+		return false;
+
+	m_pos += len;
+	return true;
+}
+
+
+uint64_t BinaryReader::BytesLeft() const
+{
+	return m_tree.length() - m_pos;
+}
+
+
+bool BinaryReader::GetSectionLength(uint64_t index, uint64_t& len) const
+{
+	if (index >= m_sectionLengths.size())
+		return false;
+
+	len = m_sectionLengths[index];
+	return true;
+}
+
+
+void* BinaryReader::MapSection(uint64_t index, size_t len) const
+{
+	if (index >= m_sectionLengths.size() || m_fd < 0)
+		return NULL;
+
+	uint64_t offset = m_sectionOffsets[index];
+	uint64_t sectionLength = m_sectionLengths[index];
+
+	// The common case: map the data directly from the file.
+	if (len <= sectionLength) {
+		void* p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+		    m_fd, offset);
+		return p == MAP_FAILED? NULL : p;
+	}
+
+	// Otherwise, read the section into zero-filled anonymous memory.
+	void* p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+	    MAP_ANON | MAP_PRIVATE, -1, 0);
+	if (p == MAP_FAILED)
+		return NULL;
+
+	if (!ReadAt(m_fd, p, sectionLength, offset)) {
+		munmap(p, len);
+		return NULL;
+	}
+
+	return p;
+}
+
+
+bool BinaryReader::IsBinaryFile(const string& filename)
+{
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	char buf[8];
+	bool isBinary = ReadAt(fd, buf, sizeof(buf), 0) &&
+	    memcmp(buf, BINARY_FILE_MAGIC, sizeof(buf)) == 0;
+
+	close(fd);
+
+	return isBinary;
+}
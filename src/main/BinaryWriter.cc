@@ -0,0 +1,347 @@
+/*
+ *  Copyright (C) 2014  Anders Gavare.  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright  
+ *     notice, this list of conditions and the following disclaimer in the 
+ *     documentation and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE   
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ *  OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ *  OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ *  SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "BinaryReader.h"
+#include "BinaryWriter.h"
+
+
+// Aligned pages of this size which are all zeroes are not written to files.
+#define	BINARY_HOLE_SIZE	4096
+
+
+static void AppendInteger(string& str, uint64_t value, int nBytes)
+{
+	for (int i=0; i<nBytes; ++i)
+		str += (char) (value >> (i*8));
+}
+
+
+static uint64_t AlignSectionOffset(uint64_t offset)
+{
+	return (offset + BINARY_SECTION_ALIGNMENT - 1) &
+	    ~(uint64_t)(BINARY_SECTION_ALIGNMENT - 1);
+}
+
+
+static bool WriteAt(int fd, const void* data, size_t len, uint64_t offset)
+{
+	const char* p = (const char*) data;
+
+	while (len > 0) {
+		ssize_t n = pwrite(fd, p, len, offset);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+
+		p += n;
+		len -= n;
+		offset += n;
+	}
+
+	return true;
+}
+
+
+static bool IsZeroPage(const uint8_t* data, size_t len)
+{
+	for (size_t i=0; i<len; ++i)
+		if (data[i] != 0)
+			return false;
+
+	return true;
+}
+
+
+BinaryWriter::BinaryWriter()
+{
+}
+
+
+void BinaryWriter::WriteUInt8(uint8_t value)
+{
+	AppendInteger(m_tree, value, sizeof(value));
+}
+
+
+void BinaryWriter::WriteUInt64(uint64_t value)
+{
+	AppendInteger(m_tree, value, sizeof(value));
+}
+
+
+void BinaryWriter::WriteDouble(double value)
+{
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	AppendInteger(m_tree, bits, sizeof(bits));
+}
+
+
+void BinaryWriter::WriteString(const string& str)
+{
+	WriteUInt64(str.length());
+	m_tree += str;
+}
+
+
+size_t BinaryWriter::BeginLengthPrefixed()
+{
+	WriteUInt64(0);
+	return m_tree.length();
+}
+
+
+void BinaryWriter::EndLengthPrefixed(size_t start)
+{
+	string len;
+	AppendInteger(len, m_tree.length() - start, 8);
+	m_tree.replace(start - len.length(), len.length(), len);
+}
+
+
+uint64_t BinaryWriter::AddSection(const void* data, size_t len)
+{
+	Section section;
+	section.data = data;
+	section.len = len;
+	m_sections.push_back(section);
+
+	return m_sections.size() - 1;
+}
+
+
+bool BinaryWriter::Finish(const string& filename)
+{
+	string header = BINARY_FILE_MAGIC;
+	AppendInteger(header, BINARY_FILE_VERSION, 4);
+	AppendInteger(header, m_sections.size(), 4);
+	AppendInteger(header, m_tree.length(), 8);
+	header += m_tree;
+
+	// Place the sections after the header, tree, and section table.
+	vector<uint64_t> offsets;
+	uint64_t offset = header.length() + m_sections.size() * 16;
+	for (size_t i=0; i<m_sections.size(); ++i) {
+		offset = AlignSectionOffset(offset);
+		offsets.push_back(offset);
+		AppendInteger(header, offset, 8);
+		AppendInteger(header, m_sections[i].len, 8);
+		offset += m_sections[i].len;
+	}
+
+	// Write to a temporary file, which then replaces the old file. This
+	// way, an emulation which was loaded from the old file (and still has
+	// sections of it mapped) is not affected.
+	string tmpFilename = filename + ".tmp";
+	int fd = open(tmpFilename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (fd < 0)
+		return false;
+
+	bool success = WriteAt(fd, header.c_str(), header.length(), 0);
+
+	for (size_t i=0; success && i<m_sections.size(); ++i) {
+		const uint8_t* data = (const uint8_t*) m_sections[i].data;
+		size_t len = m_sections[i].len;
+
+		for (size_t p=0; success && p<len; p+=BINARY_HOLE_SIZE) {
+			size_t chunk = len - p;
+			if (chunk > BINARY_HOLE_SIZE)
+				chunk = BINARY_HOLE_SIZE;
+
+			if (!IsZeroPage(data + p, chunk))
+				success = WriteAt(fd, data + p, chunk,
+				    offsets[i] + p);
+		}
+	}
+
+	// Skipped zero pages at the end of the file must still be part of
+	// the file, so that sections can be mapped.
+	if (success && ftruncate(fd, offset) != 0)
+		success = false;
+
+	if (close(fd) != 0)
+		success = false;
+
+	if (success && rename(tmpFilename.c_str(), filename.c_str()) != 0)
+		success = false;
+
+	if (!success)
+		unlink(tmpFilename.c_str());
+
+	return success;
+}
+
+
+/*****************************************************************************/
+
+
+#ifdef WITHUNITTESTS
+
+static void Test_BinaryWriter_WriteAndRead()
+{
+	char filename[] = "/tmp/gxemul_binarytest_XXXXXX";
+	int fd = mkstemp(filename);
+	UnitTest::Assert("could not create temporary file", fd >= 0);
+	close(fd);
+
+	vector<uint8_t> section(3 * BINARY_HOLE_SIZE);
+	section[1] = 0x12;
+	section[section.size() - 1] = 0x34;
+
+	BinaryWriter writer;
+	writer.WriteUInt8(42);
+	writer.WriteString("hello");
+	writer.WriteDouble(1.5);
+	uint64_t sectionIndex = writer.AddSection(&section[0], section.size());
+	writer.WriteUInt64(0x123456789abcdefULL);
+	UnitTest::Assert("writing failed", writer.Finish(filename));
+
+	UnitTest::Assert("should be a binary file",
+	    BinaryReader::IsBinaryFile(filename));
+
+	BinaryReader reader;
+	stringstream messages;
+	UnitTest::Assert("opening failed", reader.Open(filename, messages));
+
+	uint8_t value8;
+	string str;
+	double d;
+	uint64_t value64;
+	UnitTest::Assert("uint8", reader.ReadUInt8(value8) && value8 == 42);
+	UnitTest::Assert("string", reader.ReadString(str) && str == "hello");
+	UnitTest::Assert("double", reader.ReadDouble(d) && d == 1.5);
+	UnitTest::Assert("uint64", reader.ReadUInt64(value64) &&
+	    value64 == 0x123456789abcdefULL);
+	UnitTest::Assert("end of tree", !reader.ReadUInt8(value8));
+
+	uint64_t len;
+	UnitTest::Assert("section length", reader.GetSectionLength(
+	    sectionIndex, len) && len == section.size());
+
+	// Map exactly the section, and also a larger zero-filled area.
+	uint8_t* p = (uint8_t*) reader.MapSection(sectionIndex, len);
+	UnitTest::Assert("mapping failed", p != NULL);
+	UnitTest::Assert("mapped contents", p[1] == 0x12 &&
+	    p[len - 1] == 0x34 && p[BINARY_HOLE_SIZE] == 0);
+	munmap(p, len);
+
+	p = (uint8_t*) reader.MapSection(sectionIndex, 2 * len);
+	UnitTest::Assert("larger mapping failed", p != NULL);
+	UnitTest::Assert("larger mapping contents", p[1] == 0x12 &&
+	    p[len - 1] == 0x34 && p[len] == 0);
+	munmap(p, 2 * len);
+
+	unlink(filename);
+}
+
+static void Test_BinaryWriter_LengthPrefixed()
+{
+	char filename[] = "/tmp/gxemul_binarytest_XXXXXX";
+	int fd = mkstemp(filename);
+	UnitTest::Assert("could not create temporary file", fd >= 0);
+	close(fd);
+
+	BinaryWriter writer;
+	size_t start = writer.BeginLengthPrefixed();
+	writer.WriteString("skipped");
+	writer.WriteUInt8(1);
+	writer.EndLengthPrefixed(start);
+	writer.WriteUInt8(2);
+	UnitTest::Assert("writing failed", writer.Finish(filename));
+
+	BinaryReader reader;
+	stringstream messages;
+	UnitTest::Assert("opening failed", reader.Open(filename, messages));
+	unlink(filename);
+
+	uint64_t len;
+	uint8_t value8;
+	UnitTest::Assert("length", reader.ReadUInt64(len) && len == 8+7+1);
+	UnitTest::Assert("skip", reader.Skip(len));
+	UnitTest::Assert("value after skipped data",
+	    reader.ReadUInt8(value8) && value8 == 2);
+	UnitTest::Assert("nothing left", reader.BytesLeft(), 0);
+	UnitTest::Assert("skipping past the end", !reader.Skip(1));
+}
+
+static void Test_BinaryWriter_BadHeader()
+{
+	char filename[] = "/tmp/gxemul_binarytest_XXXXXX";
+	int fd = mkstemp(filename);
+	UnitTest::Assert("could not create temporary file", fd >= 0);
+	close(fd);
+
+	BinaryWriter writer;
+	writer.WriteUInt64(0);
+	UnitTest::Assert("writing failed", writer.Finish(filename));
+
+	// A tree length which wraps around when the section table is added.
+	uint8_t treeLength[8] =
+	    { 0xf8, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+	uint8_t nSections[4] = { 1, 0, 0, 0 };
+	fd = open(filename, O_WRONLY);
+	UnitTest::Assert("could not reopen temporary file", fd >= 0 &&
+	    WriteAt(fd, nSections, sizeof(nSections), 12) &&
+	    WriteAt(fd, treeLength, sizeof(treeLength), 16));
+	close(fd);
+
+	BinaryReader reader;
+	stringstream messages;
+	UnitTest::Assert("opening should fail",
+	    !reader.Open(filename, messages));
+	unlink(filename);
+}
+
+static void Test_BinaryWriter_NotBinary()
+{
+	UnitTest::Assert("an ELF file is not a binary emulation file",
+	    !BinaryReader::IsBinaryFile("test/FileLoader_ELF_MIPS"));
+
+	BinaryReader reader;
+	stringstream messages;
+	UnitTest::Assert("opening should fail",
+	    !reader.Open("test/FileLoader_ELF_MIPS", messages));
+}
+
+UNITTESTS(BinaryWriter)
+{
+	UNITTEST(Test_BinaryWriter_WriteAndRead);
+	UNITTEST(Test_BinaryWriter_LengthPrefixed);
+	UNITTEST(Test_BinaryWriter_BadHeader);
+	UNITTEST(Test_BinaryWriter_NotBinary);
+}
+
+#endif
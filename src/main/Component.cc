@@ -32,6 +32,8 @@
 #include <fstream>
 
 #include "components/RootComponent.h"
+#include "BinaryReader.h"
+#include "BinaryWriter.h"
 #include "Component.h"
 #include "ComponentFactory.h"
 #include "EscapedString.h"
@@ -278,6 +280,38 @@ void Component::DetectChanges(const refcount_ptr<Component>& oldClone,
 }
 
 
+void Component::MarkUnchanged()
+{
+	StateVariableMap::iterator varIt = m_stateVariables.begin();
+	for ( ; varIt != m_stateVariables.end(); ++varIt)
+		varIt->second.MarkUnchanged();
+
+	for (size_t i = 0; i < m_childComponents.size(); ++ i)
+		m_childComponents[i]->MarkUnchanged();
+}
+
+
+void Component::DetectChanges(ostream& changeMessages) const
+{
+	StateVariableMap::const_iterator varIt = m_stateVariables.begin();
+	for ( ; varIt != m_stateVariables.end(); ++varIt) {
+		const string& varName = varIt->first;
+		const StateVariable& variable = varIt->second;
+
+		// See the clone-based DetectChanges about "step".
+		if (varName == "step" || !variable.HasChanged())
+			continue;
+
+		changeMessages << "=> " << GenerateShortestPossiblePath() << "."
+		    << varName << ": " << variable.UnchangedValueToString()
+		    << " -> " << variable.ToString() << "\n";
+	}
+
+	for (size_t i = 0; i < m_childComponents.size(); ++ i)
+		m_childComponents[i]->DetectChanges(changeMessages);
+}
+
+
 void Component::Reset()
 {
 	ResetState();
@@ -609,6 +643,10 @@ void Component::AddChild(refcount_ptr<Component> childComponent,
 
 	childComponent->SetParent(this);
 
+	GXemul* gxemul = GetRunningGXemulInstance();
+	if (gxemul != NULL)
+		gxemul->InvalidateExecutableComponents();
+
 	// Make sure that the child's "name" state variable is unique among
 	// all children of this component. (Yes, this is O(n^2) and it may
 	// need to be rewritten to cope with _lots_ of components.)
@@ -660,6 +698,11 @@ size_t Component::RemoveChild(Component* childToRemove)
 		if (childToRemove == (*it)) {
 			childToRemove->SetParent(NULL);
 			m_childComponents.erase(it);
+
+			GXemul* gxemul = GetRunningGXemulInstance();
+			if (gxemul != NULL)
+				gxemul->InvalidateExecutableComponents();
+
 			return index;
 		}
 	}
@@ -974,6 +1017,11 @@ bool Component::CheckVariableWrite(StateVariable& var, const string& oldValue)
 	if (gxemul != NULL) {
 		const string& name = var.GetName();
 
+		// Pausing or unpausing a component changes which components
+		// are executable.
+		if (name == "paused")
+			gxemul->InvalidateExecutableComponents();
+
 		if (name == "step") {
 			// If we are the root component, then writing to step
 			// has special meaning:
@@ -1160,6 +1208,8 @@ refcount_ptr<Component> Component::Deserialize(ostream& messages, const string&
 		}
 	}
 
+	vector< pair<string,string> > customVariables;
+
 	while (pos < str.length()) {
 		size_t savedPos = pos;
 
@@ -1210,6 +1260,14 @@ refcount_ptr<Component> Component::Deserialize(ostream& messages, const string&
 				break;
 			}
 
+			// Custom variables (e.g. RAM contents) may be checked
+			// against ordinary variables, so they are set last.
+			if (varType == "custom") {
+				customVariables.push_back(
+				    pair<string,string>(name, varValue));
+				continue;
+			}
+
 			if (!deserializedTree->SetVariableValue(name,
 			    varValue)) {
 				messages << "Warning: variable '" << name <<
@@ -1219,6 +1277,113 @@ refcount_ptr<Component> Component::Deserialize(ostream& messages, const string&
 		}
 	}
 
+	for (size_t i = 0; !deserializedTree.IsNULL() &&
+	    i < customVariables.size(); ++ i) {
+		const string& name = customVariables[i].first;
+		if (!deserializedTree->SetVariableValue(name,
+		    customVariables[i].second)) {
+			messages << "Warning: variable '" << name <<
+			    "' for component class " << className <<
+			    " could not be deserialized; skipping.\n";
+		}
+	}
+
+	return deserializedTree;
+}
+
+
+void Component::SerializeBinary(BinaryWriter& writer) const
+{
+	writer.WriteString(m_className);
+
+	// Custom variables are written last, so that they can be checked
+	// against ordinary variables when they are read back.
+	writer.WriteUInt64(m_stateVariables.size());
+	for (int custom = 0; custom <= 1; ++ custom) {
+		for (StateVariableMap::const_iterator it =
+		    m_stateVariables.begin(); it != m_stateVariables.end();
+		    ++it) {
+			if ((it->second.GetType() == StateVariable::Custom)
+			    == (custom != 0))
+				(it->second).SerializeBinary(writer);
+		}
+	}
+
+	writer.WriteUInt64(m_childComponents.size());
+	for (size_t i = 0, n = m_childComponents.size(); i < n; ++ i)
+		m_childComponents[i]->SerializeBinary(writer);
+}
+
+
+refcount_ptr<Component> Component::DeserializeBinary(ostream& messages,
+	BinaryReader& reader)
+{
+	refcount_ptr<Component> deserializedTree = NULL;
+
+	string className;
+	if (!reader.ReadString(className)) {
+		messages << "Expecting a class name.\n";
+		return deserializedTree;
+	}
+
+	// root is a special case (cannot be created by the factory). All other
+	// class types should be possible to create using the factory.
+	if (className == "root") {
+		deserializedTree = new RootComponent;
+	} else {
+		deserializedTree = ComponentFactory::CreateComponent(className);
+		if (deserializedTree.IsNULL()) {
+			messages << "Could not create a '" << className << "' component.\n";
+			return deserializedTree;
+		}
+	}
+
+	uint64_t nVariables;
+	if (!reader.ReadUInt64(nVariables)) {
+		messages << "Failure. (0)\n";
+		return NULL;
+	}
+
+	for (uint64_t i = 0; i < nVariables; ++ i) {
+		string name;
+		uint8_t type;
+		if (!reader.ReadString(name) || !reader.ReadUInt8(type)) {
+			messages << "Failure. (1)\n";
+			return NULL;
+		}
+
+		StateVariable* var = deserializedTree->GetVariable(name);
+		bool success = var != NULL?
+		    var->DeserializeBinaryValue(reader, (StateVariable::Type) type)
+		    : StateVariable::SkipBinaryValue(reader, (StateVariable::Type) type);
+
+		if (!success) {
+			messages << "Variable '" << name << "' for component class "
+			    << className << " could not be deserialized.\n";
+			return NULL;
+		}
+
+		if (var == NULL || var->GetType() != type)
+			messages << "Warning: variable '" << name <<
+			    "' for component class " << className <<
+			    " could not be deserialized; skipping.\n";
+	}
+
+	uint64_t nChildren;
+	if (!reader.ReadUInt64(nChildren)) {
+		messages << "Failure. (2)\n";
+		return NULL;
+	}
+
+	for (uint64_t i = 0; i < nChildren; ++ i) {
+		refcount_ptr<Component> child =
+		    Component::DeserializeBinary(messages, reader);
+		if (child.IsNULL())
+			return NULL;
+
+		deserializedTree->AddChild(child);
+	}
+
 	return deserializedTree;
 }
 
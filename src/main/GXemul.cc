@@ -169,7 +169,10 @@
 #include <sys/time.h>
 #include <cmath>
 #include <fstream>
+#include <algorithm>
+#include <functional>
 #include <iostream>
+#include <queue>
 
 
 GXemul::GXemul()
@@ -181,6 +184,9 @@ GXemul::GXemul()
 	, m_nrOfSingleStepsLeft(1)
 	, m_rootComponent(new RootComponent(this))
 	, m_snapshottingEnabled(false)
+	, m_snapshotSpacingFactor(1)
+	, m_executableComponentsValid(false)
+	, m_sloppyAccuracy(false)
 {
 	gettimeofday(&m_lastOutputTime, NULL);
 	m_lastOutputStep = 0;
@@ -196,6 +202,10 @@ void GXemul::ClearEmulation()
 
 	m_rootComponent = new RootComponent(this);
 	m_emulationFileName = "";
+	DiscardSnapshots();
+
+	InvalidateExecutableComponents();
+	m_executableComponents.clear();
 
 	GetUI()->UpdateUI();
 }
@@ -693,12 +703,21 @@ void GXemul::SetRootComponent(refcount_ptr<Component> newRootComponent)
 
 	m_rootComponent = newRootComponent;
 
+	// Snapshots of the old emulation are of no use anymore.
+	DiscardSnapshots();
+
+	InvalidateExecutableComponents();
+	m_executableComponents.clear();
+
 	GetUI()->UpdateUI();
 }
 
 
 bool GXemul::Reset()
 {
+	DiscardSnapshots();
+	InvalidateExecutableComponents();
+
 	// 1. Reset all components in the tree.
 	GetRootComponent()->Reset();
 
@@ -806,6 +825,17 @@ void GXemul::SetNrOfSingleStepsInARow(uint64_t steps)
 }
 
 
+// Snapshots are taken every root.snapshotInterval steps, but the spacing
+// is doubled whenever there would be more than this many snapshots.
+#define DEFAULT_SNAPSHOT_INTERVAL	100000
+#define MAX_NR_OF_SNAPSHOTS		64
+
+static uint64_t SnapshotStep(const refcount_ptr<Component>& snapshot)
+{
+	return snapshot->GetVariable("step")->ToInteger();
+}
+
+
 bool GXemul::ModifyStep(int64_t oldStep, int64_t newStep)
 {
 	if (!GetSnapshottingEnabled())
@@ -815,12 +845,33 @@ bool GXemul::ModifyStep(int64_t oldStep, int64_t newStep)
 		return true;
 
 	if (newStep < oldStep) {
-		// Run in reverse, by running forward from the most suitable
-		// snapshot.
+		// Run in reverse, by running forward from the nearest snapshot
+		// at or before newStep. Snapshots after newStep are discarded;
+		// they will be taken again when running forward.
+		size_t n = m_snapshots.size();
+		while (n > 0 && SnapshotStep(m_snapshots[n-1]) > (uint64_t)newStep)
+			-- n;
+
+		if (n == 0) {
+			GetUI()->ShowDebugMessage("No snapshot to run from.\n");
+			return false;
+		}
 
-		// TODO: Multiple snapshots!
-		refcount_ptr<Component> newRoot = m_snapshot->Clone();
+		m_snapshots.resize(n);
+
+		refcount_ptr<Component> newRoot = m_snapshots[n-1]->Clone();
+
+		// The snapshot interval is a setting, not emulation state, so
+		// it should not be rolled back.
+		StateVariable* interval = newRoot->GetVariable("snapshotInterval");
+		if (interval != NULL)
+			interval->CopyValueFrom(*GetRootComponent()->GetVariable("snapshotInterval"));
+
+		// Keep the snapshots, even though the root component changes.
+		vector< refcount_ptr<Component> > snapshots;
+		snapshots.swap(m_snapshots);
 		SetRootComponent(newRoot);
+		m_snapshots.swap(snapshots);
 
 		// GetStep will now return the step count for the new root.
 		int64_t nrOfStepsToRunFromSnapshot = newStep - GetStep();
@@ -841,48 +892,156 @@ bool GXemul::ModifyStep(int64_t oldStep, int64_t newStep)
 }
 
 
+uint64_t GXemul::GetSnapshotSpacing() const
+{
+	const StateVariable* interval =
+	    GetRootComponent()->GetVariable("snapshotInterval");
+	uint64_t spacing = interval == NULL? 0 : interval->ToInteger();
+	if (spacing == 0)
+		spacing = DEFAULT_SNAPSHOT_INTERVAL;
+
+	return spacing * m_snapshotSpacingFactor;
+}
+
+
+void GXemul::DiscardSnapshots()
+{
+	m_snapshots.clear();
+	m_snapshotSpacingFactor = 1;
+}
+
+
 void GXemul::TakeSnapshot()
 {
-	// TODO: Multiple snapshots!
+	uint64_t step = GetStep();
+
+	if (!m_snapshots.empty() && SnapshotStep(m_snapshots.back()) >= step)
+		return;
 
-	if (m_snapshot.IsNULL()) {
+	if (m_snapshots.empty()) {
 		stringstream ss;
-		ss << "(snapshot at step " << GetStep() << ")\n";
+		ss << "(snapshot at step " << step << ")\n";
 		GetUI()->ShowDebugMessage(ss.str());
+	}
+
+	// The snapshot shares RAM blocks with the running emulation. (Host
+	// pages which CPUs have cached for writing are invalidated by the
+	// RAM components, so cached state does not have to be flushed.)
+	m_snapshots.push_back(GetRootComponent()->Clone());
+
+	// Too many snapshots? Then keep every other one, and take them half
+	// as often from now on. The first snapshot is always kept.
+	if (m_snapshots.size() > MAX_NR_OF_SNAPSHOTS) {
+		m_snapshotSpacingFactor *= 2;
+		uint64_t spacing = GetSnapshotSpacing();
+
+		vector< refcount_ptr<Component> > kept;
+		for (size_t i=0; i<m_snapshots.size(); ++i)
+			if (i == 0 || SnapshotStep(m_snapshots[i]) % spacing == 0)
+				kept.push_back(m_snapshots[i]);
+
+		m_snapshots.swap(kept);
+	}
+}
+
 
-		m_snapshot = GetRootComponent()->Clone();
+// In sloppy mode, components run this many steps (of the fastest component)
+// at a time, between synchronization points. Quanta are aligned to multiples
+// of this value, so that re-execution from a snapshot interleaves the same way.
+#define SLOPPY_QUANTUM			10000
+
+
+// (Next time to execute, component index) pairs, with the earliest first.
+typedef pair<uint64_t, size_t> ScheduledComponent;
+typedef std::priority_queue< ScheduledComponent, vector<ScheduledComponent>,
+	std::greater<ScheduledComponent> > ScheduleQueue;
+
+
+// Calculates a * b / c, and the remainder, without overflowing on a * b.
+// (c must be less than 2^63.)
+static uint64_t MulDiv(uint64_t a, uint64_t b, uint64_t c, uint64_t& remainder)
+{
+	uint64_t ra = a % c;
+	uint64_t q = 0, r = 0;
+
+	// Shift-and-add multiplication of ra * b, modulo c:
+	for (int bit = 63; bit >= 0; --bit) {
+		q <<= 1;
+		r <<= 1;
+		if (r >= c) {
+			r -= c;
+			++ q;
+		}
+
+		if ((b >> bit) & 1) {
+			r += ra;
+			if (r >= c) {
+				r -= c;
+				++ q;
+			}
+		}
 	}
+
+	remainder = r;
+	return (a / c) * b + q;
+}
+
+
+// Calculates how many steps a component should have executed, when the
+// fastest component has executed fastestSteps steps.
+static uint64_t StepsAt(const ComponentAndFrequency& caf,
+	uint64_t fastestFrequency, uint64_t fastestSteps)
+{
+	uint64_t remainder;
+	return MulDiv(fastestSteps, caf.intFrequency, fastestFrequency, remainder);
+}
+
+
+static void UpdateNextTimeToExecute(ComponentAndFrequency& caf)
+{
+	caf.nextTimeToExecute = caf.timeQuotient +
+	    (caf.timeRemainder != 0 ? 1 : 0) - 1;
+}
+
+
+static void InitializeSchedule(ComponentAndFrequency& caf,
+	uint64_t fastestFrequency)
+{
+	caf.periodQuotient = fastestFrequency / caf.intFrequency;
+	caf.periodRemainder = fastestFrequency % caf.intFrequency;
+	caf.timeQuotient = MulDiv(*caf.step + 1, fastestFrequency,
+	    caf.intFrequency, caf.timeRemainder);
+	UpdateNextTimeToExecute(caf);
 }
 
 
-struct ComponentAndFrequency
+static void AdvanceSchedule(ComponentAndFrequency& caf)
 {
-	refcount_ptr<Component>	component;
-	double			frequency;
-	StateVariable*		step;
+	caf.timeQuotient += caf.periodQuotient;
+	caf.timeRemainder += caf.periodRemainder;
+	if (caf.timeRemainder >= caf.intFrequency) {
+		caf.timeRemainder -= caf.intFrequency;
+		++ caf.timeQuotient;
+	}
 
-	uint64_t		nextTimeToExecute;
-};
+	UpdateNextTimeToExecute(caf);
+}
 
 
-// Gathers a list of components and their frequencies. (Only components that
-// have a variable named "frequency" are executable.)
+// Gathers a list of components, with handles to their frequency and step
+// variables. (Only components that have a variable named "frequency" are
+// executable.)
 static void GetComponentsAndFrequencies(refcount_ptr<Component> component,
 	vector<ComponentAndFrequency>& componentsAndFrequencies)
 {
 	const StateVariable* paused = component->GetVariable("paused");
-	const StateVariable* freq = component->GetVariable("frequency");
-	StateVariable* step = component->GetVariable("step");
-	if (freq != NULL && step != NULL &&
-	    (paused == NULL || paused->ToInteger() == 0)) {
+	if (paused == NULL || paused->ToInteger() == 0) {
 		struct ComponentAndFrequency caf;
-		memset(&caf, 0, sizeof(caf));
 
 		caf.component = component;
-		caf.frequency = freq->ToDouble();
-		caf.step      = step;
-
-		componentsAndFrequencies.push_back(caf);
+		if (caf.frequencyVariable.Resolve(component, "frequency") &&
+		    caf.step.Resolve(component, "step"))
+			componentsAndFrequencies.push_back(caf);
 	}
 	
 	Components children = component->GetChildren();
@@ -891,10 +1050,33 @@ static void GetComponentsAndFrequencies(refcount_ptr<Component> component,
 }
 
 
+void GXemul::InvalidateExecutableComponents()
+{
+	m_executableComponentsValid = false;
+}
+
+
 void GXemul::Execute(const int longestTotalRun)
 {
-	vector<ComponentAndFrequency> componentsAndFrequencies;
-	GetComponentsAndFrequencies(GetRootComponent(), componentsAndFrequencies);
+	if (!m_executableComponentsValid) {
+		m_executableComponents.clear();
+		GetComponentsAndFrequencies(GetRootComponent(), m_executableComponents);
+
+		m_sloppyAccuracy = GetRootComponent()->
+		    GetVariable("accuracy")->ToString() == "sloppy";
+		m_executableComponentsValid = true;
+	}
+
+	vector<ComponentAndFrequency>& componentsAndFrequencies = m_executableComponents;
+
+	// Frequencies may have changed since the last call. Scheduling is
+	// done with integers, so fractions of a Hz are rounded away.
+	for (size_t i=0; i<componentsAndFrequencies.size(); ++i) {
+		ComponentAndFrequency& caf = componentsAndFrequencies[i];
+		caf.frequency = *caf.frequencyVariable;
+		caf.intFrequency = caf.frequency >= 1.0 ?
+		    (uint64_t) (caf.frequency + 0.5) : 1;
+	}
 
 	if (componentsAndFrequencies.size() == 0) {
 		GetUI()->ShowDebugMessage("No executable components"
@@ -903,10 +1085,6 @@ void GXemul::Execute(const int longestTotalRun)
 		return;
 	}
 
-	// Take an initial snapshot at step 0, if snapshotting is enabled:
-	if (m_snapshottingEnabled && GetStep() == 0)
-		TakeSnapshot();
-
 	// Find the fastest component:
 	double fastestFrequency = componentsAndFrequencies[0].frequency;
 	size_t fastestComponentIndex = 0;
@@ -916,6 +1094,9 @@ void GXemul::Execute(const int longestTotalRun)
 			fastestComponentIndex = i;
 		}
 
+	uint64_t fastestIntFrequency =
+	    componentsAndFrequencies[fastestComponentIndex].intFrequency;
+
 	bool printEmptyLineBetweenSteps = false;
 
 	switch (GetRunState()) {
@@ -929,6 +1110,9 @@ void GXemul::Execute(const int longestTotalRun)
 		while (!m_interrupting && m_nrOfSingleStepsLeft > 0 && GetRunState() == SingleStepping) {
 			uint64_t step = GetStep();
 
+			if (m_snapshottingEnabled && step % GetSnapshotSpacing() == 0)
+				TakeSnapshot();
+
 			if (printEmptyLineBetweenSteps)
 				GetUI()->ShowDebugMessage("\n");
 			else
@@ -946,9 +1130,9 @@ void GXemul::Execute(const int longestTotalRun)
 			// nstepsX = steps * fX / fastestFrequency  nr of steps.
 			for (size_t k=0; k<componentsAndFrequencies.size(); ++k) {
 				uint64_t nsteps = (k == fastestComponentIndex ? step
-				    : (uint64_t) (step * componentsAndFrequencies[k].frequency / fastestFrequency));
+				    : StepsAt(componentsAndFrequencies[k], fastestIntFrequency, step));
 
-				uint64_t stepsExecutedSoFar = componentsAndFrequencies[k].step->ToInteger();
+				uint64_t stepsExecutedSoFar = *componentsAndFrequencies[k].step;
 
 				if (stepsExecutedSoFar > nsteps) {
 					std::cerr << "Internal error: " <<
@@ -960,8 +1144,7 @@ void GXemul::Execute(const int longestTotalRun)
 				if (stepsExecutedSoFar < nsteps) {
 					++ stepsExecutedSoFar;
 
-					const refcount_ptr<Component> lightClone =
-					    GetRootComponent()->LightClone();
+					GetRootComponent()->MarkUnchanged();
 
 					// Execute one step...
 					int n = componentsAndFrequencies[k].component->Execute(this, 1);
@@ -972,12 +1155,12 @@ void GXemul::Execute(const int longestTotalRun)
 					}
 					
 					// ... and write back the number of executed steps:
-					componentsAndFrequencies[k].step->SetValue(stepsExecutedSoFar);
+					*componentsAndFrequencies[k].step = stepsExecutedSoFar;
 
-					// Now, let's compare the clone of the component tree
+					// Now, let's compare the state of the component tree
 					// before execution with what we have now.
 					stringstream changeMessages;
-					GetRootComponent()->DetectChanges(lightClone, changeMessages);
+					GetRootComponent()->DetectChanges(changeMessages);
 					string msg = changeMessages.str();
 					if (msg.length() > 0)
 						GetUI()->ShowDebugMessage(msg);
@@ -998,97 +1181,156 @@ void GXemul::Execute(const int longestTotalRun)
 			uint64_t step = GetStep();
 			uint64_t startingStep = step;
 
-			// TODO: sloppy vs cycle accuracy.
-			if (GetRootComponent()->GetVariable("accuracy")->ToString() != "cycle") {
-				std::cerr << "GXemul::Execute(): TODO: Only "
-				    "root.accuracy=\"cycle\" is currently supported\n";
-				SetRunState(Paused);
-				return;
+			// In cycle accurate mode, components are interleaved at
+			// the exact steps where they execute. In sloppy mode, each
+			// component instead runs a whole quantum at a time, with
+			// the number of steps proportional to its frequency.
+			bool sloppy = m_sloppyAccuracy;
+
+			// In cycle accurate mode, the fastest component executes
+			// at every step. All other components are kept in a queue,
+			// ordered by the step at which they execute next.
+			ScheduleQueue queue;
+			if (!sloppy) {
+				for (size_t k=0; k<componentsAndFrequencies.size(); ++k) {
+					if (k == fastestComponentIndex)
+						continue;
+
+					InitializeSchedule(componentsAndFrequencies[k],
+					    fastestIntFrequency);
+					queue.push(ScheduledComponent(componentsAndFrequencies[k].
+					    nextTimeToExecute, k));
+				}
 			}
 
-			// The following code is for cycle accurate emulation:
+			vector<size_t> componentsToRun;
+			vector<ScheduledComponent> componentsBehind;
 
 			while (step < startingStep + longestTotalRun) {
 				if (m_interrupting || GetRunState() != Running)
 					break;
 
+				uint64_t nextSnapshotStep = 0;
+				if (m_snapshottingEnabled) {
+					uint64_t spacing = GetSnapshotSpacing();
+					if (step % spacing == 0)
+						TakeSnapshot();
+
+					nextSnapshotStep = (step / spacing + 1) * spacing;
+				}
+
 				int toExecute = -1;
-				
+				componentsToRun.clear();
+
 				if (componentsAndFrequencies.size() == 1) {
 					toExecute = longestTotalRun;
 					componentsAndFrequencies[0].nextTimeToExecute = step;
+					componentsToRun.push_back(0);
+				} else if (sloppy) {
+					toExecute = (step / SLOPPY_QUANTUM + 1) * SLOPPY_QUANTUM - step;
+					for (size_t k=0; k<componentsAndFrequencies.size(); ++k)
+						componentsToRun.push_back(k);
 				} else {
-					// First, calculate the next time step when each
-					// component k will execute.
-					//
-					// For n = 0,1,2,3, ...
-					// n * fastestFrequency / componentsAndFrequencies[k].frequency
-					// are the steps at which the component executes
-					// (when rounded UP! i.e. executing at step 4.2 means that it
-					// did not execute at step 4, but will at step 5).
-				
-					for (size_t k=0; k<componentsAndFrequencies.size(); ++k) {
-						double q = (k == fastestComponentIndex ? 1.0
-						    : fastestFrequency / componentsAndFrequencies[k].frequency);
-
-						double c = (componentsAndFrequencies[k].step->ToInteger()+1) * q;
-						componentsAndFrequencies[k].nextTimeToExecute = (uint64_t) ceil(c) - 1;
+					ComponentAndFrequency& fastest =
+					    componentsAndFrequencies[fastestComponentIndex];
+					fastest.nextTimeToExecute = *fastest.step;
+
+					// Run until the next component (other than the
+					// fastest) is to execute. If that is right now,
+					// run only one step.
+					int64_t diff = queue.top().first - fastest.nextTimeToExecute;
+					toExecute = diff < 1 ? 1 : (diff > longestTotalRun ?
+					    longestTotalRun : diff);
+
+					if (fastest.nextTimeToExecute == step)
+						componentsToRun.push_back(fastestComponentIndex);
+
+					// Take all components that execute at this step
+					// out of the queue. They are put back after they
+					// have executed. (Components which are behind,
+					// e.g. because they were added during a run, never
+					// get to execute.)
+					componentsBehind.clear();
+					while (!queue.empty() && queue.top().first <= step) {
+						if (queue.top().first == step)
+							componentsToRun.push_back(queue.top().second);
+						else
+							componentsBehind.push_back(queue.top());
+
+						queue.pop();
 					}
 
-					// std::cerr << "step " << step << " debug:\n";
-					for (size_t k=0; k<componentsAndFrequencies.size(); ++k) {
-						// std::cerr << "  next step for component " <<
-						//    componentsAndFrequencies[k].component->GetVariable("name")->ToString()
-						//    << ": " << componentsAndFrequencies[k].nextTimeToExecute << "\n";
-
-						int diff = componentsAndFrequencies[k].nextTimeToExecute -
-						    componentsAndFrequencies[fastestComponentIndex].nextTimeToExecute;
-						if (k != fastestComponentIndex) {
-							if (toExecute == -1 || diff < toExecute)
-								toExecute = diff;
-						}
-					}
+					for (size_t i=0; i<componentsBehind.size(); ++i)
+						queue.push(componentsBehind[i]);
 
-					if (toExecute < 1)
-						toExecute = 1;
+					// Components execute in the order they appear in
+					// the component tree.
+					std::sort(componentsToRun.begin(), componentsToRun.end());
 				}
 
 				if (step + toExecute > startingStep + longestTotalRun)
 					toExecute = startingStep + longestTotalRun - step;
 
+				// Stop at the next snapshot, if snapshotting is enabled.
+				if (m_snapshottingEnabled && step + toExecute > nextSnapshotStep)
+					toExecute = nextSnapshotStep - step;
+
 				// std::cerr << "  toExecute = " << toExecute << "\n";
 
 				// Run the components.
 				// If multiple components are to run at the same time (i.e.
 				// same nextTimeToExecute), toExecute will be exactly 1.
+				// In sloppy mode, each component catches up to where it
+				// should be at the end of the quantum, just like when
+				// single-stepping.
 				int maxExecuted = 0;
 				bool abort = false;
-				for (size_t k=0; k<componentsAndFrequencies.size(); ++k) {
-					if (step != componentsAndFrequencies[k].nextTimeToExecute)
-						continue;
+				for (size_t i=0; i<componentsToRun.size(); ++i) {
+					size_t k = componentsToRun[i];
+					uint64_t stepsExecutedSoFar =
+					    *componentsAndFrequencies[k].step;
+					int wanted = toExecute;
+
+					if (sloppy && componentsAndFrequencies.size() > 1) {
+						uint64_t endStep = step + toExecute;
+						uint64_t nsteps = (k == fastestComponentIndex ? endStep
+						    : StepsAt(componentsAndFrequencies[k], fastestIntFrequency, endStep));
+						if (nsteps <= stepsExecutedSoFar)
+							continue;
+
+						wanted = nsteps - stepsExecutedSoFar;
+					}
 
 					// Execute the calculated number of steps...
-					int n = componentsAndFrequencies[k].component->Execute(this, toExecute);
+					int n = componentsAndFrequencies[k].component->Execute(this, wanted);
 
 					// ... and write back the number of executed steps:
-					uint64_t stepsExecutedSoFar = n +
-					    componentsAndFrequencies[k].step->ToInteger();
-					componentsAndFrequencies[k].step->SetValue(stepsExecutedSoFar);
+					stepsExecutedSoFar += n;
+					*componentsAndFrequencies[k].step = stepsExecutedSoFar;
+
+					// ... and put it back in the queue:
+					if (!sloppy && k != fastestComponentIndex) {
+						for (int j=0; j<n; ++j)
+							AdvanceSchedule(componentsAndFrequencies[k]);
+
+						queue.push(ScheduledComponent(componentsAndFrequencies[k].
+						    nextTimeToExecute, k));
+					}
 
 					if (k == fastestComponentIndex)
 						maxExecuted = n;
 
-					if (n != toExecute) {
+					if (n != wanted) {
 						abort = true;
 
-						if (n > toExecute) {
+						if (n > wanted) {
 							std::cerr << "Internal error: " << n <<
-							    " steps executed, toExecute = " << toExecute << "\n";
+							    " steps executed, toExecute = " << wanted << "\n";
 							throw std::exception();
 						}
 
 						stringstream ss;
-						ss << "only " << n << " steps of " << toExecute << " executed.";
+						ss << "only " << n << " steps of " << wanted << " executed.";
 						GetUI()->ShowDebugMessage(componentsAndFrequencies[k].component, ss.str());
 					}
 				}
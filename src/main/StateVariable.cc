@@ -27,7 +27,10 @@
 
 #include <assert.h>
 #include <math.h>
+#include <string.h>
 
+#include "BinaryReader.h"
+#include "BinaryWriter.h"
 #include "EscapedString.h"
 #include "StateVariable.h"
 #include "StringHelper.h"
@@ -226,6 +229,129 @@ bool StateVariable::CopyValueFrom(const StateVariable& otherVariable)
 }
 
 
+void StateVariable::MarkUnchanged()
+{
+	switch (m_type) {
+	case String:
+		m_unchangedString = *m_value.pstr;
+		break;
+	case Bool:
+		m_unchangedValue.b = *m_value.pbool;
+		break;
+	case Double:
+		m_unchangedValue.d = *m_value.pdouble;
+		break;
+	case UInt8:
+		m_unchangedValue.u8 = *m_value.puint8;
+		break;
+	case UInt16:
+		m_unchangedValue.u16 = *m_value.puint16;
+		break;
+	case UInt32:
+		m_unchangedValue.u32 = *m_value.puint32;
+		break;
+	case UInt64:
+		m_unchangedValue.u64 = *m_value.puint64;
+		break;
+	case SInt8:
+		m_unchangedValue.s8 = *m_value.psint8;
+		break;
+	case SInt16:
+		m_unchangedValue.s16 = *m_value.psint16;
+		break;
+	case SInt32:
+		m_unchangedValue.s32 = *m_value.psint32;
+		break;
+	case SInt64:
+		m_unchangedValue.s64 = *m_value.psint64;
+		break;
+	case Custom:
+		break;
+	}
+}
+
+
+bool StateVariable::HasChanged() const
+{
+	switch (m_type) {
+	case String:
+		return m_unchangedString != *m_value.pstr;
+	case Bool:
+		return m_unchangedValue.b != *m_value.pbool;
+	case Double:
+		// Compare the bits, so that NaN is equal to itself.
+		return memcmp(&m_unchangedValue.d, m_value.pdouble,
+		    sizeof(double)) != 0;
+	case UInt8:
+		return m_unchangedValue.u8 != *m_value.puint8;
+	case UInt16:
+		return m_unchangedValue.u16 != *m_value.puint16;
+	case UInt32:
+		return m_unchangedValue.u32 != *m_value.puint32;
+	case UInt64:
+		return m_unchangedValue.u64 != *m_value.puint64;
+	case SInt8:
+		return m_unchangedValue.s8 != *m_value.psint8;
+	case SInt16:
+		return m_unchangedValue.s16 != *m_value.psint16;
+	case SInt32:
+		return m_unchangedValue.s32 != *m_value.psint32;
+	case SInt64:
+		return m_unchangedValue.s64 != *m_value.psint64;
+	case Custom:
+		return false;
+	}
+
+	return false;
+}
+
+
+string StateVariable::UnchangedValueToString() const
+{
+	// Format a copy of this variable, which points to the old value.
+	StateVariable old(*this);
+
+	switch (m_type) {
+	case String:
+		return m_unchangedString;
+	case Bool:
+		old.m_value.pbool = &old.m_unchangedValue.b;
+		break;
+	case Double:
+		old.m_value.pdouble = &old.m_unchangedValue.d;
+		break;
+	case UInt8:
+		old.m_value.puint8 = &old.m_unchangedValue.u8;
+		break;
+	case UInt16:
+		old.m_value.puint16 = &old.m_unchangedValue.u16;
+		break;
+	case UInt32:
+		old.m_value.puint32 = &old.m_unchangedValue.u32;
+		break;
+	case UInt64:
+		old.m_value.puint64 = &old.m_unchangedValue.u64;
+		break;
+	case SInt8:
+		old.m_value.psint8 = &old.m_unchangedValue.s8;
+		break;
+	case SInt16:
+		old.m_value.psint16 = &old.m_unchangedValue.s16;
+		break;
+	case SInt32:
+		old.m_value.psint32 = &old.m_unchangedValue.s32;
+		break;
+	case SInt64:
+		old.m_value.psint64 = &old.m_unchangedValue.s64;
+		break;
+	case Custom:
+		break;
+	}
+
+	return old.ToString();
+}
+
+
 string StateVariable::ToString() const
 {
 	stringstream sstr;
@@ -388,6 +514,110 @@ void StateVariable::Serialize(ostream& ss, SerializationContext& context) const
 }
 
 
+void CustomStateVariableHandler::SerializeBinary(BinaryWriter& writer) const
+{
+	stringstream ss;
+	Serialize(ss);
+	writer.WriteString(ss.str());
+}
+
+
+bool CustomStateVariableHandler::DeserializeBinary(BinaryReader& reader)
+{
+	string value;
+	return reader.ReadString(value) && Deserialize(value);
+}
+
+
+void StateVariable::SerializeBinary(BinaryWriter& writer) const
+{
+	writer.WriteString(m_name);
+	writer.WriteUInt8(m_type);
+
+	switch (m_type) {
+	case String:
+		writer.WriteString(*m_value.pstr);
+		break;
+	case Bool:
+		writer.WriteUInt8(*m_value.pbool? 1 : 0);
+		break;
+	case Double:
+		writer.WriteDouble(*m_value.pdouble);
+		break;
+	case Custom:
+		{
+			// The length is recorded, so that readers without
+			// a handler for the variable can skip it.
+			size_t start = writer.BeginLengthPrefixed();
+			m_value.phandler->SerializeBinary(writer);
+			writer.EndLengthPrefixed(start);
+		}
+		break;
+	default:
+		// All integer types. Signed values are sign extended.
+		writer.WriteUInt64(ToInteger());
+	}
+}
+
+
+bool StateVariable::DeserializeBinaryValue(BinaryReader& reader,
+	enum Type type)
+{
+	if (type != m_type)
+		return SkipBinaryValue(reader, type);
+
+	uint64_t value64;
+	uint8_t value8;
+
+	switch (m_type) {
+	case String:
+		return reader.ReadString(*m_value.pstr);
+	case Bool:
+		if (!reader.ReadUInt8(value8))
+			return false;
+		*m_value.pbool = value8 != 0;
+		return true;
+	case Double:
+		return reader.ReadDouble(*m_value.pdouble);
+	case Custom:
+		{
+			// The handler must read exactly the recorded length.
+			if (!reader.ReadUInt64(value64) ||
+			    value64 > reader.BytesLeft())
+				return false;
+
+			uint64_t end = reader.BytesLeft() - value64;
+			return m_value.phandler->DeserializeBinary(reader) &&
+			    reader.BytesLeft() == end;
+		}
+	default:
+		return reader.ReadUInt64(value64) && SetValue(value64);
+	}
+}
+
+
+bool StateVariable::SkipBinaryValue(BinaryReader& reader, enum Type type)
+{
+	string str;
+	uint8_t value8;
+	double d;
+	uint64_t value64;
+
+	switch (type) {
+	case String:
+		return reader.ReadString(str);
+	case Bool:
+		return reader.ReadUInt8(value8);
+	case Double:
+		return reader.ReadDouble(d);
+	case Custom:
+		return reader.ReadUInt64(value64) && reader.Skip(value64);
+	default:
+		return reader.ReadUInt64(value64);
+	}
+}
+
+
 string StateVariable::EvaluateExpression(const string& expression,
 	bool& success) const
 {
@@ -629,6 +859,72 @@ bool StateVariable::SetValue(uint64_t value)
 }
 
 
+template<> string* StateVariable::GetTypedPointer<string>()
+{
+	return m_type == String ? m_value.pstr : NULL;
+}
+
+
+template<> bool* StateVariable::GetTypedPointer<bool>()
+{
+	return m_type == Bool ? m_value.pbool : NULL;
+}
+
+
+template<> double* StateVariable::GetTypedPointer<double>()
+{
+	return m_type == Double ? m_value.pdouble : NULL;
+}
+
+
+template<> uint8_t* StateVariable::GetTypedPointer<uint8_t>()
+{
+	return m_type == UInt8 ? m_value.puint8 : NULL;
+}
+
+
+template<> uint16_t* StateVariable::GetTypedPointer<uint16_t>()
+{
+	return m_type == UInt16 ? m_value.puint16 : NULL;
+}
+
+
+template<> uint32_t* StateVariable::GetTypedPointer<uint32_t>()
+{
+	return m_type == UInt32 ? m_value.puint32 : NULL;
+}
+
+
+template<> uint64_t* StateVariable::GetTypedPointer<uint64_t>()
+{
+	return m_type == UInt64 ? m_value.puint64 : NULL;
+}
+
+
+template<> int8_t* StateVariable::GetTypedPointer<int8_t>()
+{
+	return m_type == SInt8 ? m_value.psint8 : NULL;
+}
+
+
+template<> int16_t* StateVariable::GetTypedPointer<int16_t>()
+{
+	return m_type == SInt16 ? m_value.psint16 : NULL;
+}
+
+
+template<> int32_t* StateVariable::GetTypedPointer<int32_t>()
+{
+	return m_type == SInt32 ? m_value.psint32 : NULL;
+}
+
+
+template<> int64_t* StateVariable::GetTypedPointer<int64_t>()
+{
+	return m_type == SInt64 ? m_value.psint64 : NULL;
+}
+
+
 /*****************************************************************************/
 
 
@@ -938,6 +1234,35 @@ static void Test_StateVariable_Numeric_SetValue()
 	// Tests for other numeric types: TODO
 }
 
+static void Test_StateVariable_GetTypedPointer()
+{
+	uint64_t varUInt64 = 42;
+	double   varDouble = 1.5;
+	string   varString = "hello";
+
+	StateVariable vuint64("vuint64", &varUInt64);
+	StateVariable vdouble("vdouble", &varDouble);
+	StateVariable vstring("vstring", &varString);
+
+	UnitTest::Assert("uint64_t pointer should point to the variable",
+	    vuint64.GetTypedPointer<uint64_t>() == &varUInt64);
+	UnitTest::Assert("double pointer should point to the variable",
+	    vdouble.GetTypedPointer<double>() == &varDouble);
+	UnitTest::Assert("string pointer should point to the variable",
+	    vstring.GetTypedPointer<string>() == &varString);
+
+	UnitTest::Assert("wrong type should give NULL (1)",
+	    vuint64.GetTypedPointer<uint32_t>() == NULL);
+	UnitTest::Assert("wrong type should give NULL (2)",
+	    vuint64.GetTypedPointer<int64_t>() == NULL);
+	UnitTest::Assert("wrong type should give NULL (3)",
+	    vdouble.GetTypedPointer<uint64_t>() == NULL);
+
+	*vuint64.GetTypedPointer<uint64_t>() = 123;
+	UnitTest::Assert("value should have been written through the pointer",
+	    vuint64.ToInteger(), 123);
+}
+
 UNITTESTS(StateVariable)
 {
 	// String tests
@@ -959,6 +1284,9 @@ UNITTESTS(StateVariable)
 	//UNITTEST(Test_StateVariable_Numeric_CopyValueFrom);
 	//UNITTEST(Test_StateVariable_Numeric_Serialize);
 
+	// Typed access
+	UNITTEST(Test_StateVariable_GetTypedPointer);
+
 	// TODO: ToInteger tests.
 
 	// TODO: Custom tests.
@@ -210,6 +210,51 @@ static void Test_BackwardStepCommand_Basic()
 	UnitTest::Assert("X: cpu0.v1", cpu->GetVariable("v1")->ToString(), "0");
 }
 
+static void Test_BackwardStepCommand_MultipleSnapshots()
+{
+	refcount_ptr<Command> cmd = new BackwardStepCommand;
+	vector<string> dummyArguments;
+	
+	GXemul gxemul;
+
+	char filename[] = "test/FileLoader_ELF_MIPS";
+	char *filenames[] = { filename };
+	gxemul.ParseFilenames("testmips", 1, filenames);
+	gxemul.Reset();
+
+	gxemul.SetSnapshottingEnabled(true);
+	gxemul.GetCommandInterpreter().RunCommand("root.snapshotInterval = 2");
+
+	// Snapshots are taken at steps 0 and 2.
+	gxemul.GetCommandInterpreter().RunCommand("step 3");
+	gxemul.Execute();
+
+	UnitTest::Assert("root.step should initially be 3", gxemul.GetStep(), 3);
+
+	// Runs from the snapshot at step 2...
+	cmd->Execute(gxemul, dummyArguments);
+	UnitTest::Assert("root.step should be 2", gxemul.GetStep(), 2);
+	refcount_ptr<Component> cpu = gxemul.GetRootComponent()->LookupPath("cpu0");
+	UnitTest::Assert("2: cpu0.pc", cpu->GetVariable("pc")->ToString(), "0xffffffff80010100");
+	UnitTest::Assert("2: cpu0.v0", cpu->GetVariable("v0")->ToString(), "0");
+	UnitTest::Assert("2: cpu0.v1", cpu->GetVariable("v1")->ToString(), "0xffffffffcccc0000");
+
+	// ... and from the snapshot at step 0:
+	cmd->Execute(gxemul, dummyArguments);
+	UnitTest::Assert("root.step should be 1", gxemul.GetStep(), 1);
+	cpu = gxemul.GetRootComponent()->LookupPath("cpu0");
+	UnitTest::Assert("1: cpu0.pc", cpu->GetVariable("pc")->ToString(), "0xffffffff800100fc");
+	UnitTest::Assert("1: cpu0.v1", cpu->GetVariable("v1")->ToString(), "0");
+
+	// Running forward again should reach the same state as before.
+	gxemul.GetCommandInterpreter().RunCommand("step 2");
+	gxemul.Execute();
+	UnitTest::Assert("root.step should be 3 again", gxemul.GetStep(), 3);
+	cpu = gxemul.GetRootComponent()->LookupPath("cpu0");
+	UnitTest::Assert("3: cpu0.pc", cpu->GetVariable("pc")->ToString(), "0xffffffff80010104");
+	UnitTest::Assert("3: cpu0.v0", cpu->GetVariable("v0")->ToString(), "0xffffffff88880000");
+}
+
 // Reset resets the component tree, but does not load back the binary!
 static void Test_BackwardStepCommand_ManualAddAndLoad()
 {
@@ -270,6 +315,7 @@ UNITTESTS(BackwardStepCommand)
 	UNITTEST(Test_BackwardStepCommand_AlreadyAtStep0);
 	UNITTEST(Test_BackwardStepCommand_NotWhenSnapshotsAreDisabled);
 	UNITTEST(Test_BackwardStepCommand_Basic);
+	UNITTEST(Test_BackwardStepCommand_MultipleSnapshots);
 	UNITTEST(Test_BackwardStepCommand_ManualAddAndLoad);
 }
 
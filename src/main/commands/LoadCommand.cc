@@ -30,6 +30,7 @@
 #include <string.h>
 
 #include "commands/LoadCommand.h"
+#include "BinaryReader.h"
 #include "FileLoader.h"
 #include "GXemul.h"
 
@@ -57,6 +58,9 @@ bool LoadCommand::IsComponentTree(GXemul& gxemul, const string& filename) const
 	if (file.fail())
 		return false;
 
+	if (BinaryReader::IsBinaryFile(filename))
+		return true;
+
 	char buf[256];
 	file.read(buf, sizeof(buf));
 	if (file.gcount() < 10)
@@ -78,6 +82,23 @@ bool LoadCommand::LoadComponentTree(GXemul& gxemul, const string&filename,
 
 	refcount_ptr<Component> component;
 
+	if (BinaryReader::IsBinaryFile(filename)) {
+		BinaryReader reader;
+		stringstream messages;
+		if (reader.Open(filename, messages))
+			component = Component::DeserializeBinary(messages,
+			    reader);
+
+		if (!component.IsNULL() && reader.BytesLeft() != 0) {
+			messages << filename << " has trailing data after"
+			    " the component tree.\n";
+			component = NULL;
+		}
+
+		return AddLoadedComponentTree(gxemul, filename,
+		    specifiedComponent, component, messages.str());
+	}
+
 	// Load from the file
 	std::ifstream file(filename.c_str());
 	if (file.fail()) {
@@ -113,8 +134,17 @@ bool LoadCommand::LoadComponentTree(GXemul& gxemul, const string&filename,
 	stringstream messages;
 	component = Component::Deserialize(messages, str, strPos);
 
-	if (messages.str().length() > 0)
-		ShowMsg(gxemul, messages.str());
+	return AddLoadedComponentTree(gxemul, filename, specifiedComponent,
+	    component, messages.str());
+}
+
+
+bool LoadCommand::AddLoadedComponentTree(GXemul& gxemul,
+	const string& filename, refcount_ptr<Component> specifiedComponent,
+	refcount_ptr<Component> component, const string& messages) const
+{
+	if (messages.length() > 0)
+		ShowMsg(gxemul, messages);
 
 	if (component.IsNULL()) {
 		ShowMsg(gxemul, "Loading from " + filename + " failed; "
@@ -26,6 +26,7 @@
  */
 
 #include "commands/SaveCommand.h"
+#include "BinaryWriter.h"
 #include "GXemul.h"
 
 #include <fstream>
@@ -97,16 +98,14 @@ bool SaveCommand::Execute(GXemul& gxemul, const vector<string>& arguments)
 
 	// Write to the file:
 	{
-		std::fstream outputstream(filename.c_str(),
-		    std::ios::out | std::ios::trunc);
-		if (outputstream.fail()) {
-			ShowMsg(gxemul, "Error: Could not open " + filename +
-			    " for writing.\n");
+		BinaryWriter writer;
+		component->SerializeBinary(writer);
+
+		if (!writer.Finish(filename)) {
+			ShowMsg(gxemul, "Error: Could not write to " + filename
+			    + ".\n");
 			return false;
 		}
-
-		SerializationContext context;
-		component->Serialize(outputstream, context);
 	}
 
 	// Check that the file exists:
@@ -143,6 +142,10 @@ string SaveCommand::GetLongDescription() const
 	    "\n"
 	    "The filename extension should usually be .gxemul.\n"
 	    "\n"
+	    "The file is written in a binary format. RAM contents are stored so that\n"
+	    "they can be mapped directly from the file when it is loaded, i.e. only the\n"
+	    "parts of RAM that are actually used are read from the file.\n"
+	    "\n"
 	    "See also:  load    (to load an emulation setup)\n";
 }
 
@@ -335,19 +335,16 @@ bool FileLoader_ELF::LoadIntoComponent(refcount_ptr<Component> component, ostrea
 			int bytesReadThisTime = file.gcount();
 			bytesRead += bytesReadThisTime;
 
-			// Write to the bus, one byte at a time.
-			for (int k=0; k<bytesReadThisTime; ++k) {
-				bus->AddressSelect(vaddrToWriteTo);
-				if (!bus->WriteData(databuf[k])) {
-					messages.flags(std::ios::hex);
-					messages << "Failed to write data to "
-					    "virtual address 0x"
-					    << vaddrToWriteTo << "\n";
-					return false;
-				}
-
-				++ vaddrToWriteTo;
+			if (!bus->WriteBlock(vaddrToWriteTo,
+			    (const uint8_t*) databuf, bytesReadThisTime)) {
+				messages.flags(std::ios::hex);
+				messages << "Failed to write data to "
+				    "virtual address 0x"
+				    << vaddrToWriteTo << "\n";
+				return false;
 			}
+
+			vaddrToWriteTo += bytesReadThisTime;
 		}
 	}
 
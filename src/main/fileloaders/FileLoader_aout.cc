@@ -222,19 +222,15 @@ bool FileLoader_aout::LoadIntoComponent(refcount_ptr<Component> component, ostre
 		if (len < 1)
 			break;
 
-		// Write to the bus, one byte at a time.
-		for (int k=0; k<len; ++k) {
-			bus->AddressSelect(vaddr);
-			if (!bus->WriteData(buf[k])) {
-				messages.flags(std::ios::hex);
-				messages << "Failed to write data to virtual "
-				    "address 0x" << vaddr << "\n";
-				return false;
-			}
-			
-			++ vaddr;
+		if (!bus->WriteBlock(vaddr, buf, len)) {
+			messages.flags(std::ios::hex);
+			messages << "Failed to write data to virtual "
+			    "address 0x" << vaddr << "\n";
+			return false;
 		}
 
+		vaddr += len;
+
 		total_len -= len;
 	}
 
@@ -152,17 +152,12 @@ bool FileLoader_raw::LoadIntoComponent(refcount_ptr<Component> component, ostrea
 	messages.flags(std::ios::dec);
 	messages << ", " << totalSize << " bytes\n";
 
-	// Write to the bus, one byte at a time.
-	for (size_t k=0; k<(size_t)totalSize; ++k) {
-		bus->AddressSelect(vaddr);
-		if (!bus->WriteData(data[k])) {
-			messages.flags(std::ios::hex);
-			messages << "Failed to write data to "
-			    "virtual address 0x" << vaddr << "\n";
-			return false;
-		}
-
-		++ vaddr;
+	if (totalSize > 0 &&
+	    !bus->WriteBlock(vaddr, (const uint8_t*) &data[0], totalSize)) {
+		messages.flags(std::ios::hex);
+		messages << "Failed to write data to "
+		    "virtual address 0x" << vaddr << "\n";
+		return false;
 	}
 
 	// Set the CPU's entry point.
@@ -393,6 +393,19 @@ void emul_machine_setup(struct machine *m, int n_load, char **load_names,
 		memory_amount += 1048576 * m->memory_offset_in_mb;
 	}
 	m->memory = memory_new(memory_amount, m->arch);
+	if (m->merge_identical_pages) {
+		debug(", mergeable");
+		m->memory->merge_identical_pages = 1;
+	}
+	if (m->memory_filename != NULL) {
+		debug(", %s mapping of '%s'", m->memory_file_private?
+		    "private" : "shared", m->memory_filename);
+		memory_map_file(m->memory, m->memory_filename,
+		    m->memory_file_private);
+	} else if (m->contiguous_ram) {
+		debug(", contiguous");
+		memory_reserve_contiguous(m->memory);
+	}
 	debug("\n");
 
 	/*  Create CPUs:  */
@@ -217,6 +217,9 @@ static char cur_machine_use_x11[10];
 static char cur_machine_x11_scaledown[10];
 static char cur_machine_byte_order[20];
 static char cur_machine_random_mem[10];
+static char cur_machine_contiguous_ram[10];
+static char cur_machine_merge_pages[10];
+static char cur_machine_exact_fpu[10];
 static char cur_machine_random_cpu[10];
 static char cur_machine_force_netboot[10];
 static char cur_machine_start_paused[10];
@@ -224,7 +227,7 @@ static char cur_machine_ncpus[10];
 static char cur_machine_n_gfx_cards[10];
 static char cur_machine_serial_nr[10];
 static char cur_machine_emulated_hz[10];
-static char cur_machine_memory[10];
+static char cur_machine_memory[250];
 #define	MAX_N_LOAD		15
 #define	MAX_LOAD_LEN		2000
 static char *cur_machine_load[MAX_N_LOAD];
@@ -346,6 +349,9 @@ static void parse__emul(struct emul *e, FILE *f, int *in_emul, int *line,
 		cur_machine_x11_scaledown[0] = '\0';
 		cur_machine_byte_order[0] = '\0';
 		cur_machine_random_mem[0] = '\0';
+		cur_machine_contiguous_ram[0] = '\0';
+		cur_machine_merge_pages[0] = '\0';
+		cur_machine_exact_fpu[0] = '\0';
 		cur_machine_random_cpu[0] = '\0';
 		cur_machine_force_netboot[0] = '\0';
 		cur_machine_start_paused[0] = '\0';
@@ -485,6 +491,22 @@ static void parse__machine(struct emul *e, FILE *f, int *in_emul, int *line,
 		m->random_mem_contents =
 		    parse_on_off(cur_machine_random_mem);
 
+		if (!cur_machine_contiguous_ram[0])
+			strlcpy(cur_machine_contiguous_ram, "no",
+			    sizeof(cur_machine_contiguous_ram));
+		m->contiguous_ram = parse_on_off(cur_machine_contiguous_ram);
+
+		if (!cur_machine_exact_fpu[0])
+			strlcpy(cur_machine_exact_fpu, "no",
+			    sizeof(cur_machine_exact_fpu));
+		m->exact_fpu = parse_on_off(cur_machine_exact_fpu);
+
+		if (!cur_machine_merge_pages[0])
+			strlcpy(cur_machine_merge_pages, "no",
+			    sizeof(cur_machine_merge_pages));
+		m->merge_identical_pages =
+		    parse_on_off(cur_machine_merge_pages);
+
 		if (!cur_machine_random_cpu[0])
 			strlcpy(cur_machine_random_cpu, "no",
 			    sizeof(cur_machine_random_cpu));
@@ -538,7 +560,7 @@ static void parse__machine(struct emul *e, FILE *f, int *in_emul, int *line,
 		if (!cur_machine_memory[0])
 			strlcpy(cur_machine_memory, "0",
 			    sizeof(cur_machine_memory));
-		m->physical_ram_in_mb = atoi(cur_machine_memory);
+		machine_set_memory_string(m, cur_machine_memory);
 
 		if (!cur_machine_x11_scaledown[0])
 			m->x11_md.scaledown = 1;
@@ -608,6 +630,9 @@ static void parse__machine(struct emul *e, FILE *f, int *in_emul, int *line,
 	WORD("x11_scaledown", cur_machine_x11_scaledown);
 	WORD("byte_order", cur_machine_byte_order);
 	WORD("random_mem_contents", cur_machine_random_mem);
+	WORD("contiguous_ram", cur_machine_contiguous_ram);
+	WORD("merge_identical_pages", cur_machine_merge_pages);
+	WORD("exact_fpu", cur_machine_exact_fpu);
 	WORD("use_random_bootstrap_cpu", cur_machine_random_cpu);
 	WORD("force_netboot", cur_machine_force_netboot);
 	WORD("ncpus", cur_machine_ncpus);
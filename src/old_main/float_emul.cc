@@ -32,6 +32,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <fenv.h>
 
 #include "float_emul.h"
 #include "misc.h"
@@ -40,6 +41,38 @@
 /*  #define IEEE_DEBUG  */
 
 
+/*  The host's current rounding mode, as set by ieee_set_rounding_mode():  */
+static int ieee_current_rounding_mode = IEEE_ROUND_NEAREST;
+
+
+/*
+ *  ieee_set_rounding_mode():
+ *
+ *  Sets the host's floating point rounding mode, so that host FP operations
+ *  (and the conversion to single precision in ieee_store_float_value())
+ *  round the same way as the guest. Cheap if the mode is already set.
+ *
+ *  Callers which change the mode away from IEEE_ROUND_NEAREST should set it
+ *  back when done, since the rest of the emulator assumes the default mode.
+ */
+void ieee_set_rounding_mode(int mode)
+{
+	int host_mode = FE_TONEAREST;
+
+	if (mode == ieee_current_rounding_mode)
+		return;
+
+	switch (mode) {
+	case IEEE_ROUND_ZERO:	host_mode = FE_TOWARDZERO; break;
+	case IEEE_ROUND_UP:	host_mode = FE_UPWARD; break;
+	case IEEE_ROUND_DOWN:	host_mode = FE_DOWNWARD; break;
+	}
+
+	fesetround(host_mode);
+	ieee_current_rounding_mode = mode;
+}
+
+
 /*
  *  ieee_interpret_float_value():
  *
@@ -53,6 +86,33 @@ void ieee_interpret_float_value(uint64_t x, struct ieee_float_value *fvp,
 	int i, nan, sign = 0, exponent;
 	double fraction;
 
+	/*
+	 *  Fast path: Normalized numbers and zeroes are the same on the host
+	 *  (assuming that the host uses IEEE floats, which is the case for
+	 *  all supported hosts), so the bits can simply be reinterpreted.
+	 *  Denormals, infinities, and NaNs take the slow path below.
+	 */
+	if (fmt == IEEE_FMT_D) {
+		int e = (x >> 52) & 0x7ff;
+		if (e != 0x7ff && (e != 0 || (x & 0x000fffffffffffffULL) == 0)) {
+			double d;
+			memcpy(&d, &x, sizeof(d));
+			fvp->f = d;
+			fvp->nan = 0;
+			return;
+		}
+	} else if (fmt == IEEE_FMT_S) {
+		uint32_t x32 = x;
+		int e = (x32 >> 23) & 0xff;
+		if (e != 0xff && (e != 0 || (x32 & 0x007fffff) == 0)) {
+			float f;
+			memcpy(&f, &x32, sizeof(f));
+			fvp->f = f;
+			fvp->nan = 0;
+			return;
+		}
+	}
+
 	memset(fvp, 0, sizeof(struct ieee_float_value));
 
 	/*  n_frac and n_exp:  */
@@ -202,6 +262,28 @@ uint64_t ieee_store_float_value(double nf, int fmt, int nan)
 	if ((fmt == IEEE_FMT_S || fmt == IEEE_FMT_D) && nan)
 		goto store_nan;
 
+	/*
+	 *  Fast path: If the result is a normalized number or zero in the
+	 *  target format, then the host's representation can be used as is.
+	 *  Conversion to single precision uses the host's rounding mode (see
+	 *  ieee_set_rounding_mode()). Everything else takes the slow path.
+	 */
+	if (fmt == IEEE_FMT_D) {
+		int c = fpclassify(nf);
+		if (c == FP_NORMAL || c == FP_ZERO) {
+			memcpy(&r, &nf, sizeof(r));
+			return r;
+		}
+	} else if (fmt == IEEE_FMT_S) {
+		float f = nf;
+		int c = fpclassify(f);
+		if (c == FP_NORMAL || c == FP_ZERO) {
+			uint32_t r32;
+			memcpy(&r32, &f, sizeof(r32));
+			return r32;
+		}
+	}
+
 	/*  fraction:  */
 	switch (fmt) {
 	case IEEE_FMT_W:
@@ -298,3 +380,930 @@ store_nan:
 	return r;
 }
 
+
+
+/*
+ *  Software IEEE 754 arithmetic:
+ *
+ *  The following functions work directly on the binary representation of
+ *  single and double precision values (and 32-bit and 64-bit integers, for
+ *  conversions), using only integer arithmetic. Results are correctly
+ *  rounded in all four rounding modes, and exception flags (IEEE_FLAG_*)
+ *  are ORed into *flagsp, so they can be accumulated like a guest FPU's
+ *  sticky flags.
+ *
+ *  Values are unpacked into a sign, an unbiased exponent, and a 64-bit
+ *  significand with the leading one in bit 62, i.e. sig * 2^(exp - 62).
+ *  Bits below the precision of the result format are used for rounding,
+ *  and bits shifted out further down are "jammed" into the lowest bit.
+ *
+ *  NaN results are always a default NaN. Normally, NaNs with the most
+ *  significant fraction bit clear are signaling, and the default NaN is the
+ *  same as ieee_store_float_value() produces. With IEEE_LEGACY_NANS in the
+ *  rounding mode argument, the meaning of that bit is reversed, and the
+ *  default NaN is the legacy MIPS one (0x7fbfffff or 0x7ff7ffffffffffff).
+ *  Tininess is detected before rounding.
+ */
+
+struct ieee_format {
+	int		n_frac;
+	int		max_exp;
+	int		bias;
+	int		sign_bit;
+	uint64_t	default_nan;
+	uint64_t	legacy_nan;
+};
+
+static const struct ieee_format ieee_formats[IEEE_FMT_L + 1] = {
+	{  0,     0,    0,  0, 0, 0 },
+	{ 23,  0xff,  127, 31, 0x7fffffffULL,		/*  IEEE_FMT_S  */
+	    0x7fbfffffULL },
+	{ 52, 0x7ff, 1023, 63, 0x7fffffffffffffffULL,	/*  IEEE_FMT_D  */
+	    0x7ff7ffffffffffffULL },
+	{  0,     0,    0, 31, 0x7fffffffULL,		/*  IEEE_FMT_W  */
+	    0x7fffffffULL },
+	{  0,     0,    0, 63, 0x7fffffffffffffffULL,	/*  IEEE_FMT_L  */
+	    0x7fffffffffffffffULL },
+};
+
+#define	IEEE_CLASS_ZERO		0
+#define	IEEE_CLASS_FINITE	1
+#define	IEEE_CLASS_INF		2
+#define	IEEE_CLASS_NAN		3
+
+#define	IEEE_SIG_ONE		((uint64_t)1 << 62)
+
+struct ieee_unpacked {
+	int		cls;
+	int		sign;
+	int		exp;
+	uint64_t	sig;
+};
+
+
+static uint64_t ieee_shift_right_jam(uint64_t x, int n)
+{
+	if (n <= 0)
+		return x;
+	if (n >= 64)
+		return x != 0;
+	return (x >> n) | ((x << (64 - n)) != 0);
+}
+
+
+static void ieee_mul64(uint64_t a, uint64_t b, uint64_t *hip, uint64_t *lop)
+{
+#ifdef __SIZEOF_INT128__
+	unsigned __int128 p = (unsigned __int128)a * b;
+
+	*lop = (uint64_t)p;
+	*hip = (uint64_t)(p >> 64);
+#else
+	uint64_t a_lo = a & 0xffffffffULL, a_hi = a >> 32;
+	uint64_t b_lo = b & 0xffffffffULL, b_hi = b >> 32;
+	uint64_t p0 = a_lo * b_lo, p1 = a_lo * b_hi;
+	uint64_t p2 = a_hi * b_lo, p3 = a_hi * b_hi;
+	uint64_t mid = (p0 >> 32) + (p1 & 0xffffffffULL) + (p2 & 0xffffffffULL);
+
+	*lop = (p0 & 0xffffffffULL) | (mid << 32);
+	*hip = p3 + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+#endif
+}
+
+
+static uint64_t ieee_mulhi(uint64_t a, uint64_t b)
+{
+	uint64_t hi, lo;
+	ieee_mul64(a, b, &hi, &lo);
+	return hi;
+}
+
+
+/*
+ *  Initial approximations for division and square root: ieee_recip_table[i]
+ *  is 2^16 / b, and ieee_rsqrt_table[j - 64] is 2^16 / sqrt(s), for b and s
+ *  in the middle of [1 + i/256, 1 + (i+1)/256) and [j/64, (j+1)/64). These
+ *  are good to about 8 bits, and each Newton-Raphson iteration then doubles
+ *  the number of correct bits.
+ */
+static const uint16_t ieee_recip_table[256] = {
+	65408, 65154, 64902, 64652, 64404, 64158, 63913, 63671,
+	63430, 63191, 62954, 62719, 62485, 62253, 62023, 61795,
+	61568, 61343, 61119, 60897, 60677, 60458, 60241, 60026,
+	59812, 59599, 59388, 59179, 58971, 58764, 58559, 58356,
+	58153, 57952, 57753, 57555, 57358, 57163, 56968, 56776,
+	56584, 56394, 56205, 56017, 55831, 55646, 55462, 55279,
+	55098, 54917, 54738, 54560, 54383, 54207, 54033, 53859,
+	53687, 53516, 53346, 53177, 53009, 52842, 52676, 52511,
+	52347, 52184, 52022, 51862, 51702, 51543, 51385, 51228,
+	51072, 50917, 50763, 50610, 50458, 50306, 50156, 50007,
+	49858, 49710, 49563, 49417, 49272, 49128, 48985, 48842,
+	48700, 48559, 48419, 48280, 48141, 48003, 47867, 47730,
+	47595, 47460, 47326, 47193, 47061, 46929, 46798, 46668,
+	46539, 46410, 46282, 46155, 46028, 45902, 45777, 45652,
+	45528, 45405, 45283, 45161, 45040, 44919, 44799, 44680,
+	44561, 44443, 44326, 44209, 44093, 43977, 43862, 43748,
+	43634, 43521, 43408, 43296, 43185, 43074, 42963, 42854,
+	42744, 42636, 42528, 42420, 42313, 42207, 42101, 41996,
+	41891, 41786, 41683, 41579, 41476, 41374, 41272, 41171,
+	41070, 40970, 40870, 40771, 40672, 40574, 40476, 40378,
+	40281, 40185, 40089, 39993, 39898, 39804, 39709, 39616,
+	39522, 39429, 39337, 39245, 39153, 39062, 38971, 38881,
+	38791, 38702, 38613, 38524, 38436, 38348, 38260, 38173,
+	38087, 38000, 37915, 37829, 37744, 37659, 37575, 37491,
+	37407, 37324, 37241, 37159, 37077, 36995, 36914, 36833,
+	36752, 36672, 36592, 36512, 36433, 36354, 36275, 36197,
+	36119, 36041, 35964, 35887, 35810, 35734, 35658, 35583,
+	35507, 35432, 35358, 35283, 35209, 35136, 35062, 34989,
+	34916, 34844, 34771, 34700, 34628, 34557, 34486, 34415,
+	34344, 34274, 34204, 34135, 34065, 33996, 33928, 33859,
+	33791, 33723, 33655, 33588, 33521, 33454, 33387, 33321,
+	33255, 33189, 33124, 33059, 32994, 32929, 32864, 32800,
+};
+
+static const uint16_t ieee_rsqrt_table[192] = {
+	65281, 64781, 64292, 63814, 63347, 62889, 62442, 62004,
+	61575, 61154, 60742, 60339, 59943, 59555, 59175, 58801,
+	58435, 58075, 57722, 57376, 57035, 56700, 56372, 56049,
+	55731, 55419, 55112, 54810, 54513, 54221, 53933, 53650,
+	53371, 53097, 52826, 52560, 52298, 52040, 51785, 51535,
+	51288, 51044, 50804, 50567, 50333, 50103, 49876, 49652,
+	49430, 49212, 48997, 48784, 48574, 48367, 48163, 47961,
+	47761, 47564, 47370, 47178, 46988, 46800, 46615, 46432,
+	46251, 46072, 45895, 45720, 45547, 45376, 45207, 45040,
+	44875, 44711, 44550, 44390, 44232, 44075, 43920, 43767,
+	43615, 43465, 43316, 43169, 43024, 42879, 42737, 42595,
+	42456, 42317, 42180, 42044, 41910, 41776, 41644, 41514,
+	41384, 41256, 41129, 41003, 40878, 40754, 40631, 40510,
+	40390, 40270, 40152, 40035, 39919, 39803, 39689, 39576,
+	39464, 39352, 39242, 39133, 39024, 38916, 38810, 38704,
+	38599, 38494, 38391, 38289, 38187, 38086, 37986, 37887,
+	37788, 37690, 37593, 37497, 37401, 37307, 37213, 37119,
+	37027, 36935, 36843, 36753, 36663, 36573, 36485, 36397,
+	36309, 36222, 36136, 36051, 35966, 35882, 35798, 35715,
+	35632, 35550, 35469, 35388, 35307, 35228, 35148, 35070,
+	34991, 34914, 34837, 34760, 34684, 34608, 34533, 34458,
+	34384, 34310, 34237, 34164, 34092, 34020, 33949, 33878,
+	33807, 33737, 33668, 33599, 33530, 33461, 33393, 33326,
+	33259, 33192, 33126, 33060, 32994, 32929, 32864, 32800,
+};
+
+
+/*
+ *  ieee_newton_step():
+ *
+ *  Return y + y * d / 2^61, where d is a small two's complement value
+ *  (|d| < 2^60). d may be negative, when truncation in the calculation of d
+ *  has made y slightly too large.
+ */
+static uint64_t ieee_newton_step(uint64_t y, uint64_t d)
+{
+	if (d >> 63)
+		return y - ieee_mulhi(y, -d << 3);
+
+	return y + ieee_mulhi(y, d << 3);
+}
+
+
+/*
+ *  ieee_correct_estimate():
+ *
+ *  Given an estimate q, at most a few units off, of the quotient n / d (or of
+ *  the square root of n, if is_sqrt is set), where n is the 128-bit number
+ *  n_hi:n_lo, step q until it is the exact integer result. Returns q, with
+ *  the lowest bit set if the remainder is non-zero, to be used as a sticky
+ *  bit when rounding.
+ */
+static uint64_t ieee_correct_estimate(uint64_t q, uint64_t d, uint64_t n_hi,
+	uint64_t n_lo, int is_sqrt)
+{
+	uint64_t p_hi, p_lo, r_hi, r_lo, step;
+
+	ieee_mul64(q, is_sqrt? q : d, &p_hi, &p_lo);
+	r_lo = n_lo - p_lo;
+	r_hi = n_hi - p_hi - (n_lo < p_lo);
+
+	/*  Too large; the remainder is negative:  */
+	while (r_hi & ((uint64_t)1 << 63)) {
+		q --;
+		step = is_sqrt? 2 * q + 1 : d;
+		r_lo += step;
+		r_hi += (r_lo < step);
+	}
+
+	/*  Too small:  */
+	for (;;) {
+		step = is_sqrt? 2 * q + 1 : d;
+		if (r_hi == 0 && r_lo < step)
+			break;
+		r_hi -= (r_lo < step);
+		r_lo -= step;
+		q ++;
+	}
+
+	return q | (r_lo != 0);
+}
+
+
+static void ieee_unpack(uint64_t x, int fmt, struct ieee_unpacked *u)
+{
+	const struct ieee_format *f = &ieee_formats[fmt];
+	uint64_t frac;
+	int e;
+
+	if (fmt == IEEE_FMT_S)
+		x &= 0xffffffffULL;
+
+	frac = x & (((uint64_t)1 << f->n_frac) - 1);
+	e = (x >> f->n_frac) & f->max_exp;
+	u->sign = (x >> f->sign_bit) & 1;
+	u->exp = 0;
+	u->sig = 0;
+
+	if (e == f->max_exp) {
+		u->cls = frac? IEEE_CLASS_NAN : IEEE_CLASS_INF;
+		u->sig = frac;
+		return;
+	}
+
+	if (e == 0) {
+		if (frac == 0) {
+			u->cls = IEEE_CLASS_ZERO;
+			return;
+		}
+
+		/*  Denormal; normalize it:  */
+		u->sig = frac << (62 - f->n_frac);
+		u->exp = 1 - f->bias;
+		while (!(u->sig & IEEE_SIG_ONE)) {
+			u->sig <<= 1;
+			u->exp --;
+		}
+	} else {
+		u->sig = (frac | ((uint64_t)1 << f->n_frac)) << (62 - f->n_frac);
+		u->exp = e - f->bias;
+	}
+
+	u->cls = IEEE_CLASS_FINITE;
+}
+
+
+static uint64_t ieee_pack_special(int sign, int cls, int fmt)
+{
+	const struct ieee_format *f = &ieee_formats[fmt];
+	uint64_t r = (uint64_t)sign << f->sign_bit;
+
+	if (cls == IEEE_CLASS_INF)
+		r |= (uint64_t)f->max_exp << f->n_frac;
+
+	return r;
+}
+
+
+static uint64_t ieee_default_nan(int fmt, int rm)
+{
+	return rm & IEEE_LEGACY_NANS? ieee_formats[fmt].legacy_nan
+	    : ieee_formats[fmt].default_nan;
+}
+
+
+static int ieee_is_signaling(struct ieee_unpacked *u, int fmt, int rm)
+{
+	uint64_t msb = (uint64_t)1 << (ieee_formats[fmt].n_frac - 1);
+
+	if (u == NULL || u->cls != IEEE_CLASS_NAN)
+		return 0;
+
+	return (u->sig & msb)? (rm & IEEE_LEGACY_NANS) != 0
+	    : !(rm & IEEE_LEGACY_NANS);
+}
+
+
+/*
+ *  ieee_nan_result():
+ *
+ *  Return the default NaN, as the result of an operation on ua (and ub, if
+ *  non-NULL) where at least one of them is a NaN. Signaling NaNs make the
+ *  operation invalid.
+ */
+static uint64_t ieee_nan_result(struct ieee_unpacked *ua,
+	struct ieee_unpacked *ub, int fmt, int rm, int *flagsp)
+{
+	if (ieee_is_signaling(ua, fmt, rm) || ieee_is_signaling(ub, fmt, rm))
+		*flagsp |= IEEE_FLAG_INVALID;
+
+	return ieee_default_nan(fmt, rm);
+}
+
+
+/*
+ *  ieee_round_pack():
+ *
+ *  Round sig * 2^(exp - 62) to the format fmt, and return it in binary form.
+ */
+static uint64_t ieee_round_pack(int sign, int exp, uint64_t sig, int fmt,
+	int rm, int *flagsp)
+{
+	const struct ieee_format *f = &ieee_formats[fmt];
+	const int shift = 62 - f->n_frac;
+	const uint64_t mask = ((uint64_t)1 << shift) - 1;
+	const uint64_t half = (uint64_t)1 << (shift - 1);
+	uint64_t signbit = (uint64_t)sign << f->sign_bit;
+	uint64_t roundbits, r;
+	int e = exp + f->bias, tiny = 0;
+
+	rm &= IEEE_ROUND_MASK;
+
+	if (e >= f->max_exp)
+		goto overflow;
+
+	if (e <= 0) {
+		tiny = 1;
+		sig = ieee_shift_right_jam(sig, 1 - e);
+		e = 1;
+	}
+
+	roundbits = sig & mask;
+	if (roundbits != 0) {
+		*flagsp |= IEEE_FLAG_INEXACT;
+		if (tiny)
+			*flagsp |= IEEE_FLAG_UNDERFLOW;
+	}
+
+	switch (rm) {
+	case IEEE_ROUND_NEAREST:sig += half; break;
+	case IEEE_ROUND_UP:	sig += sign? 0 : mask; break;
+	case IEEE_ROUND_DOWN:	sig += sign? mask : 0; break;
+	}
+
+	r = sig >> shift;
+	if (rm == IEEE_ROUND_NEAREST && roundbits == half)
+		r &= ~(uint64_t)1;
+
+	/*  Adding (rather than ORing) lets a carry into the hidden bit
+	    increment the exponent:  */
+	r += (uint64_t)(e - 1) << f->n_frac;
+	if ((r >> f->n_frac) >= (uint64_t)f->max_exp)
+		goto overflow;
+
+	return signbit | r;
+
+overflow:
+	*flagsp |= IEEE_FLAG_OVERFLOW | IEEE_FLAG_INEXACT;
+	r = (uint64_t)f->max_exp << f->n_frac;
+	if (rm == IEEE_ROUND_ZERO || (rm == IEEE_ROUND_UP && sign) ||
+	    (rm == IEEE_ROUND_DOWN && !sign))
+		r --;	/*  largest finite number  */
+	return signbit | r;
+}
+
+
+/*
+ *  ieee_add(), ieee_sub(), ieee_mul(), ieee_div(), ieee_sqrt():
+ *
+ *  Basic arithmetic, in format fmt (IEEE_FMT_S or IEEE_FMT_D), with rounding
+ *  mode rm (IEEE_ROUND_*).
+ */
+static uint64_t ieee_add_sub(uint64_t a, uint64_t b, int fmt, int rm,
+	int *flagsp, int subtract)
+{
+	struct ieee_unpacked ua, ub, tmp;
+	uint64_t sig;
+	int exp;
+
+	ieee_unpack(a, fmt, &ua);
+	ieee_unpack(b, fmt, &ub);
+	ub.sign ^= subtract;
+
+	if (ua.cls == IEEE_CLASS_NAN || ub.cls == IEEE_CLASS_NAN)
+		return ieee_nan_result(&ua, &ub, fmt, rm, flagsp);
+
+	if (ua.cls == IEEE_CLASS_INF) {
+		if (ub.cls == IEEE_CLASS_INF && ua.sign != ub.sign) {
+			*flagsp |= IEEE_FLAG_INVALID;
+			return ieee_default_nan(fmt, rm);
+		}
+		return ieee_pack_special(ua.sign, IEEE_CLASS_INF, fmt);
+	}
+	if (ub.cls == IEEE_CLASS_INF)
+		return ieee_pack_special(ub.sign, IEEE_CLASS_INF, fmt);
+
+	if (ua.cls == IEEE_CLASS_ZERO && ub.cls == IEEE_CLASS_ZERO)
+		return ieee_pack_special(ua.sign == ub.sign? ua.sign :
+		    (rm & IEEE_ROUND_MASK) == IEEE_ROUND_DOWN,
+		    IEEE_CLASS_ZERO, fmt);
+	if (ua.cls == IEEE_CLASS_ZERO)
+		return ieee_round_pack(ub.sign, ub.exp, ub.sig, fmt, rm, flagsp);
+	if (ub.cls == IEEE_CLASS_ZERO)
+		return ieee_round_pack(ua.sign, ua.exp, ua.sig, fmt, rm, flagsp);
+
+	/*  Make sure that |a| >= |b|:  */
+	if (ua.exp < ub.exp || (ua.exp == ub.exp && ua.sig < ub.sig)) {
+		tmp = ua; ua = ub; ub = tmp;
+	}
+
+	ub.sig = ieee_shift_right_jam(ub.sig, ua.exp - ub.exp);
+	exp = ua.exp;
+
+	if (ua.sign == ub.sign) {
+		sig = ua.sig + ub.sig;
+		if (sig & ((uint64_t)1 << 63)) {
+			sig = ieee_shift_right_jam(sig, 1);
+			exp ++;
+		}
+	} else {
+		sig = ua.sig - ub.sig;
+		if (sig == 0)
+			return ieee_pack_special((rm & IEEE_ROUND_MASK) ==
+			    IEEE_ROUND_DOWN, IEEE_CLASS_ZERO, fmt);
+		while (!(sig & IEEE_SIG_ONE)) {
+			sig <<= 1;
+			exp --;
+		}
+	}
+
+	return ieee_round_pack(ua.sign, exp, sig, fmt, rm, flagsp);
+}
+
+uint64_t ieee_add(uint64_t a, uint64_t b, int fmt, int rm, int *flagsp)
+{
+	return ieee_add_sub(a, b, fmt, rm, flagsp, 0);
+}
+
+uint64_t ieee_sub(uint64_t a, uint64_t b, int fmt, int rm, int *flagsp)
+{
+	return ieee_add_sub(a, b, fmt, rm, flagsp, 1);
+}
+
+uint64_t ieee_mul(uint64_t a, uint64_t b, int fmt, int rm, int *flagsp)
+{
+	struct ieee_unpacked ua, ub;
+	uint64_t hi, lo, sig;
+	int sign, exp;
+
+	ieee_unpack(a, fmt, &ua);
+	ieee_unpack(b, fmt, &ub);
+	sign = ua.sign ^ ub.sign;
+
+	if (ua.cls == IEEE_CLASS_NAN || ub.cls == IEEE_CLASS_NAN)
+		return ieee_nan_result(&ua, &ub, fmt, rm, flagsp);
+
+	if (ua.cls == IEEE_CLASS_INF || ub.cls == IEEE_CLASS_INF) {
+		if (ua.cls == IEEE_CLASS_ZERO || ub.cls == IEEE_CLASS_ZERO) {
+			*flagsp |= IEEE_FLAG_INVALID;
+			return ieee_default_nan(fmt, rm);
+		}
+		return ieee_pack_special(sign, IEEE_CLASS_INF, fmt);
+	}
+
+	if (ua.cls == IEEE_CLASS_ZERO || ub.cls == IEEE_CLASS_ZERO)
+		return ieee_pack_special(sign, IEEE_CLASS_ZERO, fmt);
+
+	/*  The 126-bit product has its leading one in bit 124 or 125:  */
+	ieee_mul64(ua.sig, ub.sig, &hi, &lo);
+	exp = ua.exp + ub.exp;
+	if (hi & ((uint64_t)1 << 61)) {
+		sig = (hi << 1) | (lo >> 63) | ((lo << 1) != 0);
+		exp ++;
+	} else
+		sig = (hi << 2) | (lo >> 62) | ((lo << 2) != 0);
+
+	return ieee_round_pack(sign, exp, sig, fmt, rm, flagsp);
+}
+
+uint64_t ieee_div(uint64_t a, uint64_t b, int fmt, int rm, int *flagsp)
+{
+	struct ieee_unpacked ua, ub;
+	uint64_t a_sig, y, d;
+	int i, sign, exp;
+
+	ieee_unpack(a, fmt, &ua);
+	ieee_unpack(b, fmt, &ub);
+	sign = ua.sign ^ ub.sign;
+
+	if (ua.cls == IEEE_CLASS_NAN || ub.cls == IEEE_CLASS_NAN)
+		return ieee_nan_result(&ua, &ub, fmt, rm, flagsp);
+
+	if (ua.cls == IEEE_CLASS_INF) {
+		if (ub.cls == IEEE_CLASS_INF) {
+			*flagsp |= IEEE_FLAG_INVALID;
+			return ieee_default_nan(fmt, rm);
+		}
+		return ieee_pack_special(sign, IEEE_CLASS_INF, fmt);
+	}
+	if (ub.cls == IEEE_CLASS_INF)
+		return ieee_pack_special(sign, IEEE_CLASS_ZERO, fmt);
+
+	if (ub.cls == IEEE_CLASS_ZERO) {
+		if (ua.cls == IEEE_CLASS_ZERO) {
+			*flagsp |= IEEE_FLAG_INVALID;
+			return ieee_default_nan(fmt, rm);
+		}
+		*flagsp |= IEEE_FLAG_DIVBYZERO;
+		return ieee_pack_special(sign, IEEE_CLASS_INF, fmt);
+	}
+	if (ua.cls == IEEE_CLASS_ZERO)
+		return ieee_pack_special(sign, IEEE_CLASS_ZERO, fmt);
+
+	/*  The quotient is a_sig * 2^62 / ub.sig, in [2^62, 2^63):  */
+	exp = ua.exp - ub.exp;
+	a_sig = ua.sig;
+	if (a_sig < ub.sig) {
+		a_sig <<= 1;
+		exp --;
+	}
+
+	/*
+	 *  y approximates 2^125 / ub.sig, i.e. y / 2^63 = 1 / b where b is the
+	 *  divisor in [1,2). Newton-Raphson: y' = y + y * (1 - b * y).
+	 */
+	y = (uint64_t)ieee_recip_table[(ub.sig >> 54) & 0xff] << 47;
+	for (i=0; i<3; i++) {
+		d = ((uint64_t)1 << 61) - ieee_mulhi(ub.sig, y);
+		y = ieee_newton_step(y, d);
+	}
+
+	return ieee_round_pack(sign, exp, ieee_correct_estimate(
+	    ieee_mulhi(a_sig, y) << 1, ub.sig, a_sig >> 2, a_sig << 62, 0),
+	    fmt, rm, flagsp);
+}
+
+uint64_t ieee_sqrt(uint64_t a, int fmt, int rm, int *flagsp)
+{
+	struct ieee_unpacked ua;
+	uint64_t r_hi, r_lo, s, z, d, root;
+	int i, exp;
+
+	ieee_unpack(a, fmt, &ua);
+
+	if (ua.cls == IEEE_CLASS_NAN)
+		return ieee_nan_result(&ua, NULL, fmt, rm, flagsp);
+	if (ua.cls == IEEE_CLASS_ZERO)
+		return ieee_pack_special(ua.sign, IEEE_CLASS_ZERO, fmt);
+	if (ua.sign) {
+		*flagsp |= IEEE_FLAG_INVALID;
+		return ieee_default_nan(fmt, rm);
+	}
+	if (ua.cls == IEEE_CLASS_INF)
+		return ieee_pack_special(0, IEEE_CLASS_INF, fmt);
+
+	/*
+	 *  The radicand is sig << 62 (or << 63, if the exponent is odd), so
+	 *  that its integer square root has the leading one in bit 62:
+	 */
+	exp = ua.exp;
+	if (exp & 1) {
+		r_hi = ua.sig >> 1; r_lo = ua.sig << 63;
+		exp --;
+	} else {
+		r_hi = ua.sig >> 2; r_lo = ua.sig << 62;
+	}
+
+	/*
+	 *  s is the top 64 bits of the radicand, s / 2^62 in [1,4), and z
+	 *  approximates 2^63 / sqrt(s / 2^62). Newton-Raphson for the
+	 *  reciprocal square root: z' = z + z * (1 - s * z^2) / 2.
+	 */
+	s = (r_hi << 2) | (r_lo >> 62);
+	z = (uint64_t)ieee_rsqrt_table[(s >> 56) - 64] << 47;
+	for (i=0; i<3; i++) {
+		d = ((uint64_t)1 << 60) - ieee_mulhi(s, ieee_mulhi(z, z));
+		z = ieee_newton_step(z, d);
+	}
+
+	/*  sqrt(s) = s / sqrt(s), which is less than 2^63:  */
+	root = ieee_mulhi(s, z) << 1;
+	if (root >> 63)
+		root = ((uint64_t)1 << 63) - 1;
+
+	return ieee_round_pack(0, exp / 2, ieee_correct_estimate(root, 0,
+	    r_hi, r_lo, 1), fmt, rm, flagsp);
+}
+
+
+/*
+ *  ieee_convert_to_int():
+ *
+ *  Convert an unpacked value to a 32-bit or 64-bit two's complement integer.
+ *  Values which don't fit (and NaNs) are invalid, and result in the largest
+ *  positive integer, like on MIPS.
+ */
+static uint64_t ieee_convert_to_int(struct ieee_unpacked *u, int to_fmt,
+	int rm, int *flagsp)
+{
+	int bits = to_fmt == IEEE_FMT_W? 32 : 64, shift;
+	uint64_t maxpos = ((uint64_t)1 << (bits - 1)) - 1;
+	uint64_t mask = bits == 32? 0xffffffffULL : (uint64_t) -1;
+	uint64_t i, roundbits, half, sig = u->sig;
+	int inc = 0;
+
+	if (u->cls == IEEE_CLASS_ZERO)
+		return 0;
+	if (u->cls != IEEE_CLASS_FINITE || u->exp >= bits)
+		goto invalid;
+
+	shift = 62 - u->exp;
+	if (shift < 0) {
+		/*  Only -2^63 is representable:  */
+		if (u->sign && sig == IEEE_SIG_ONE)
+			return (uint64_t)1 << 63;
+		goto invalid;
+	}
+
+	if (shift > 64) {
+		sig = 1;
+		shift = 64;
+	}
+
+	if (shift == 64) {
+		i = 0;
+		roundbits = sig;
+		half = (uint64_t)1 << 63;
+	} else if (shift == 0) {
+		i = sig;
+		roundbits = half = 0;
+	} else {
+		i = sig >> shift;
+		roundbits = sig & (((uint64_t)1 << shift) - 1);
+		half = (uint64_t)1 << (shift - 1);
+	}
+
+	if (roundbits != 0) {
+		switch (rm & IEEE_ROUND_MASK) {
+		case IEEE_ROUND_NEAREST:
+			inc = roundbits > half || (roundbits == half && (i & 1));
+			break;
+		case IEEE_ROUND_UP:	inc = !u->sign; break;
+		case IEEE_ROUND_DOWN:	inc = u->sign; break;
+		}
+	}
+	i += inc;
+
+	if (i > maxpos + u->sign)
+		goto invalid;
+
+	if (roundbits != 0)
+		*flagsp |= IEEE_FLAG_INEXACT;
+
+	return (u->sign? -i : i) & mask;
+
+invalid:
+	*flagsp |= IEEE_FLAG_INVALID;
+	return maxpos;
+}
+
+
+/*
+ *  ieee_convert():
+ *
+ *  Convert a value between any two of the IEEE_FMT_* formats.
+ */
+uint64_t ieee_convert(uint64_t a, int from_fmt, int to_fmt, int rm,
+	int *flagsp)
+{
+	struct ieee_unpacked u;
+
+	if (from_fmt == IEEE_FMT_W || from_fmt == IEEE_FMT_L) {
+		int64_t v = from_fmt == IEEE_FMT_W? (int64_t)(int32_t)a
+		    : (int64_t)a;
+		uint64_t mag = v < 0? -(uint64_t)v : (uint64_t)v;
+
+		u.sign = v < 0;
+		if (mag == 0) {
+			u.cls = IEEE_CLASS_ZERO;
+		} else {
+			u.cls = IEEE_CLASS_FINITE;
+			u.exp = 62;
+			if (mag & ((uint64_t)1 << 63)) {
+				mag = ieee_shift_right_jam(mag, 1);
+				u.exp = 63;
+			}
+			while (!(mag & IEEE_SIG_ONE)) {
+				mag <<= 1;
+				u.exp --;
+			}
+			u.sig = mag;
+		}
+	} else
+		ieee_unpack(a, from_fmt, &u);
+
+	if (to_fmt == IEEE_FMT_W || to_fmt == IEEE_FMT_L)
+		return ieee_convert_to_int(&u, to_fmt, rm, flagsp);
+
+	if (u.cls == IEEE_CLASS_NAN) {
+		ieee_nan_result(&u, NULL, from_fmt, rm, flagsp);
+		return ieee_default_nan(to_fmt, rm);
+	}
+	if (u.cls != IEEE_CLASS_FINITE)
+		return ieee_pack_special(u.sign, u.cls, to_fmt);
+
+	return ieee_round_pack(u.sign, u.exp, u.sig, to_fmt, rm, flagsp);
+}
+
+
+/*
+ *  ieee_compare():
+ *
+ *  Compare two values, and return IEEE_CMP_LESS, _EQUAL, _GREATER, or
+ *  _UNORDERED (if either is a NaN). If signaling is non-zero, comparing
+ *  any NaN is an invalid operation, otherwise only signaling NaNs are.
+ *  (Only the IEEE_LEGACY_NANS bit of rm is used.)
+ */
+int ieee_compare(uint64_t a, uint64_t b, int fmt, int signaling, int rm,
+	int *flagsp)
+{
+	const struct ieee_format *f = &ieee_formats[fmt];
+	uint64_t signbit = (uint64_t)1 << f->sign_bit;
+	struct ieee_unpacked ua, ub;
+
+	ieee_unpack(a, fmt, &ua);
+	ieee_unpack(b, fmt, &ub);
+
+	if (ua.cls == IEEE_CLASS_NAN || ub.cls == IEEE_CLASS_NAN) {
+		if (signaling)
+			*flagsp |= IEEE_FLAG_INVALID;
+		else
+			ieee_nan_result(&ua, &ub, fmt, rm, flagsp);
+		return IEEE_CMP_UNORDERED;
+	}
+
+	if (ua.cls == IEEE_CLASS_ZERO && ub.cls == IEEE_CLASS_ZERO)
+		return IEEE_CMP_EQUAL;
+
+	if (fmt == IEEE_FMT_S) {
+		a &= 0xffffffffULL;
+		b &= 0xffffffffULL;
+	}
+
+	if (a == b)
+		return IEEE_CMP_EQUAL;
+
+	/*  Sign-magnitude ordering of the binary representations:  */
+	if (ua.sign != ub.sign)
+		return ua.sign? IEEE_CMP_LESS : IEEE_CMP_GREATER;
+	if ((a & ~signbit) < (b & ~signbit))
+		return ua.sign? IEEE_CMP_GREATER : IEEE_CMP_LESS;
+	return ua.sign? IEEE_CMP_LESS : IEEE_CMP_GREATER;
+}
+
+
+/*****************************************************************************/
+
+
+#ifdef WITHUNITTESTS
+
+#include "UnitTest.h"
+
+static void Test_float_emul_Div_RoundingModes()
+{
+	int flags = 0;
+
+	/*  1/3 and -1/3 in single precision:  */
+	UnitTest::Assert("S 1/3 nearest", ieee_div(0x3f800000, 0x40400000,
+	    IEEE_FMT_S, IEEE_ROUND_NEAREST, &flags), 0x3eaaaaab);
+	UnitTest::Assert("S 1/3 zero", ieee_div(0x3f800000, 0x40400000,
+	    IEEE_FMT_S, IEEE_ROUND_ZERO, &flags), 0x3eaaaaaa);
+	UnitTest::Assert("S 1/3 up", ieee_div(0x3f800000, 0x40400000,
+	    IEEE_FMT_S, IEEE_ROUND_UP, &flags), 0x3eaaaaab);
+	UnitTest::Assert("S 1/3 down", ieee_div(0x3f800000, 0x40400000,
+	    IEEE_FMT_S, IEEE_ROUND_DOWN, &flags), 0x3eaaaaaa);
+	UnitTest::Assert("S -1/3 up", ieee_div(0xbf800000, 0x40400000,
+	    IEEE_FMT_S, IEEE_ROUND_UP, &flags), 0xbeaaaaaa);
+	UnitTest::Assert("S -1/3 down", ieee_div(0xbf800000, 0x40400000,
+	    IEEE_FMT_S, IEEE_ROUND_DOWN, &flags), 0xbeaaaaab);
+	UnitTest::Assert("1/3 should be inexact", flags, IEEE_FLAG_INEXACT);
+
+	/*  ... and in double precision:  */
+	UnitTest::Assert("D 1/3 nearest", ieee_div(0x3ff0000000000000ULL,
+	    0x4008000000000000ULL, IEEE_FMT_D, IEEE_ROUND_NEAREST, &flags),
+	    0x3fd5555555555555ULL);
+	UnitTest::Assert("D 1/3 zero", ieee_div(0x3ff0000000000000ULL,
+	    0x4008000000000000ULL, IEEE_FMT_D, IEEE_ROUND_ZERO, &flags),
+	    0x3fd5555555555555ULL);
+	UnitTest::Assert("D 1/3 up", ieee_div(0x3ff0000000000000ULL,
+	    0x4008000000000000ULL, IEEE_FMT_D, IEEE_ROUND_UP, &flags),
+	    0x3fd5555555555556ULL);
+	UnitTest::Assert("D 1/3 down", ieee_div(0x3ff0000000000000ULL,
+	    0x4008000000000000ULL, IEEE_FMT_D, IEEE_ROUND_DOWN, &flags),
+	    0x3fd5555555555555ULL);
+
+	flags = 0;
+	UnitTest::Assert("D 6/3", ieee_div(0x4018000000000000ULL,
+	    0x4008000000000000ULL, IEEE_FMT_D, IEEE_ROUND_NEAREST, &flags),
+	    0x4000000000000000ULL);
+	UnitTest::Assert("6/3 is exact", flags, 0);
+}
+
+static void Test_float_emul_Sqrt_RoundingModes()
+{
+	int flags = 0;
+
+	UnitTest::Assert("D sqrt(2) nearest", ieee_sqrt(0x4000000000000000ULL,
+	    IEEE_FMT_D, IEEE_ROUND_NEAREST, &flags), 0x3ff6a09e667f3bcdULL);
+	UnitTest::Assert("D sqrt(2) zero", ieee_sqrt(0x4000000000000000ULL,
+	    IEEE_FMT_D, IEEE_ROUND_ZERO, &flags), 0x3ff6a09e667f3bccULL);
+	UnitTest::Assert("D sqrt(2) up", ieee_sqrt(0x4000000000000000ULL,
+	    IEEE_FMT_D, IEEE_ROUND_UP, &flags), 0x3ff6a09e667f3bcdULL);
+	UnitTest::Assert("D sqrt(2) down", ieee_sqrt(0x4000000000000000ULL,
+	    IEEE_FMT_D, IEEE_ROUND_DOWN, &flags), 0x3ff6a09e667f3bccULL);
+	UnitTest::Assert("S sqrt(2) nearest", ieee_sqrt(0x40000000,
+	    IEEE_FMT_S, IEEE_ROUND_NEAREST, &flags), 0x3fb504f3);
+	UnitTest::Assert("S sqrt(2) up", ieee_sqrt(0x40000000,
+	    IEEE_FMT_S, IEEE_ROUND_UP, &flags), 0x3fb504f4);
+	UnitTest::Assert("sqrt(2) should be inexact", flags,
+	    IEEE_FLAG_INEXACT);
+
+	flags = 0;
+	UnitTest::Assert("S sqrt(4)", ieee_sqrt(0x40800000,
+	    IEEE_FMT_S, IEEE_ROUND_NEAREST, &flags), 0x40000000);
+	UnitTest::Assert("S sqrt(-0)", ieee_sqrt(0x80000000,
+	    IEEE_FMT_S, IEEE_ROUND_NEAREST, &flags), 0x80000000);
+	UnitTest::Assert("D sqrt of the smallest denormal",
+	    ieee_sqrt(1, IEEE_FMT_D, IEEE_ROUND_NEAREST, &flags),
+	    0x1e60000000000000ULL);
+	UnitTest::Assert("these square roots are exact", flags, 0);
+}
+
+static void Test_float_emul_Div_Flags()
+{
+	int flags = 0;
+
+	UnitTest::Assert("1/0", ieee_div(0x3f800000, 0x00000000,
+	    IEEE_FMT_S, IEEE_ROUND_NEAREST, &flags), 0x7f800000);
+	UnitTest::Assert("1/0 should divide by zero", flags,
+	    IEEE_FLAG_DIVBYZERO);
+
+	flags = 0;
+	UnitTest::Assert("max/0.5 nearest", ieee_div(0x7f7fffff, 0x3f000000,
+	    IEEE_FMT_S, IEEE_ROUND_NEAREST, &flags), 0x7f800000);
+	UnitTest::Assert("max/0.5 should overflow", flags,
+	    IEEE_FLAG_OVERFLOW | IEEE_FLAG_INEXACT);
+	UnitTest::Assert("max/0.5 zero", ieee_div(0x7f7fffff, 0x3f000000,
+	    IEEE_FMT_S, IEEE_ROUND_ZERO, &flags), 0x7f7fffff);
+
+	flags = 0;
+	UnitTest::Assert("tiny/4", ieee_div(0x00800001, 0x40800000,
+	    IEEE_FMT_S, IEEE_ROUND_NEAREST, &flags), 0x00200000);
+	UnitTest::Assert("tiny/4 should underflow", flags,
+	    IEEE_FLAG_UNDERFLOW | IEEE_FLAG_INEXACT);
+
+	flags = 0;
+	UnitTest::Assert("0/0", ieee_div(0, 0, IEEE_FMT_D,
+	    IEEE_ROUND_NEAREST, &flags), 0x7fffffffffffffffULL);
+	UnitTest::Assert("0/0 should be invalid", flags, IEEE_FLAG_INVALID);
+
+	flags = 0;
+	UnitTest::Assert("sqrt(-1)", ieee_sqrt(0xbf800000, IEEE_FMT_S,
+	    IEEE_ROUND_NEAREST, &flags), 0x7fffffff);
+	UnitTest::Assert("sqrt(-1) should be invalid", flags,
+	    IEEE_FLAG_INVALID);
+}
+
+static void Test_float_emul_NaNs()
+{
+	int legacy = IEEE_ROUND_NEAREST | IEEE_LEGACY_NANS;
+	int flags = 0;
+
+	/*  Legacy MIPS: a set top fraction bit means signaling.  */
+	UnitTest::Assert("legacy quiet NaN / 1", ieee_div(0x7fbfffff,
+	    0x3f800000, IEEE_FMT_S, legacy, &flags), 0x7fbfffff);
+	UnitTest::Assert("1 + legacy quiet NaN", ieee_add(0x3ff0000000000000ULL,
+	    0x7ff0000000000001ULL, IEEE_FMT_D, legacy, &flags),
+	    0x7ff7ffffffffffffULL);
+	UnitTest::Assert("legacy compare with a quiet NaN",
+	    ieee_compare(0x7fbfffff, 0x3f800000, IEEE_FMT_S, 0, legacy,
+	    &flags), IEEE_CMP_UNORDERED);
+	UnitTest::Assert("quiet NaNs should not be invalid", flags, 0);
+
+	UnitTest::Assert("legacy signaling NaN / 1", ieee_div(0x7fc00000,
+	    0x3f800000, IEEE_FMT_S, legacy, &flags), 0x7fbfffff);
+	UnitTest::Assert("signaling NaNs should be invalid", flags,
+	    IEEE_FLAG_INVALID);
+
+	flags = 0;
+	UnitTest::Assert("legacy sqrt(-1)", ieee_sqrt(0xbff0000000000000ULL,
+	    IEEE_FMT_D, legacy, &flags), 0x7ff7ffffffffffffULL);
+	UnitTest::Assert("legacy sqrt(-1) should be invalid", flags,
+	    IEEE_FLAG_INVALID);
+
+	/*  IEEE 754-2008 polarity: a set top fraction bit means quiet.  */
+	flags = 0;
+	UnitTest::Assert("quiet NaN * 2", ieee_mul(0x7fc00000, 0x40000000,
+	    IEEE_FMT_S, IEEE_ROUND_NEAREST, &flags), 0x7fffffff);
+	UnitTest::Assert("the quiet NaN should not be invalid", flags, 0);
+
+	UnitTest::Assert("signaling NaN * 2", ieee_mul(0x7fbfffff, 0x40000000,
+	    IEEE_FMT_S, IEEE_ROUND_NEAREST, &flags), 0x7fffffff);
+	UnitTest::Assert("the signaling NaN should be invalid", flags,
+	    IEEE_FLAG_INVALID);
+}
+
+UNITTESTS(float_emul)
+{
+	UNITTEST(Test_float_emul_Div_RoundingModes);
+	UNITTEST(Test_float_emul_Sqrt_RoundingModes);
+	UNITTEST(Test_float_emul_Div_Flags);
+	UNITTEST(Test_float_emul_NaNs);
+}
+
+#endif	// WITHUNITTESTS
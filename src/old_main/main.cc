@@ -291,6 +291,8 @@ static void usage(int longusage)
 	printf("                t      tape\n");
 	printf("                V      add an overlay\n");
 	printf("                0-7    force a specific ID\n");
+	printf("  -F        use bit-exact software floating point, with "
+	    "exception flags\n            (MIPS only, slower)\n");
 	printf("  -I hz     set the main cpu frequency to hz (not used by "
 	    "all combinations\n            of machines and guest OSes)\n");
 	printf("  -i        display each instruction as it is executed\n");
@@ -305,7 +307,15 @@ static void usage(int longusage)
 	printf("            For other emulation modes, if the boot disk is an"
 	    " ISO9660\n            filesystem, -j sets the name of the"
 	    " kernel to load.\n");
+	printf("  -L        reserve one contiguous host memory range for the"
+	    " emulated RAM\n            (using hugepages, if supported by"
+	    " the host)\n");
 	printf("  -M m      emulate m MBs of physical RAM\n");
+	printf("  -M m@f    emulate m MBs of physical RAM, stored in the file f"
+	    "\n            (use m@@f to map the file copy-on-write, leaving "
+	    "it unmodified)\n");
+	printf("  -m        let the host merge identical pages of emulated"
+	    " RAM (e.g. Linux KSM)\n");
 	printf("  -N        display nr of instructions/second average, at"
 	    " regular intervals\n");
 	printf("  -n nr     set nr of CPUs (for SMP experiments)\n");
@@ -399,7 +409,7 @@ int get_cmd_args(int argc, char *argv[], struct emul *emul,
 	struct machine *m = emul_add_machine(emul, NULL);
 
 	const char *opts =
-	    "BC:c:Dd:E:e:HhI:iJj:k:KM:Nn:Oo:p:QqRrSs:TtUVvW:"
+	    "BC:c:Dd:E:e:FHhI:iJj:k:KLM:mNn:Oo:p:QqRrSs:TtUVvW:"
 #ifdef WITH_X11
 	    "XxY:"
 #endif
@@ -452,6 +462,10 @@ int get_cmd_args(int argc, char *argv[], struct emul *emul,
 			subtype = optarg;
 			msopts = 1;
 			break;
+		case 'F':
+			m->exact_fpu = 1;
+			msopts = 1;
+			break;
 		case 'H':
 			GXemul::ListTemplates();
 			printf("--------------------------------------------------------------------------\n\n");
@@ -489,8 +503,16 @@ int get_cmd_args(int argc, char *argv[], struct emul *emul,
 		case 'K':
 			force_debugger_at_exit = 1;
 			break;
+		case 'L':
+			m->contiguous_ram = 1;
+			msopts = 1;
+			break;
 		case 'M':
-			m->physical_ram_in_mb = atoi(optarg);
+			machine_set_memory_string(m, optarg);
+			msopts = 1;
+			break;
+		case 'm':
+			m->merge_identical_pages = 1;
 			msopts = 1;
 			break;
 		case 'N':
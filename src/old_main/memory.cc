@@ -31,8 +31,11 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <sys/types.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "cpu.h"
 #include "machine.h"
@@ -142,6 +145,13 @@ void *zeroed_alloc(size_t s)
  *
  *  This function creates a new memory object. An emulated machine needs one
  *  of these.
+ *
+ *  If merge_identical_pages is set in the memory object (before anything
+ *  is written to it), then all RAM is madvise()d as MADV_MERGEABLE. On hosts
+ *  which support it (e.g. Linux with KSM enabled), identical pages are then
+ *  merged copy-on-write by the host, both within one machine and across
+ *  machines (and emulator processes). This helps a lot when running many
+ *  machines with the same kernel and disk images.
  */
 struct memory *memory_new(uint64_t physical_max, int arch)
 {
@@ -164,6 +174,7 @@ struct memory *memory_new(uint64_t physical_max, int arch)
 
 	mem->physical_max = physical_max;
 	mem->dev_dyntrans_alignment = 4095;
+	mem->hash_tree_client = -1;
 
 	s = entries_per_pagetable * sizeof(void *);
 
@@ -181,6 +192,142 @@ struct memory *memory_new(uint64_t physical_max, int arch)
 }
 
 
+/*
+ *  memory_reserve_contiguous():
+ *
+ *  Reserve one contiguous range of host virtual memory, covering all of the
+ *  emulated physical RAM (i.e. 0 up to physical_max). Host pages are still
+ *  only allocated when first written to, but translating a physical address
+ *  into a host address then becomes a simple addition. On hosts which
+ *  support it, transparent hugepages are requested for the range, to reduce
+ *  the number of host TLB misses for guests with lots of RAM.
+ *
+ *  This must be called before anything is written to the memory.
+ */
+void memory_reserve_contiguous(struct memory *mem)
+{
+	const size_t memblock_mask = (1 << BITS_PER_MEMBLOCK) - 1;
+	const size_t hugepage_mask = 2 * 1048576 - 1;
+	int flags = MAP_ANON | MAP_PRIVATE;
+	size_t s, alloclen;
+	unsigned char *p;
+
+	if (mem->physical_max == 0)
+		return;
+
+	if (sizeof(size_t) < sizeof(uint64_t) &&
+	    mem->physical_max > (size_t) -1 / 2) {
+		fatal("memory_reserve_contiguous(): too much RAM for"
+		    " a 32-bit host\n");
+		exit(1);
+	}
+
+#ifdef MAP_NORESERVE
+	flags |= MAP_NORESERVE;
+#endif
+
+	/*  Round up to whole memblocks, and reserve enough extra space to
+	    be able to align the start of the range to a hugepage boundary:  */
+	s = ((mem->physical_max - 1) | memblock_mask) + 1;
+	alloclen = s + hugepage_mask + 1;
+
+	p = (unsigned char *) mmap(NULL, alloclen, PROT_READ | PROT_WRITE,
+	    flags, -1, 0);
+	if (p == NULL || p == (unsigned char *) MAP_FAILED) {
+		fatal("memory_reserve_contiguous(): could not reserve %lli MB"
+		    " of host address space\n", (long long) (s >> 20));
+		exit(1);
+	}
+
+	p = (unsigned char *) (((size_t)p + hugepage_mask) & ~hugepage_mask);
+
+	/*  (Hugepages cannot be merged, so merging takes precedence.)  */
+#ifdef MADV_MERGEABLE
+	if (mem->merge_identical_pages)
+		madvise(p, s, MADV_MERGEABLE);
+#endif
+#ifdef MADV_HUGEPAGE
+	if (!mem->merge_identical_pages)
+		madvise(p, s, MADV_HUGEPAGE);
+#endif
+
+	mem->contiguous_base = p;
+	mem->contiguous_size = s;
+}
+
+
+/*
+ *  memory_map_file():
+ *
+ *  Back the emulated physical RAM with a host file. The file is mapped into
+ *  the contiguous RAM range (see memory_reserve_contiguous() above), so no
+ *  data is copied; pages are read from the file when they are first touched.
+ *
+ *  If private_mapping is zero, the mapping is shared, i.e. everything the
+ *  guest writes to RAM ends up in the file. (The file is extended to the
+ *  size of the RAM, if it was smaller.) Otherwise, the file is mapped
+ *  copy-on-write, and is never modified.
+ *
+ *  This must be called before anything is written to the memory.
+ */
+void memory_map_file(struct memory *mem, const char *filename,
+	int private_mapping)
+{
+	const size_t memblock_mask = (1 << BITS_PER_MEMBLOCK) - 1;
+	void **table;
+	struct stat st;
+	size_t len, entry;
+	int fd;
+
+	if (mem->contiguous_base == NULL)
+		memory_reserve_contiguous(mem);
+
+	fd = open(filename, private_mapping? O_RDONLY : (O_RDWR | O_CREAT),
+	    0644);
+	if (fd < 0) {
+		perror(filename);
+		exit(1);
+	}
+
+	if (fstat(fd, &st) != 0) {
+		perror(filename);
+		exit(1);
+	}
+
+	len = mem->contiguous_size;
+	if ((uint64_t) st.st_size < len) {
+		if (private_mapping)
+			len = st.st_size;
+		else if (ftruncate(fd, len) != 0) {
+			perror(filename);
+			exit(1);
+		}
+	}
+
+	if (len > 0 && mmap(mem->contiguous_base, len, PROT_READ | PROT_WRITE,
+	    MAP_FIXED | (private_mapping? MAP_PRIVATE : MAP_SHARED), fd, 0)
+	    == MAP_FAILED) {
+		perror(filename);
+		exit(1);
+	}
+
+	close(fd);
+
+#ifdef MADV_MERGEABLE
+	/*  (Only pages of private mappings can be merged.)  */
+	if (mem->merge_identical_pages && private_mapping)
+		madvise(mem->contiguous_base, len, MADV_MERGEABLE);
+#endif
+
+	/*  All memblocks covered by the file are considered to be in use:  */
+	table = (void **) mem->pagetable;
+	for (entry = 0; entry < ((len + memblock_mask) >> BITS_PER_MEMBLOCK);
+	    entry ++)
+		table[entry] = mem->contiguous_base +
+		    (entry << BITS_PER_MEMBLOCK);
+}
+
+
 /*
  *  memory_points_to_string():
  *
@@ -331,6 +478,112 @@ void memory_device_update_data(struct memory *mem, void *extra,
 }
 
 
+/*
+ *  memory_devmap_free():
+ *
+ *  Free a device map table, and all tables below it.
+ */
+static void memory_devmap_free(size_t *table)
+{
+	int i;
+
+	for (i=0; i<(1 << DEVMAP_BITS_PER_LEVEL); i++)
+		if (table[i] != 0 && !(table[i] & DEVMAP_VALUE))
+			memory_devmap_free((size_t *) table[i]);
+
+	free(table);
+}
+
+
+/*
+ *  memory_devmap_new_table():
+ *
+ *  Allocate an empty device map table.
+ */
+static size_t *memory_devmap_new_table(void)
+{
+	size_t *table;
+	size_t s = sizeof(size_t) << DEVMAP_BITS_PER_LEVEL;
+
+	CHECK_ALLOCATION(table = (size_t *) malloc(s));
+	memset(table, 0, s);
+
+	return table;
+}
+
+
+/*
+ *  memory_devmap_insert():
+ *
+ *  Insert a value into all entries of a device map table that are covered
+ *  by the physical address range first..last (inclusive). Each entry of the
+ *  table covers (1 << shift) bytes.
+ */
+static void memory_devmap_insert(size_t *table, int shift,
+	uint64_t first, uint64_t last, size_t value)
+{
+	const uint64_t slot_mask = ((uint64_t)1 << shift) - 1;
+	const int index_mask = (1 << DEVMAP_BITS_PER_LEVEL) - 1;
+	uint64_t addr = first;
+
+	for (;;) {
+		size_t *entry = &table[(addr >> shift) & index_mask];
+		uint64_t slot_last = addr | slot_mask;
+		uint64_t part_last = last < slot_last? last : slot_last;
+
+		if ((addr & slot_mask) == 0 && part_last == slot_last) {
+			/*  The entire slot belongs to this device:  */
+			*entry = value;
+		} else if (shift == DEVMAP_PAGE_SHIFT) {
+			/*  A page which is only partially covered:  */
+			if (*entry == 0)
+				*entry = value | DEVMAP_PARTIAL;
+			else
+				*entry = DEVMAP_VALUE | DEVMAP_PARTIAL |
+				    DEVMAP_MULTIPLE;
+		} else {
+			if (*entry == 0)
+				*entry = (size_t) memory_devmap_new_table();
+			memory_devmap_insert((size_t *) *entry,
+			    shift - DEVMAP_BITS_PER_LEVEL, addr, part_last,
+			    value);
+		}
+
+		if (part_last == last)
+			break;
+		addr = part_last + 1;
+	}
+}
+
+
+/*
+ *  memory_devmap_rebuild():
+ *
+ *  Rebuild the physical page to device index map. This needs to be done
+ *  whenever a device is registered or removed, since that may change the
+ *  indices of other devices as well.
+ */
+static void memory_devmap_rebuild(struct memory *mem)
+{
+	int i;
+
+	if (mem->devmap != NULL)
+		memory_devmap_free(mem->devmap);
+
+	mem->devmap = memory_devmap_new_table();
+
+	for (i=0; i<mem->n_mmapped_devices; i++) {
+		if (mem->devices[i].length == 0)
+			continue;
+
+		memory_devmap_insert(mem->devmap, DEVMAP_PAGE_SHIFT +
+		    (DEVMAP_LEVELS - 1) * DEVMAP_BITS_PER_LEVEL,
+		    mem->devices[i].baseaddr, mem->devices[i].endaddr - 1,
+		    ((size_t)(i + 1) << DEVMAP_INDEX_SHIFT) | DEVMAP_VALUE);
+	}
+}
+
+
 /*
  *  memory_device_register():
  *
@@ -452,6 +705,8 @@ void memory_device_register(struct memory *mem, const char *device_name,
 
 	if (newi < mem->last_accessed_device)
 		mem->last_accessed_device ++;
+
+	memory_devmap_rebuild(mem);
 }
 
 
@@ -469,16 +724,16 @@ void memory_device_remove(struct memory *mem, int i)
 
 	mem->n_mmapped_devices --;
 
-	if (i == mem->n_mmapped_devices)
-		return;
-
-	memmove(&mem->devices[i], &mem->devices[i+1],
-	    sizeof(struct memory_device) * (mem->n_mmapped_devices - i));
+	if (i != mem->n_mmapped_devices)
+		memmove(&mem->devices[i], &mem->devices[i+1],
+		    sizeof(struct memory_device) * (mem->n_mmapped_devices-i));
 
 	if (i <= mem->last_accessed_device)
 		mem->last_accessed_device --;
 	if (mem->last_accessed_device < 0)
 		mem->last_accessed_device = 0;
+
+	memory_devmap_rebuild(mem);
 }
 
 
@@ -504,6 +759,27 @@ unsigned char *memory_paddr_to_hostaddr(struct memory *mem,
 	table = (void **) mem->pagetable;
 	entry = (paddr >> shrcount) & mask;
 
+	/*  The caller may write anywhere in the page:  */
+	if (writeflag == MEM_WRITE)
+		MEMORY_MARK_DIRTY(mem, paddr);
+
+	/*
+	 *  Contiguous RAM mapping: The pagetable is still used to keep track
+	 *  of which memblocks have been written to, so that reads from
+	 *  never-written memblocks return NULL, just like below.
+	 */
+	if (paddr < mem->contiguous_size) {
+		if (table[entry] == NULL) {
+			if (writeflag == MEM_READ)
+				return NULL;
+
+			table[entry] = mem->contiguous_base +
+			    ((size_t)entry << BITS_PER_MEMBLOCK);
+		}
+
+		return mem->contiguous_base + paddr;
+	}
+
 	/*  printf("memory_paddr_to_hostaddr(): p=%16"PRIx64
 	    " w=%i => entry=0x%x\n", (uint64_t) paddr, writeflag, entry);  */
 
@@ -533,6 +809,10 @@ unsigned char *memory_paddr_to_hostaddr(struct memory *mem,
 			CHECK_ALLOCATION(table[entry] = malloc(alloclen));
 			memset(table[entry], 0, alloclen);
 		}
+#ifdef MADV_MERGEABLE
+		else if (mem->merge_identical_pages)
+			madvise(table[entry], alloclen, MADV_MERGEABLE);
+#endif
 	}
 
 	hostptr = (unsigned char *) table[entry];
@@ -544,13 +824,672 @@ unsigned char *memory_paddr_to_hostaddr(struct memory *mem,
 }
 
 
-#define	UPDATE_CHECKSUM(value) {					\
-		internal_state -= 0x118c7771c0c0a77fULL;		\
-		internal_state = ((internal_state + (value)) << 7) ^	\
-		    (checksum >> 11) ^ ((checksum - (value)) << 3) ^	\
-		    (internal_state - checksum) ^ ((value) - internal_state); \
-		checksum ^= internal_state;				\
+/*  Source of DMA reads from RAM pages which have never been written to.  */
+static unsigned char memory_dma_zeroes[1 << DEVMAP_PAGE_SHIFT];
+
+
+/*
+ *  memory_devmap_lookup():
+ *
+ *  Returns the device map value for the page containing paddr, or 0 if no
+ *  part of the page is covered by a memory mapped device.
+ */
+static size_t memory_devmap_lookup(struct memory *mem, uint64_t paddr)
+{
+	size_t entry = 0, *devmap = mem->devmap;
+	int shift = 64 - DEVMAP_BITS_PER_LEVEL;
+
+	if (paddr < (mem->mmap_dev_minaddr & ~(((uint64_t)1 <<
+	    DEVMAP_PAGE_SHIFT) - 1)) || paddr >= mem->mmap_dev_maxaddr)
+		return 0;
+
+	while (devmap != NULL) {
+		entry = devmap[(paddr >> shift) &
+		    ((1 << DEVMAP_BITS_PER_LEVEL) - 1)];
+		if (entry == 0 || entry & DEVMAP_VALUE)
+			break;
+		devmap = (size_t *) entry;
+		shift -= DEVMAP_BITS_PER_LEVEL;
+	}
+
+	return entry;
+}
+
+
+/*
+ *  memory_dma_device():
+ *
+ *  Returns the device which entirely covers the page of a device map entry,
+ *  if it is plain RAM as far as dyntrans is concerned (e.g. dev_ram) and
+ *  may be accessed directly for writeflag, otherwise NULL.
+ */
+static struct memory_device *memory_dma_device(struct memory *mem,
+	size_t entry, int writeflag)
+{
+	struct memory_device *dev;
+
+	if (entry & (DEVMAP_PARTIAL | DEVMAP_MULTIPLE))
+		return NULL;
+
+	dev = &mem->devices[(entry >> DEVMAP_INDEX_SHIFT) - 1];
+	if (!(dev->flags & DM_DYNTRANS_OK) || dev->flags & DM_EMULATED_RAM ||
+	    !(dev->flags & DM_READS_HAVE_NO_SIDE_EFFECTS) ||
+	    dev->dyntrans_data == NULL)
+		return NULL;
+
+	if (writeflag == MEM_WRITE && !(dev->flags & DM_DYNTRANS_WRITE_OK))
+		return NULL;
+
+	return dev;
+}
+
+
+/*
+ *  memory_dma_device_hostaddr():
+ *
+ *  Returns a host pointer for paddr, if the page containing it may be
+ *  accessed directly (see memory_dma_device()), otherwise NULL. Written
+ *  ranges are recorded in the device's dyntrans_write_low/high, just like
+ *  in memory_rw.
+ */
+static unsigned char *memory_dma_device_hostaddr(struct memory *mem,
+	size_t entry, uint64_t paddr, size_t len, int writeflag)
+{
+	const uint64_t page_mask = ((uint64_t)1 << DEVMAP_PAGE_SHIFT) - 1;
+	struct memory_device *dev = memory_dma_device(mem, entry, writeflag);
+	uint64_t ofs;
+
+	if (dev == NULL)
+		return NULL;
+
+	ofs = paddr - dev->baseaddr;
+
+	if (writeflag == MEM_WRITE) {
+		if (ofs < dev->dyntrans_write_low)
+			dev->dyntrans_write_low = ofs & ~page_mask;
+		if (ofs + len - 1 >= dev->dyntrans_write_high)
+			dev->dyntrans_write_high = (ofs + len - 1) | page_mask;
+	}
+
+	return dev->dyntrans_data + ofs;
+}
+
+
+/*
+ *  memory_dma_map():
+ *
+ *  Resolve the physical address range paddr .. paddr+len-1 into a list of
+ *  at most max_segs segments, for use by DMA capable devices. Each segment
+ *  is either a pointer into emulated RAM (host != NULL), or something else
+ *  (host == NULL), in which case the caller has to fall back to
+ *  cpu->memory_rw() for that part. Devices which are plain RAM from dyntrans'
+ *  point of view, such as dev_ram, are also accessed directly. Segments are
+ *  split at page boundaries where a device is involved, and adjacent pages
+ *  which are also adjacent in host memory are merged into one segment.
+ *
+ *  When writeflag is MEM_WRITE, the RAM pages are marked as dirty, and code
+ *  translations for them are invalidated on all cpus using this memory, so
+ *  the caller may then write through the returned host pointers.
+ *
+ *  Returns the number of segments filled in. If max_segs is too small, the
+ *  segments only cover the first part of the range.
+ */
+int memory_dma_map(struct cpu *cpu, struct memory *mem, uint64_t paddr,
+	size_t len, int writeflag, struct memory_dma_segment *segs,
+	int max_segs)
+{
+	const uint64_t page_mask = ((uint64_t)1 << DEVMAP_PAGE_SHIFT) - 1;
+	struct machine *machine = cpu->machine;
+	int i, n = 0;
+
+	while (len > 0) {
+		size_t chunk = (page_mask + 1) - (paddr & page_mask), entry;
+		unsigned char *host = NULL;
+
+		if (chunk > len)
+			chunk = len;
+
+		entry = memory_devmap_lookup(mem, paddr);
+		if (entry != 0) {
+			host = memory_dma_device_hostaddr(mem, entry, paddr,
+			    chunk, writeflag);
+		} else if (paddr < mem->physical_max) {
+			host = memory_paddr_to_hostaddr(mem, paddr, writeflag);
+
+			/*  Reads from unused RAM return zeroes:  */
+			if (host == NULL)
+				host = memory_dma_zeroes;
+		}
+
+		if (host != NULL && writeflag == MEM_WRITE) {
+			for (i=0; i<machine->ncpus; i++) {
+				struct cpu *c = machine->cpus[i];
+				if (c->mem == mem &&
+				    c->invalidate_code_translation != NULL)
+					c->invalidate_code_translation(c,
+					    paddr, INVALIDATE_PADDR);
+			}
+		}
+
+		if (n > 0 && (host == NULL) == (segs[n-1].host == NULL) &&
+		    (host == NULL || (host != memory_dma_zeroes &&
+		    segs[n-1].host != memory_dma_zeroes &&
+		    host == segs[n-1].host + segs[n-1].len))) {
+			segs[n-1].len += chunk;
+		} else {
+			if (n == max_segs)
+				break;
+			segs[n].host = host;
+			segs[n].paddr = paddr;
+			segs[n].len = chunk;
+			n ++;
+		}
+
+		paddr += chunk;
+		len -= chunk;
+	}
+
+	return n;
+}
+
+
+/*
+ *  memory_dma_is_ram():
+ *
+ *  Returns 1 if all of the physical range paddr .. paddr+len-1 would be
+ *  accessed directly by memory_dma_map() for writeflag, 0 otherwise. Unlike
+ *  memory_dma_map(), this has no side effects; nothing is allocated or
+ *  marked as dirty, and no translations are invalidated.
+ */
+int memory_dma_is_ram(struct memory *mem, uint64_t paddr, uint64_t len,
+	int writeflag)
+{
+	const uint64_t page_mask = ((uint64_t)1 << DEVMAP_PAGE_SHIFT) - 1;
+
+	while (len > 0) {
+		uint64_t chunk = (page_mask + 1) - (paddr & page_mask);
+		size_t entry = memory_devmap_lookup(mem, paddr);
+
+		if (entry != 0) {
+			if (memory_dma_device(mem, entry, writeflag) == NULL)
+				return 0;
+		} else if (paddr >= mem->physical_max)
+			return 0;
+
+		if (chunk > len)
+			chunk = len;
+		paddr += chunk;
+		len -= chunk;
+	}
+
+	return 1;
+}
+
+
+/*
+ *  memory_dma_copy():
+ *
+ *  Copy len bytes between a host buffer and emulated physical memory at
+ *  paddr, on behalf of a DMA capable device. (writeflag is MEM_WRITE when
+ *  data is to be written into emulated memory.) RAM is accessed directly
+ *  via memcpy; anything else, such as other devices, is accessed one byte
+ *  at a time using cpu->memory_rw().
+ */
+void memory_dma_copy(struct cpu *cpu, struct memory *mem, uint64_t paddr,
+	unsigned char *data, size_t len, int writeflag)
+{
+	struct memory_dma_segment segs[MEMORY_DMA_MAX_SEGMENTS];
+	int i, n;
+
+	while (len > 0) {
+		n = memory_dma_map(cpu, mem, paddr, len, writeflag,
+		    segs, MEMORY_DMA_MAX_SEGMENTS);
+
+		for (i=0; i<n; i++) {
+			if (segs[i].host != NULL) {
+				if (writeflag == MEM_WRITE)
+					memcpy(segs[i].host, data, segs[i].len);
+				else
+					memcpy(data, segs[i].host, segs[i].len);
+			} else {
+				size_t j;
+				for (j=0; j<segs[i].len; j++)
+					cpu->memory_rw(cpu, mem,
+					    segs[i].paddr + j, data + j, 1,
+					    writeflag, PHYSICAL | NO_EXCEPTIONS);
+			}
+
+			data += segs[i].len;
+			paddr += segs[i].len;
+			len -= segs[i].len;
+		}
 	}
+}
+
+
+/*
+ *  memory_rw_bulk():
+ *
+ *  Like cpu->memory_rw(), but for buffers of any length and alignment. The
+ *  virtual address is translated once per page, and pages which are plain
+ *  RAM are copied using memcpy. Anything else (devices, failed translations,
+ *  addresses outside of RAM) goes via cpu->memory_rw() for that part of the
+ *  buffer, so exceptions etc. are the same as for a normal access.
+ *
+ *  Unlike cpu->memory_rw(), no entries are added to the dyntrans translation
+ *  tables.
+ *
+ *  Returns MEMORY_ACCESS_OK, or MEMORY_ACCESS_FAILED if any part of the
+ *  access failed. (The parts before the failing page have then already been
+ *  read/written.)
+ */
+int memory_rw_bulk(struct cpu *cpu, struct memory *mem, uint64_t vaddr,
+	unsigned char *data, size_t len, int writeflag, int misc_flags)
+{
+	const uint64_t page_mask = ((uint64_t)1 << DEVMAP_PAGE_SHIFT) - 1;
+	int cache = misc_flags & CACHE_FLAGS_MASK;
+
+	while (len > 0) {
+		size_t chunk = (page_mask + 1) - (vaddr & page_mask);
+		uint64_t paddr = vaddr;
+		unsigned char *host;
+		int ok = 1;
+
+		if (chunk > len)
+			chunk = len;
+
+		if (!(misc_flags & PHYSICAL) && cpu->translate_v2p != NULL)
+			ok = cpu->translate_v2p(cpu, vaddr, &paddr,
+			    (writeflag? FLAG_WRITEFLAG : 0) + FLAG_NOEXCEPTIONS
+			    + (misc_flags & MEMORY_USER_ACCESS)
+			    + (cache==CACHE_INSTRUCTION? FLAG_INSTR : 0));
+
+		if (!ok || paddr >= mem->physical_max ||
+		    memory_devmap_lookup(mem, paddr) != 0) {
+			/*  Not plain RAM; let memory_rw handle it:  */
+			if (!cpu->memory_rw(cpu, mem, vaddr, data, chunk,
+			    writeflag, misc_flags))
+				return MEMORY_ACCESS_FAILED;
+		} else {
+			host = memory_paddr_to_hostaddr(mem, paddr, writeflag);
+
+			if (writeflag == MEM_WRITE) {
+				memcpy(host, data, chunk);
+				if (cpu->invalidate_code_translation != NULL)
+					cpu->invalidate_code_translation(cpu,
+					    paddr, INVALIDATE_PADDR);
+			} else if (host == NULL)
+				memset(data, 0, chunk);
+			else
+				memcpy(data, host, chunk);
+		}
+
+		vaddr += chunk;
+		data += chunk;
+		len -= chunk;
+	}
+
+	return MEMORY_ACCESS_OK;
+}
+
+
+/*
+ *  memory_dirty_client_new():
+ *
+ *  Start tracking dirty pages for a new client, and return the client's
+ *  number, to be used with memory_dirty_fetch_and_clear().
+ *
+ *  Since pages may already be mapped as writable in the dyntrans translation
+ *  tables, all RAM pages which are in use are initially considered dirty
+ *  for the new client.
+ *
+ *  Tracking dirty pages makes the first write to each page after a fetch
+ *  more expensive, so clients should be released with
+ *  memory_dirty_client_free() when they are no longer needed.
+ */
+int memory_dirty_client_new(struct memory *mem)
+{
+	size_t n_pages = (mem->physical_max + (1 << DIRTY_PAGE_SHIFT) - 1)
+	    >> DIRTY_PAGE_SHIFT;
+	size_t n_words = (n_pages + 63) / 64, i;
+	void **table = (void **) mem->pagetable;
+	uint64_t *bitmap;
+	int client;
+
+	CHECK_ALLOCATION(bitmap = (uint64_t *)
+	    malloc(n_words * sizeof(uint64_t)));
+	memset(bitmap, 0, n_words * sizeof(uint64_t));
+
+	for (i=0; i<n_words; i++) {
+		uint64_t paddr = (uint64_t) i << (DIRTY_PAGE_SHIFT + 6);
+		if (table[(paddr >> BITS_PER_MEMBLOCK) &
+		    ((1 << BITS_PER_PAGETABLE) - 1)] != NULL)
+			bitmap[i] = (uint64_t) -1;
+	}
+
+	/*  Reuse the slot of a released client, if there is one:  */
+	for (client=0; client<mem->n_dirty_bitmaps; client++)
+		if (mem->dirty_bitmaps[client] == NULL)
+			break;
+
+	if (client == mem->n_dirty_bitmaps) {
+		CHECK_ALLOCATION(mem->dirty_bitmaps = (uint64_t **) realloc(
+		    mem->dirty_bitmaps, (client + 1) * sizeof(uint64_t *)));
+		mem->n_dirty_bitmaps ++;
+	}
+
+	mem->dirty_bitmaps[client] = bitmap;
+	mem->n_dirty_clients ++;
+
+	return client;
+}
+
+
+/*
+ *  memory_dirty_client_free():
+ *
+ *  Stop tracking dirty pages for a client. When the last client is released,
+ *  RAM pages are again mapped as writable on the first access which allows
+ *  it, just like before any client was registered.
+ */
+void memory_dirty_client_free(struct memory *mem, int client)
+{
+	free(mem->dirty_bitmaps[client]);
+	mem->dirty_bitmaps[client] = NULL;
+	mem->n_dirty_clients --;
+}
+
+
+/*
+ *  memory_dirty_mark():
+ *
+ *  Mark the page containing paddr as dirty, for all clients. (This is usually
+ *  called via the MEMORY_MARK_DIRTY macro, which first checks that there are
+ *  any clients at all.)
+ */
+void memory_dirty_mark(struct memory *mem, uint64_t paddr)
+{
+	uint64_t page = paddr >> DIRTY_PAGE_SHIFT;
+	uint64_t bit = (uint64_t) 1 << (page & 63);
+	int i;
+
+	if (paddr >= mem->physical_max)
+		return;
+
+	for (i=0; i<mem->n_dirty_bitmaps; i++)
+		if (mem->dirty_bitmaps[i] != NULL)
+			mem->dirty_bitmaps[i][page >> 6] |= bit;
+}
+
+
+/*
+ *  memory_dirty_fetch_and_clear():
+ *
+ *  Find the first range of dirty pages for a client, starting the search at
+ *  *paddrp. If one is found, its bits are cleared, *paddrp and *lenp are set
+ *  to the range, and 1 is returned. If there are no more dirty pages, 0 is
+ *  returned.
+ *
+ *  Typical usage:
+ *
+ *	uint64_t paddr = 0, len;
+ *	while (memory_dirty_fetch_and_clear(cpu, mem, client, &paddr, &len)) {
+ *		...
+ *		paddr += len;
+ *	}
+ *
+ *  The cleared pages are marked as non-writable in the translation caches of
+ *  all cpus using this memory, so that the next write to any of them is seen.
+ */
+int memory_dirty_fetch_and_clear(struct cpu *cpu, struct memory *mem,
+	int client, uint64_t *paddrp, uint64_t *lenp)
+{
+	uint64_t *bitmap = mem->dirty_bitmaps[client];
+	uint64_t n_pages = (mem->physical_max + (1 << DIRTY_PAGE_SHIFT) - 1)
+	    >> DIRTY_PAGE_SHIFT;
+	uint64_t page = *paddrp >> DIRTY_PAGE_SHIFT, first, p;
+	struct machine *machine = cpu->machine;
+	int i;
+
+	/*  Skip clean pages, a whole word at a time when possible:  */
+	while (page < n_pages) {
+		if (bitmap[page >> 6] == 0) {
+			page = (page | 63) + 1;
+			continue;
+		}
+		if (bitmap[page >> 6] & ((uint64_t) 1 << (page & 63)))
+			break;
+		page ++;
+	}
+
+	if (page >= n_pages)
+		return 0;
+
+	first = page;
+	while (page < n_pages &&
+	    bitmap[page >> 6] & ((uint64_t) 1 << (page & 63))) {
+		bitmap[page >> 6] &= ~((uint64_t) 1 << (page & 63));
+		page ++;
+	}
+
+	for (i=0; i<machine->ncpus; i++) {
+		struct cpu *c = machine->cpus[i];
+		if (c->mem != mem || c->invalidate_translation_caches == NULL)
+			continue;
+		for (p=first; p<page; p++) {
+			uint64_t paddr = p << DIRTY_PAGE_SHIFT;
+			int d;
+
+			c->invalidate_translation_caches(c, paddr,
+			    JUST_MARK_AS_NON_WRITABLE | INVALIDATE_PADDR);
+
+			/*  Translations of the page via RAM mirrors are
+			    keyed by the mirror's address, not by paddr:  */
+			for (d=0; d<mem->n_mmapped_devices; d++) {
+				struct memory_device *dev = &mem->devices[d];
+				uint64_t alias;
+
+				if (!(dev->flags & DM_EMULATED_RAM))
+					continue;
+
+				alias = paddr + *(uint64_t *)dev->dyntrans_data;
+				if (alias >= dev->baseaddr &&
+				    alias < dev->endaddr)
+					c->invalidate_translation_caches(c,
+					    alias, JUST_MARK_AS_NON_WRITABLE |
+					    INVALIDATE_PADDR);
+			}
+		}
+	}
+
+	*paddrp = first << DIRTY_PAGE_SHIFT;
+	*lenp = (page - first) << DIRTY_PAGE_SHIFT;
+	return 1;
+}
+
+
+/*
+ *  Incremental memory checksums:
+ *
+ *  A 64-bit hash is calculated for each 4 KB page of physical RAM, and kept
+ *  in the lowest level of a hash tree (mem->hash_tree). Each node in the
+ *  levels above it is a hash of up to HASH_TREE_FANOUT nodes in the level
+ *  below, and the single node in the top level is the checksum of the whole
+ *  memory. A dirty page tracking client is used to find out which pages
+ *  need to be rehashed, so only pages written to since the last call cost
+ *  anything.
+ *
+ *  The tree can be saved as a checkpoint, and two checkpoints can then be
+ *  compared quickly by only descending into subtrees which differ.
+ */
+#define	HASH_TREE_FANOUT_SHIFT	6
+#define	HASH_TREE_FANOUT	(1 << HASH_TREE_FANOUT_SHIFT)
+#define	HASH_TREE_MAX_LEVELS	12
+#define	HASH_LANES		8
+
+
+/*
+ *  memory_hash_mix():
+ *
+ *  Final mixing of a 64-bit value (from MurmurHash3's fmix64).
+ */
+static uint64_t memory_hash_mix(uint64_t x)
+{
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+	return x;
+}
+
+
+/*
+ *  memory_hash_page():
+ *
+ *  Hash one page of host memory. The page is processed as HASH_LANES
+ *  independent multiply-xor lanes, which the compiler can keep in vector
+ *  registers, and the lanes are combined at the end. A NULL page (never
+ *  written to) is hashed as a page of zeroes.
+ */
+static uint64_t memory_hash_page(const unsigned char *page)
+{
+	static const uint64_t zeroes[(1 << DIRTY_PAGE_SHIFT) /
+	    sizeof(uint64_t)] = { 0 };
+	const uint64_t *p = page != NULL? (const uint64_t *) page : zeroes;
+	const size_t n = (1 << DIRTY_PAGE_SHIFT) / sizeof(uint64_t);
+	uint64_t lane[HASH_LANES], h = 0x80624185376feff2ULL;
+	size_t i, j;
+
+	for (j=0; j<HASH_LANES; j++)
+		lane[j] = 0xcb9a87d5c010072cULL + j;
+
+	for (i=0; i<n; i+=HASH_LANES)
+		for (j=0; j<HASH_LANES; j++) {
+			uint64_t x = (lane[j] ^ p[i+j]) * 0x9e3779b97f4a7c15ULL;
+			lane[j] = x ^ (x >> 29);
+		}
+
+	for (j=0; j<HASH_LANES; j++)
+		h = memory_hash_mix(h ^ lane[j]);
+
+	return h;
+}
+
+
+/*
+ *  memory_hash_tree_layout():
+ *
+ *  Calculate the offset and length of each level of the hash tree, for a
+ *  memory object. Returns the number of levels.
+ */
+static int memory_hash_tree_layout(struct memory *mem, size_t *ofs,
+	size_t *len)
+{
+	size_t n = (mem->physical_max + (1 << DIRTY_PAGE_SHIFT) - 1)
+	    >> DIRTY_PAGE_SHIFT, total = 0;
+	int levels = 0;
+
+	if (n == 0)
+		n = 1;
+
+	for (;;) {
+		ofs[levels] = total;
+		len[levels] = n;
+		total += n;
+		levels ++;
+
+		if (n == 1 || levels == HASH_TREE_MAX_LEVELS)
+			break;
+
+		n = (n + HASH_TREE_FANOUT - 1) >> HASH_TREE_FANOUT_SHIFT;
+	}
+
+	ofs[levels] = total;
+	return levels;
+}
+
+
+/*
+ *  memory_hash_tree_update():
+ *
+ *  Rehash pages first..last (inclusive), and the tree nodes above them.
+ */
+static void memory_hash_tree_update(struct memory *mem, size_t first,
+	size_t last)
+{
+	size_t ofs[HASH_TREE_MAX_LEVELS + 1], len[HASH_TREE_MAX_LEVELS + 1];
+	int levels = memory_hash_tree_layout(mem, ofs, len), level;
+	uint64_t *tree = mem->hash_tree;
+	size_t i, j;
+
+	if (last >= len[0])
+		last = len[0] - 1;
+
+	for (i=first; i<=last; i++)
+		tree[i] = memory_hash_page(memory_paddr_to_hostaddr(mem,
+		    (uint64_t) i << DIRTY_PAGE_SHIFT, MEM_READ));
+
+	mem->n_pages_hashed += last + 1 - first;
+
+	for (level=1; level<levels; level++) {
+		first >>= HASH_TREE_FANOUT_SHIFT;
+		last >>= HASH_TREE_FANOUT_SHIFT;
+
+		for (i=first; i<=last; i++) {
+			uint64_t *child = tree + ofs[level-1] +
+			    (i << HASH_TREE_FANOUT_SHIFT);
+			size_t n = len[level-1] - (i << HASH_TREE_FANOUT_SHIFT);
+			uint64_t h = level;
+
+			if (n > HASH_TREE_FANOUT)
+				n = HASH_TREE_FANOUT;
+
+			for (j=0; j<n; j++)
+				h = memory_hash_mix(h ^ child[j]) + j;
+
+			tree[ofs[level] + i] = h;
+		}
+	}
+}
+
+
+/*
+ *  memory_hash_tree_refresh():
+ *
+ *  Bring the hash tree up to date. If no dirty page tracking client is
+ *  registered for the tree, one is registered and all RAM is hashed.
+ *  Otherwise, only the pages written to since the last refresh are rehashed.
+ */
+static void memory_hash_tree_refresh(struct cpu *cpu, struct memory *mem)
+{
+	size_t ofs[HASH_TREE_MAX_LEVELS + 1], len[HASH_TREE_MAX_LEVELS + 1];
+	int levels = memory_hash_tree_layout(mem, ofs, len);
+	uint64_t paddr = 0, dirty_len;
+
+	if (mem->hash_tree == NULL)
+		CHECK_ALLOCATION(mem->hash_tree = (uint64_t *)
+		    malloc(ofs[levels] * sizeof(uint64_t)));
+
+	if (mem->hash_tree_client < 0) {
+		mem->hash_tree_client = memory_dirty_client_new(mem);
+
+		/*  Everything is dirty; clear it, and hash everything once:  */
+		while (memory_dirty_fetch_and_clear(cpu, mem,
+		    mem->hash_tree_client, &paddr, &dirty_len))
+			paddr += dirty_len;
+
+		memory_hash_tree_update(mem, 0, len[0] - 1);
+		return;
+	}
+
+	while (memory_dirty_fetch_and_clear(cpu, mem, mem->hash_tree_client,
+	    &paddr, &dirty_len)) {
+		memory_hash_tree_update(mem, paddr >> DIRTY_PAGE_SHIFT,
+		    ((paddr + dirty_len) >> DIRTY_PAGE_SHIFT) - 1);
+		paddr += dirty_len;
+	}
+}
 
 
 /*
@@ -559,29 +1498,181 @@ unsigned char *memory_paddr_to_hostaddr(struct memory *mem,
  *  Calculate a 64-bit checksum of everything in a struct memory. This is
  *  useful for tracking down bugs; an old (presumably working) version of
  *  the emulator can be compared to a newer (buggy) version.
+ *
+ *  While tracking is enabled (see memory_checksum_tracking()), or while
+ *  there are saved checkpoints, the hash tree is kept up to date
+ *  incrementally, and a call only rehashes the pages which have been written
+ *  to since the previous call. Otherwise, all RAM is hashed, and dirty page
+ *  tracking is not left enabled afterwards.
  */
-uint64_t memory_checksum(struct memory *mem)
+uint64_t memory_checksum(struct cpu *cpu, struct memory *mem)
 {
-	uint64_t internal_state = 0x80624185376feff2ULL;
-	uint64_t checksum = 0xcb9a87d5c010072cULL;
-	const size_t n_entries = (1 << BITS_PER_PAGETABLE) - 1;
-	const size_t len = (1 << BITS_PER_MEMBLOCK) / sizeof(uint64_t);
-	size_t entry, i;
+	size_t ofs[HASH_TREE_MAX_LEVELS + 1], len[HASH_TREE_MAX_LEVELS + 1];
+	int levels = memory_hash_tree_layout(mem, ofs, len);
+	uint64_t checksum;
 
-	for (entry=0; entry<=n_entries; entry++) {
-		uint64_t **table = (uint64_t **) mem->pagetable;
-		uint64_t *memblock = table[entry];
+	memory_hash_tree_refresh(cpu, mem);
+	checksum = mem->hash_tree[ofs[levels - 1]];
 
-		if (memblock == NULL) {
-			UPDATE_CHECKSUM(0x1198ab7c8174a76fULL);
-			continue;
+	if (!mem->hash_tree_tracking && mem->n_checkpoints == 0) {
+		memory_dirty_client_free(mem, mem->hash_tree_client);
+		mem->hash_tree_client = -1;
+	}
+
+	return checksum;
+}
+
+
+/*
+ *  memory_checksum_tracking():
+ *
+ *  Turn incremental checksums on or off. While on, the hash tree and its
+ *  dirty page tracking client are kept between calls to memory_checksum(),
+ *  which is useful when checksums are calculated often. (Dirty page
+ *  tracking makes writes to RAM somewhat slower, though.)
+ */
+void memory_checksum_tracking(struct cpu *cpu, struct memory *mem, int on)
+{
+	mem->hash_tree_tracking = on;
+
+	if (on)
+		memory_hash_tree_refresh(cpu, mem);
+	else if (mem->n_checkpoints == 0 && mem->hash_tree_client >= 0) {
+		memory_dirty_client_free(mem, mem->hash_tree_client);
+		mem->hash_tree_client = -1;
+	}
+}
+
+
+/*
+ *  memory_checkpoint():
+ *
+ *  Save the current hash tree as a checkpoint, which can later be compared
+ *  to other checkpoints using memory_checkpoint_diff(). Returns the
+ *  checkpoint number.
+ */
+int memory_checkpoint(struct cpu *cpu, struct memory *mem)
+{
+	size_t ofs[HASH_TREE_MAX_LEVELS + 1], len[HASH_TREE_MAX_LEVELS + 1];
+	int levels = memory_hash_tree_layout(mem, ofs, len);
+	int n = mem->n_checkpoints;
+
+	memory_hash_tree_refresh(cpu, mem);
+
+	CHECK_ALLOCATION(mem->checkpoints = (uint64_t **) realloc(
+	    mem->checkpoints, (n + 1) * sizeof(uint64_t *)));
+	CHECK_ALLOCATION(mem->checkpoints[n] = (uint64_t *)
+	    malloc(ofs[levels] * sizeof(uint64_t)));
+	memcpy(mem->checkpoints[n], mem->hash_tree,
+	    ofs[levels] * sizeof(uint64_t));
+
+	mem->n_checkpoints ++;
+	return n;
+}
+
+
+/*
+ *  memory_checkpoint_diff_node():
+ *
+ *  Helper for memory_checkpoint_diff(). Finds differing pages below node i
+ *  at a specific level, and prints them as ranges. *startp is the first
+ *  page of the current range of differing pages (or -1 if there is none),
+ *  and *nextp is the page following the last page of that range.
+ */
+static void memory_checkpoint_diff_node(uint64_t *a, uint64_t *b,
+	size_t *ofs, size_t *len, int level, size_t i, int64_t *startp,
+	int64_t *nextp)
+{
+	size_t j, n;
+
+	if (a[ofs[level] + i] == b[ofs[level] + i])
+		return;
+
+	if (level == 0) {
+		if (*startp >= 0 && *nextp == (int64_t) i) {
+			(*nextp) ++;
+			return;
 		}
 
-		for (i=0; i<len; i++)
-			UPDATE_CHECKSUM(memblock[i]);
+		if (*startp >= 0)
+			printf("  0x%010" PRIx64 " .. 0x%010" PRIx64 "\n",
+			    (uint64_t) *startp << DIRTY_PAGE_SHIFT,
+			    ((uint64_t) *nextp << DIRTY_PAGE_SHIFT) - 1);
+
+		*startp = i;
+		*nextp = i + 1;
+		return;
 	}
 
-	return checksum;
+	n = len[level-1] - (i << HASH_TREE_FANOUT_SHIFT);
+	if (n > HASH_TREE_FANOUT)
+		n = HASH_TREE_FANOUT;
+
+	for (j=0; j<n; j++)
+		memory_checkpoint_diff_node(a, b, ofs, len, level - 1,
+		    (i << HASH_TREE_FANOUT_SHIFT) + j, startp, nextp);
+}
+
+
+/*
+ *  memory_checkpoint_diff():
+ *
+ *  Print the physical address ranges which differ between two checkpoints.
+ *  If checkpoint b is -1, checkpoint a is compared to the current contents
+ *  of the memory.
+ */
+void memory_checkpoint_diff(struct cpu *cpu, struct memory *mem, int a, int b)
+{
+	size_t ofs[HASH_TREE_MAX_LEVELS + 1], len[HASH_TREE_MAX_LEVELS + 1];
+	int levels = memory_hash_tree_layout(mem, ofs, len);
+	int64_t start = -1, next = -1;
+	uint64_t *tree_b;
+
+	if (a < 0 || a >= mem->n_checkpoints || b < -1 ||
+	    b >= mem->n_checkpoints) {
+		printf("No such checkpoint.\n");
+		return;
+	}
+
+	if (b == -1) {
+		memory_hash_tree_refresh(cpu, mem);
+		tree_b = mem->hash_tree;
+	} else
+		tree_b = mem->checkpoints[b];
+
+	memory_checkpoint_diff_node(mem->checkpoints[a], tree_b, ofs, len,
+	    levels - 1, 0, &start, &next);
+
+	if (start >= 0)
+		printf("  0x%010" PRIx64 " .. 0x%010" PRIx64 "\n",
+		    (uint64_t) start << DIRTY_PAGE_SHIFT,
+		    ((uint64_t) next << DIRTY_PAGE_SHIFT) - 1);
+	else
+		printf("  (no differences)\n");
+}
+
+
+/*
+ *  memory_checkpoints_clear():
+ *
+ *  Forget all saved checkpoints, and stop keeping the hash tree up to date
+ *  (unless tracking has been turned on using memory_checksum_tracking()).
+ */
+void memory_checkpoints_clear(struct memory *mem)
+{
+	int i;
+
+	for (i=0; i<mem->n_checkpoints; i++)
+		free(mem->checkpoints[i]);
+
+	free(mem->checkpoints);
+	mem->checkpoints = NULL;
+	mem->n_checkpoints = 0;
+
+	if (!mem->hash_tree_tracking && mem->hash_tree_client >= 0) {
+		memory_dirty_client_free(mem, mem->hash_tree_client);
+		mem->hash_tree_client = -1;
+	}
 }
 
 
@@ -825,24 +1916,8 @@ int store_16bit_word(struct cpu *cpu, uint64_t addr, uint64_t data16)
  */
 void store_buf(struct cpu *cpu, uint64_t addr, const char *s, size_t len)
 {
-	size_t psize = 1024;	/*  1024 256 64 16 4 1  */
-
-	while (len != 0) {
-		if ((addr & (psize-1)) == 0) {
-			while (len >= psize) {
-				cpu->memory_rw(cpu, cpu->mem, addr,
-				    (unsigned char *)s, psize, MEM_WRITE,
-				    CACHE_DATA);
-				addr += psize;
-				s += psize;
-				len -= psize;
-			}
-		}
-		psize >>= 2;
-	}
-
-	while (len-- != 0)
-		store_byte(cpu, addr++, *s++);
+	memory_rw_bulk(cpu, cpu->mem, addr, (unsigned char *)s, len,
+	    MEM_WRITE, CACHE_DATA);
 }
 
 
@@ -998,3 +2073,227 @@ void store_16bit_word_in_host(struct cpu *cpu,
 		int tmp = data[0]; data[0] = data[1]; data[1] = tmp;
 	}
 }
+
+
+/*****************************************************************************/
+
+
+#ifdef WITHUNITTESTS
+
+#include "devices.h"
+#include "emul.h"
+#include "UnitTest.h"
+
+extern int quiet_mode;
+
+/*  A mirror of the first MB of RAM, like on e.g. the cats machine:  */
+#define	TEST_MIRROR_BASE	0x40000000
+
+/*
+ *  memory_test_setup():
+ *
+ *  Create a minimal ARM machine with 4 MB of RAM and a RAM mirror, without
+ *  loading anything into it. Returns the machine's only cpu.
+ *
+ *  (Machines are never destroyed, since interrupt handlers registered by
+ *  the cpus would otherwise clash with those of the next test's machine.)
+ */
+static struct cpu *memory_test_setup()
+{
+	static struct emul *emul = NULL;
+	struct machine *m;
+	int old_quiet_mode = quiet_mode;
+
+	if (emul == NULL)
+		emul = emul_new(NULL);
+
+	m = emul_add_machine(emul, NULL);
+
+	quiet_mode = 1;
+	m->arch = ARCH_ARM;
+	m->physical_ram_in_mb = 4;
+	m->memory = memory_new(4 * 1048576, m->arch);
+
+	m->ncpus = 1;
+	CHECK_ALLOCATION(m->cpus = (struct cpu **)
+	    malloc(sizeof(struct cpu *)));
+	m->cpus[0] = cpu_new(m->memory, m, 0, (char *) "SA110");
+
+	dev_ram_init(m, TEST_MIRROR_BASE, 1048576, DEV_RAM_MIRROR, 0,
+	    "test_mirror");
+	quiet_mode = old_quiet_mode;
+
+	return m->cpus[0];
+}
+
+static void memory_test_write(struct cpu *cpu, uint64_t paddr, uint32_t x)
+{
+	unsigned char buf[4];
+	store_32bit_word_in_host(cpu, buf, x);
+	cpu->memory_rw(cpu, cpu->mem, paddr, buf, sizeof(buf), MEM_WRITE,
+	    CACHE_DATA | PHYSICAL);
+}
+
+static bool memory_test_contains(struct cpu *cpu, uint64_t paddr, uint32_t x)
+{
+	unsigned char buf[4], expected[4];
+	store_32bit_word_in_host(cpu, expected, x);
+	cpu->memory_rw(cpu, cpu->mem, paddr, buf, sizeof(buf), MEM_READ,
+	    CACHE_DATA | PHYSICAL);
+	return memcmp(buf, expected, sizeof(buf)) == 0;
+}
+
+static unsigned char *memory_test_host_store(struct cpu *cpu, uint64_t vaddr)
+{
+	return VPH32_HOST_STORE(cpu->cd.arm.l1_32, vaddr >> 12);
+}
+
+/*  Store a word the way emulated instructions do:  */
+static void memory_test_store(struct cpu *cpu, uint64_t vaddr, uint32_t x)
+{
+	unsigned char *host = memory_test_host_store(cpu, vaddr);
+
+	if (host != NULL)
+		store_32bit_word_in_host(cpu, host + (vaddr & 0xfff), x);
+	else
+		memory_test_write(cpu, vaddr, x);
+}
+
+static void Test_memory_DirtyPages_WriteThroughMirror()
+{
+	struct cpu *cpu = memory_test_setup();
+	struct memory *mem = cpu->mem;
+	uint64_t paddr = 0, len;
+	int client;
+
+	/*  Without dirty tracking, mirror pages are mapped as writable:  */
+	memory_test_write(cpu, TEST_MIRROR_BASE + 0x1000, 0x11223344);
+	UnitTest::Assert("mirror page should be writable",
+	    memory_test_host_store(cpu, TEST_MIRROR_BASE + 0x1000) != NULL);
+
+	client = memory_dirty_client_new(mem);
+	while (memory_dirty_fetch_and_clear(cpu, mem, client, &paddr, &len))
+		paddr += len;
+
+	UnitTest::Assert("mirror page should no longer be writable",
+	    memory_test_host_store(cpu, TEST_MIRROR_BASE + 0x1000) == NULL);
+
+	/*  A write through the mirror must show up as a dirty RAM page:  */
+	memory_test_write(cpu, TEST_MIRROR_BASE + 0x1008, 0x55667788);
+	UnitTest::Assert("mirror page should still not be writable",
+	    memory_test_host_store(cpu, TEST_MIRROR_BASE + 0x1000) == NULL);
+
+	paddr = 0;
+	UnitTest::Assert("the page should be dirty",
+	    memory_dirty_fetch_and_clear(cpu, mem, client, &paddr, &len) == 1);
+	UnitTest::Assert("wrong dirty page", paddr, 0x1000);
+	UnitTest::Assert("wrong dirty length", len, 0x1000);
+
+	paddr += len;
+	UnitTest::Assert("no other pages should be dirty",
+	    memory_dirty_fetch_and_clear(cpu, mem, client, &paddr, &len) == 0);
+
+	UnitTest::Assert("the write should have reached RAM",
+	    memory_test_contains(cpu, 0x1008, 0x55667788));
+}
+
+static void Test_memory_Checksum_WriteThroughMirror()
+{
+	struct cpu *cpu = memory_test_setup();
+	struct memory *mem = cpu->mem;
+	uint64_t h1, h2;
+
+	memory_test_store(cpu, TEST_MIRROR_BASE + 0x2000, 0x12345678);
+
+	memory_checkpoint(cpu, mem);
+	UnitTest::Assert("checkpoints should keep the hash tree up to date",
+	    mem->n_dirty_clients, 1);
+
+	h1 = memory_checksum(cpu, mem);
+	memory_test_store(cpu, TEST_MIRROR_BASE + 0x2004, 0x9abcdef0);
+	h2 = memory_checksum(cpu, mem);
+	UnitTest::Assert("the write through the mirror was missed", h1 != h2);
+
+	memory_checkpoints_clear(mem);
+	UnitTest::Assert("dirty page tracking should have been stopped",
+	    mem->n_dirty_clients, 0);
+
+	UnitTest::Assert("a full rehash should give the same checksum",
+	    memory_checksum(cpu, mem), h2);
+	UnitTest::Assert("checksums without checkpoints should not leave"
+	    " dirty page tracking enabled", mem->n_dirty_clients, 0);
+}
+
+static void Test_memory_Checksum_Tracking()
+{
+	struct cpu *cpu = memory_test_setup();
+	struct memory *mem = cpu->mem;
+	uint64_t h1, h2;
+
+	memory_checksum_tracking(cpu, mem, 1);
+	h1 = memory_checksum(cpu, mem);
+	UnitTest::Assert("tracking should survive a checksum",
+	    mem->n_dirty_clients, 1);
+
+	/*  Two words on the same page, and one on another page:  */
+	mem->n_pages_hashed = 0;
+	memory_test_store(cpu, 0x5000, 0x12345678);
+	memory_test_store(cpu, 0x5ff0, 0x9abcdef0);
+	memory_test_store(cpu, 0x123000, 0x11111111);
+	h2 = memory_checksum(cpu, mem);
+
+	UnitTest::Assert("the checksum should have changed", h1 != h2);
+	UnitTest::Assert("only the written pages should be rehashed",
+	    mem->n_pages_hashed, 2);
+
+	mem->n_pages_hashed = 0;
+	UnitTest::Assert("nothing written, same checksum",
+	    memory_checksum(cpu, mem), h2);
+	UnitTest::Assert("nothing should be rehashed", mem->n_pages_hashed, 0);
+
+	memory_checkpoint(cpu, mem);
+	memory_checkpoints_clear(mem);
+	UnitTest::Assert("clearing checkpoints should not stop tracking",
+	    mem->n_dirty_clients, 1);
+
+	memory_checksum_tracking(cpu, mem, 0);
+	UnitTest::Assert("tracking should have been stopped",
+	    mem->n_dirty_clients, 0);
+	UnitTest::Assert("a full rehash should give the same checksum",
+	    memory_checksum(cpu, mem), h2);
+}
+
+static void Test_memory_DmaIsRam_HasNoSideEffects()
+{
+	struct cpu *cpu = memory_test_setup();
+	struct memory *mem = cpu->mem;
+	uint64_t paddr = 0, len;
+	int client = memory_dirty_client_new(mem);
+
+	while (memory_dirty_fetch_and_clear(cpu, mem, client, &paddr, &len))
+		paddr += len;
+
+	UnitTest::Assert("RAM should be RAM",
+	    memory_dma_is_ram(mem, 0x3000, 0x5000, MEM_WRITE), 1);
+	UnitTest::Assert("mirrors are not accessed directly",
+	    memory_dma_is_ram(mem, TEST_MIRROR_BASE, 0x1000, MEM_READ), 0);
+	UnitTest::Assert("the range goes past the end of RAM",
+	    memory_dma_is_ram(mem, 0x3ff000, 0x2000, MEM_READ), 0);
+
+	paddr = 0;
+	UnitTest::Assert("probing should not mark pages as dirty",
+	    memory_dirty_fetch_and_clear(cpu, mem, client, &paddr, &len), 0);
+
+	memory_dirty_client_free(mem, client);
+}
+
+UNITTESTS(memory)
+{
+	UNITTEST(Test_memory_DirtyPages_WriteThroughMirror);
+	UNITTEST(Test_memory_Checksum_WriteThroughMirror);
+	UNITTEST(Test_memory_Checksum_Tracking);
+	UNITTEST(Test_memory_DmaIsRam_HasNoSideEffects);
+}
+
+#endif	// WITHUNITTESTS
+